@@ -1,112 +1,668 @@
-#include "stm32f10x.h"
-#include "ds18b20.h"
-#include "delay.h"
-
-#define DelayMs(x) delay_ms(x)
-
-
-#define	in  1
-#define out 0
-
-GPIO_InitTypeDef GPIO_InitStructure;
-
-
-
-void DelayUs(u32 t)
-{
-    t*=16;
-    while(t--);
-}
-
-void TRIS_PIN(char x)
-{
-    GPIO_InitStructure.GPIO_Pin = (1<<DQ_PIN);
-    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-    if(!x)
-    {
-        GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_OD; 		//Output
-    }
-    else
-    {
-        GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
-    }
-    GPIO_Init(DQ_GPIO, &GPIO_InitStructure);
-}
-
-void onewire_reset(void)
-{
-    TRIS_PIN(out);
-    DQ_PIN_WRITE(0)
-    DelayUs(480);
-    TRIS_PIN(in);
-    DelayUs(400);
-    TRIS_PIN(out);
-}
-
-void onewire_write(char data)
-{
-    unsigned char i, bitshifter;
-    bitshifter = 1;
-    for (i=0; i<8; i++)
-    {
-        if (data & bitshifter)
-        {
-            TRIS_PIN(out);
-            DQ_PIN_WRITE(0)
-            DelayUs(3);
-            TRIS_PIN(in);
-            DelayUs(60);
-        }
-        else
-        {
-            TRIS_PIN(out);
-            DQ_PIN_WRITE(0)
-            DelayUs(60);
-            TRIS_PIN(in);
-        }
-        bitshifter = bitshifter<<1;
-    }
-}
-
-unsigned char onewire_read( void )
-{
-    unsigned char i;
-    unsigned char data, bitshifter;
-    data = 0;
-    bitshifter = 1;
-    for (i=0; i<8; i++)
-    {
-        TRIS_PIN(out);
-        DQ_PIN_WRITE(0)
-        DelayUs(6);
-        TRIS_PIN(in);
-        DelayUs(4);
-        if (DQ_PIN_READ)
-            data |= bitshifter;
-        DelayUs(50);
-        bitshifter = bitshifter<<1;
-    }
-    return data;
-}
-
-float ds18b20_read(void)
-{
-    int busy;
-    int sayi1;
-    int sayi2;
-    float result;
-    onewire_reset();
-    onewire_write(0xCC);
-    onewire_write(0x44);
-    while(busy==0)
-        busy=onewire_read();
-    onewire_reset();
-    onewire_write(0xCC);
-    onewire_write(0xBE);
-    sayi1 = onewire_read();
-    sayi2 = onewire_read();
-    result=sayi2*256+sayi1;
-    result=result/16.0;
-    DelayMs(250);
-    return result;
-}
+#include "stm32f10x.h"
+#include "ds18b20.h"
+
+// Timer that runs the 1-Wire slots of the asynchronous driver, see
+// ds18b20_init. Free running at 1 MHz, channel 1 compare interrupts
+// schedule every edge of a slot.
+#ifndef OW_TIM
+#define OW_TIM              TIM2
+#define OW_TIM_RCC          RCC_APB1Periph_TIM2
+#define OW_TIM_IRQn         TIM2_IRQn
+#define OW_TIM_IRQHandler   TIM2_IRQHandler
+#endif
+
+
+#define	in  1
+#define out 0
+
+// Open drain pin, released it floats high and reads the bus
+#define OW_PIN_LOW      (DQ_GPIO->BRR = (1 << DQ_PIN))
+#define OW_PIN_RELEASE  (DQ_GPIO->BSRR = (1 << DQ_PIN))
+#define OW_PIN_SAMPLE   ((DQ_GPIO->IDR >> DQ_PIN) & 1)
+
+// Mode and configuration nibble of DQ_PIN in CRL or CRH
+#define OW_PIN_CR       (*((DQ_PIN) < 8 ? &DQ_GPIO->CRL : &DQ_GPIO->CRH))
+#define OW_PIN_SHIFT    (((DQ_PIN) & 7) * 4)
+#define OW_CR_OUT_OD    0x7     // output open drain, 50 MHz
+#define OW_CR_IN        0x4     // input floating
+
+// Cycle counter of the Cortex-M3 DWT unit, which the CMSIS core header of
+// StdPeriph does not declare
+#ifndef DWT_CYCCNT
+#define DWT_CTRL        (*(volatile u32 *)0xE0001000)
+#define DWT_CYCCNT      (*(volatile u32 *)0xE0001004)
+#endif
+#define DWT_CYCCNTENA   (1u << 0)
+
+// Busy wait of t microseconds on the cycle counter, exact at any
+// SystemCoreClock, interrupts that run meanwhile count towards it
+void DelayUs(u32 t)
+{
+    u32 start, cycles;
+    if (!(DWT_CTRL & DWT_CYCCNTENA))
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT_CTRL |= DWT_CYCCNTENA;
+    }
+    start = DWT_CYCCNT;
+    cycles = t * (SystemCoreClock / 1000000);
+    while (DWT_CYCCNT - start < cycles);
+}
+
+// Direction of the pin with one write of its configuration register
+void TRIS_PIN(char x)
+{
+    u32 cr = OW_PIN_CR & ~(0xFu << OW_PIN_SHIFT);
+    OW_PIN_CR = cr | ((u32)(x ? OW_CR_IN : OW_CR_OUT_OD) << OW_PIN_SHIFT);
+}
+
+/*
+ * Blocking 1-Wire
+ *
+ * The pin stays open drain, pulled low through BRR and released through
+ * BSRR, so a slot changes no direction. Timings are the standard speed
+ * values of Maxim application note 126. Interrupts that run during a slot
+ * still stretch it, see the asynchronous driver below.
+ */
+
+void onewire_reset(void)
+{
+    OW_PIN_RELEASE;
+    TRIS_PIN(out);
+    OW_PIN_LOW;
+    DelayUs(480);
+    OW_PIN_RELEASE;
+    DelayUs(480);
+}
+
+void onewire_write(char data)
+{
+    unsigned char i, bitshifter;
+    bitshifter = 1;
+    TRIS_PIN(out);
+    for (i=0; i<8; i++)
+    {
+        OW_PIN_LOW;
+        if (data & bitshifter)
+        {
+            DelayUs(6);
+            OW_PIN_RELEASE;
+            DelayUs(64);
+        }
+        else
+        {
+            DelayUs(60);
+            OW_PIN_RELEASE;
+            DelayUs(10);
+        }
+        bitshifter = bitshifter<<1;
+    }
+}
+
+unsigned char onewire_read( void )
+{
+    unsigned char i;
+    unsigned char data, bitshifter;
+    data = 0;
+    bitshifter = 1;
+    TRIS_PIN(out);
+    for (i=0; i<8; i++)
+    {
+        OW_PIN_LOW;
+        DelayUs(6);
+        OW_PIN_RELEASE;
+        DelayUs(9);
+        if (OW_PIN_SAMPLE)
+            data |= bitshifter;
+        DelayUs(55);
+        bitshifter = bitshifter<<1;
+    }
+    return data;
+}
+
+/*
+ * Asynchronous 1-Wire
+ *
+ * A transaction is an optional reset, bits to write and bits to read, whole
+ * bytes for everything but the steps of the ROM search, least significant
+ * bit first.
+ * ow_start hands it to the compare interrupt of OW_TIM, which drives every
+ * slot edge by edge and returns in between, so the slot timing costs the
+ * main loop nothing. Edges are scheduled from the time the previous edge
+ * was due, not from when the interrupt ran, so latency does not add up.
+ * The pin is open drain, released it reads the bus, so it never changes
+ * direction.
+ *
+ * Timings are the standard speed values of Maxim application note 126.
+ */
+
+#define OW_MAX_TX   12
+#define OW_MAX_RX   9
+
+enum ow_phase
+{
+    OW_IDLE,
+    OW_RESET_LOW,       // bus held low for 480 us
+    OW_RESET_RELEASE,   // released, presence pulse sampled after 70 us
+    OW_RESET_RECOVER,   // rest of the 410 us presence window
+    OW_SLOT_LOW,        // start of a write or read slot
+    OW_SLOT_RELEASE,    // released after 6 us for a 1 or a read, 60 us for a 0
+    OW_SLOT_SAMPLE,     // read slots, bus sampled 15 us into the slot
+    OW_SLOT_END         // end of the slot and its recovery time
+};
+
+static volatile struct
+{
+    enum ow_phase phase;
+    u16 edge;               // timer count the current edge was due at
+    u8 tx[OW_MAX_TX];
+    u8 txBits;
+    volatile u8 *rx;        // written by the interrupt, read by the main loop
+    u8 rxBits;
+    u8 pos;                 // bit of the transaction, writes first
+    u8 presence;            // a device answered the last reset
+    u8 done;
+} ow;
+
+// Next edge _us after the previous one. An edge that is already late, after
+// a long interrupt of higher priority, is run right away.
+static void ow_schedule(enum ow_phase _phase, u16 _us)
+{
+    ow.phase = _phase;
+    ow.edge += _us;
+    OW_TIM->CCR1 = ow.edge;
+    if ((u16)(ow.edge - OW_TIM->CNT) > _us)
+        TIM_GenerateEvent(OW_TIM, TIM_EventSource_CC1);
+}
+
+static void ow_finish(void)
+{
+    TIM_ITConfig(OW_TIM, TIM_IT_CC1, DISABLE);
+    ow.phase = OW_IDLE;
+    ow.done = 1;
+}
+
+// 1 for a write slot of a 0
+static int ow_writing_zero(void)
+{
+    return ow.pos < ow.txBits && !(ow.tx[ow.pos >> 3] & (1 << (ow.pos & 7)));
+}
+
+// Pull the bus low for the slot of the current bit, or end the transaction
+static void ow_slot_start(void)
+{
+    if (ow.pos >= ow.txBits + ow.rxBits)
+    {
+        ow_finish();
+        return;
+    }
+    OW_PIN_LOW;
+    ow_schedule(OW_SLOT_RELEASE, ow_writing_zero() ? 60 : 6);
+}
+
+static void ow_step(void)
+{
+    u8 i;
+    switch (ow.phase)
+    {
+    case OW_RESET_LOW:
+        OW_PIN_RELEASE;
+        ow_schedule(OW_RESET_RELEASE, 70);
+        break;
+    case OW_RESET_RELEASE:
+        ow.presence = !OW_PIN_SAMPLE;
+        ow_schedule(OW_RESET_RECOVER, 410);
+        break;
+    case OW_RESET_RECOVER:
+        if (ow.presence)
+            ow_slot_start();
+        else
+            ow_finish();
+        break;
+    case OW_SLOT_LOW:
+        ow_slot_start();
+        break;
+    case OW_SLOT_RELEASE:
+        OW_PIN_RELEASE;
+        if (ow.pos >= ow.txBits)
+            ow_schedule(OW_SLOT_SAMPLE, 9);
+        else
+            ow_schedule(OW_SLOT_END, ow_writing_zero() ? 10 : 64);
+        break;
+    case OW_SLOT_SAMPLE:
+        i = ow.pos - ow.txBits;
+        if (!(i & 7))
+            ow.rx[i >> 3] = 0;
+        if (OW_PIN_SAMPLE)
+            ow.rx[i >> 3] |= 1 << (i & 7);
+        ow_schedule(OW_SLOT_END, 55);
+        break;
+    case OW_SLOT_END:
+        ow.pos++;
+        ow_slot_start();
+        break;
+    default:
+        ow_finish();
+        break;
+    }
+}
+
+void OW_TIM_IRQHandler(void)
+{
+    if (TIM_GetITStatus(OW_TIM, TIM_IT_CC1) != RESET)
+    {
+        TIM_ClearITPendingBit(OW_TIM, TIM_IT_CC1);
+        ow_step();
+    }
+}
+
+// Start a transaction of single bits, _rx must stay valid until ow_done
+// returns 0 if the bus is busy or the transaction too long
+static int ow_start_bits(char _reset, const u8 *_tx, u8 _txBits, volatile u8 *_rx, u8 _rxBits)
+{
+    u8 i;
+    if (ow.phase != OW_IDLE || _txBits > 8 * OW_MAX_TX || _rxBits > 8 * OW_MAX_RX)
+        return 0;
+    for (i = 0; i < (_txBits + 7) / 8; i++)
+        ow.tx[i] = _tx[i];
+    ow.txBits = _txBits;
+    ow.rx = _rx;
+    ow.rxBits = _rxBits;
+    ow.pos = 0;
+    ow.done = 0;
+    ow.presence = 1;
+
+    // park the compare a whole period away before clearing a stale match
+    ow.edge = OW_TIM->CNT;
+    OW_TIM->CCR1 = ow.edge - 1;
+    TIM_ClearITPendingBit(OW_TIM, TIM_IT_CC1);
+    if (_reset)
+    {
+        OW_PIN_LOW;
+        ow_schedule(OW_RESET_LOW, 480);
+    }
+    else
+    {
+        // first slot from the interrupt, a couple of us from now
+        ow_schedule(OW_SLOT_LOW, 2);
+    }
+    TIM_ITConfig(OW_TIM, TIM_IT_CC1, ENABLE);
+    return 1;
+}
+
+// Start a transaction of whole bytes
+static int ow_start(char _reset, const u8 *_tx, u8 _txLen, volatile u8 *_rx, u8 _rxLen)
+{
+    return ow_start_bits(_reset, _tx, 8 * _txLen, _rx, 8 * _rxLen);
+}
+
+// 1 when the last transaction is over, its presence in _presence
+static int ow_done(u8 *_presence)
+{
+    if (!ow.done)
+        return 0;
+    if (_presence)
+        *_presence = ow.presence;
+    return 1;
+}
+
+// Maxim CRC-8, x^8 + x^5 + x^4 + 1, of ROM codes and scratchpads. Over
+// the data and its CRC byte it is 0.
+static u8 ow_crc8(const volatile u8 *_data, u8 _len)
+{
+    u8 crc = 0, byte, i;
+    while (_len--)
+    {
+        byte = *_data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = ((crc ^ byte) & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+/*
+ * DS18B20 sensors sharing the bus
+ *
+ *   ds18b20_init();
+ *   while (!(n = ds18b20_search()));     every ROM code on the bus, once
+ *   ds18b20_set_resolution(10);          optional, 12 bits at power on
+ *   ds18b20_start_conversion();
+ *   ...                                  control loop keeps running
+ *   if (ds18b20_ready() > 0 && ds18b20_fetch(t) > 0) use t[0] .. t[n - 1]
+ *
+ * Convert T goes to every sensor at once with Skip ROM, so n sensors take
+ * one conversion time, and ds18b20_ready polls them with one read slot per
+ * call, the bus reads 1 once the slowest is done. ds18b20_fetch then reads
+ * the scratchpads one after the other with Match ROM. Without a search it
+ * reads a single sensor with Skip ROM. ds18b20_init, ds18b20_count and
+ * ds18b20_rom aside, every call returns 0 while the bus is busy and -1 if
+ * no sensor answers.
+ */
+
+enum ds18b20_state
+{
+    DS_IDLE,
+    DS_CONFIG,          // Write Scratchpad of the resolution being sent
+    DS_CONVERT,         // Convert T being sent
+    DS_CONVERTING,      // polled with read slots until it reads 1
+    DS_POLL,            // a poll slot in flight
+    DS_CONVERTED,
+    DS_READ,            // scratchpad of ds_sensor being read
+    DS_SEARCH_RESET,    // reset and Search ROM of a search pass
+    DS_SEARCH_READ,     // bit of the ROM codes and its complement
+    DS_SEARCH_WRITE     // bit of the branch taken
+};
+
+static enum ds18b20_state ds_state = DS_IDLE;
+// filled by the OW_TIM interrupt
+static volatile u8 ds_rx[OW_MAX_RX];
+static char ds_initialized = 0;
+
+static u8 ds_rom[DS18B20_MAX_SENSORS][8];
+static u8 ds_count = 0;
+static u8 ds_sensor;            // scratchpad being read by ds18b20_fetch
+static u8 ds_good;              // scratchpads that passed their CRC
+
+// ROM search, Maxim application note 187
+static u8 ds_search_rom[8];
+static u8 ds_search_bit;
+static s8 ds_last_discrepancy;  // bit where the last pass took the 0 branch
+static s8 ds_last_zero;
+
+void ds18b20_init(void)
+{
+    GPIO_InitTypeDef gpio;
+    TIM_TimeBaseInitTypeDef base;
+    TIM_OCInitTypeDef oc;
+    NVIC_InitTypeDef nvic;
+    RCC_ClocksTypeDef clocks;
+    u32 timerClock;
+
+    // open drain once and for all, the bus is read through the input register
+    OW_PIN_RELEASE;
+    gpio.GPIO_Pin = (1<<DQ_PIN);
+    gpio.GPIO_Speed = GPIO_Speed_50MHz;
+    gpio.GPIO_Mode = GPIO_Mode_Out_OD;
+    GPIO_Init(DQ_GPIO, &gpio);
+
+    // APB1 timers run at twice PCLK1 when APB1 is divided
+    RCC_GetClocksFreq(&clocks);
+    timerClock = clocks.PCLK1_Frequency;
+    if (clocks.HCLK_Frequency != clocks.PCLK1_Frequency)
+        timerClock *= 2;
+
+    RCC_APB1PeriphClockCmd(OW_TIM_RCC, ENABLE);
+    TIM_TimeBaseStructInit(&base);
+    base.TIM_Prescaler = timerClock / 1000000 - 1;
+    base.TIM_Period = 0xFFFF;
+    base.TIM_CounterMode = TIM_CounterMode_Up;
+    TIM_TimeBaseInit(OW_TIM, &base);
+
+    TIM_OCStructInit(&oc);
+    oc.TIM_OCMode = TIM_OCMode_Timing;
+    TIM_OC1Init(OW_TIM, &oc);
+    TIM_OC1PreloadConfig(OW_TIM, TIM_OCPreload_Disable);
+    TIM_ITConfig(OW_TIM, TIM_IT_CC1, DISABLE);
+
+    // slot edges must not wait for the control loop interrupts
+    nvic.NVIC_IRQChannel = OW_TIM_IRQn;
+    nvic.NVIC_IRQChannelPreemptionPriority = 0;
+    nvic.NVIC_IRQChannelSubPriority = 0;
+    nvic.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&nvic);
+
+    TIM_Cmd(OW_TIM, ENABLE);
+    ow.phase = OW_IDLE;
+    ds_state = DS_IDLE;
+    ds_initialized = 1;
+}
+
+// 1 if nothing of a conversion, read or search is in flight
+static int ds_free(void)
+{
+    return ds_state == DS_IDLE || ds_state == DS_CONFIG || ds_state == DS_CONVERTED;
+}
+
+static int ds_search_pass(void)
+{
+    static const u8 search[] = {0xF0};
+    if (!ow_start(1, search, sizeof(search), 0, 0))
+        return 0;
+    ds_search_bit = 0;
+    ds_last_zero = -1;
+    ds_state = DS_SEARCH_RESET;
+    return 1;
+}
+
+static int ds_search_end(void)
+{
+    ds_state = DS_IDLE;
+    return ds_count ? ds_count : -1;
+}
+
+// Find the ROM code of every sensor on the bus, one search step per call.
+// Returns the number of sensors found, codes with a bad CRC and the other
+// 1-Wire devices sharing the bus are skipped.
+int ds18b20_search(void)
+{
+    u8 presence, id, complement, branch, byte, mask;
+    switch (ds_state)
+    {
+    case DS_SEARCH_RESET:
+        if (!ow_done(&presence))
+            return 0;
+        if (!presence)
+            return ds_search_end();
+        break;
+    case DS_SEARCH_READ:
+        if (!ow_done(0))
+            return 0;
+        id = ds_rx[0] & 1;
+        complement = (ds_rx[0] >> 1) & 1;
+        byte = ds_search_bit >> 3;
+        mask = 1 << (ds_search_bit & 7);
+        if (id && complement)
+            return ds_search_end();     // every sensor dropped out
+        if (id != complement)
+            branch = id;                // all remaining sensors agree
+        else
+        {
+            // both values exist, take the 0 branch first and the 1 branch
+            // once the last pass took the 0 branch here
+            if (ds_search_bit < ds_last_discrepancy)
+                branch = (ds_search_rom[byte] & mask) != 0;
+            else
+                branch = ds_search_bit == ds_last_discrepancy;
+            if (!branch)
+                ds_last_zero = ds_search_bit;
+        }
+        if (branch)
+            ds_search_rom[byte] |= mask;
+        else
+            ds_search_rom[byte] &= ~mask;
+        // the sensors whose bit differs stop answering until the next reset
+        if (ow_start_bits(0, &branch, 1, 0, 0))
+            ds_state = DS_SEARCH_WRITE;
+        return 0;
+    case DS_SEARCH_WRITE:
+        if (!ow_done(0))
+            return 0;
+        if (++ds_search_bit < 64)
+            break;
+        if (ow_crc8(ds_search_rom, 8) == 0 && ds_search_rom[0] == DS18B20_FAMILY &&
+                ds_count < DS18B20_MAX_SENSORS)
+        {
+            for (byte = 0; byte < 8; byte++)
+                ds_rom[ds_count][byte] = ds_search_rom[byte];
+            ds_count++;
+        }
+        ds_last_discrepancy = ds_last_zero;
+        if (ds_last_discrepancy < 0 || ds_count == DS18B20_MAX_SENSORS)
+            return ds_search_end();
+        ds_search_pass();
+        return 0;
+    default:
+        if (!ds_free() || !ds_search_pass())
+            return 0;
+        ds_count = 0;
+        ds_last_discrepancy = -1;
+        return 0;
+    }
+    // next bit of this pass
+    if (ow_start_bits(0, 0, 0, ds_rx, 2))
+        ds_state = DS_SEARCH_READ;
+    return 0;
+}
+
+// Sensors found by the last search
+u8 ds18b20_count(void)
+{
+    return ds_count;
+}
+
+const u8 *ds18b20_rom(u8 _sensor)
+{
+    return _sensor < ds_count ? ds_rom[_sensor] : 0;
+}
+
+// Resolution of every sensor, 9 to 12 bits. A conversion takes 94 ms at
+// 9 bits and twice as long for every further bit, up to 750 ms. Kept in
+// the scratchpad only, a power cycle is back at 12 bits. The alarm
+// registers written with it are set to their power on values.
+int ds18b20_set_resolution(u8 _bits)
+{
+    u8 config[] = {0xCC, 0x4E, 0x4B, 0x46, 0x1F};
+    if (_bits < 9 || _bits > 12 || !ds_free())
+        return 0;
+    config[4] |= (_bits - 9) << 5;
+    if (!ow_start(1, config, sizeof(config), 0, 0))
+        return 0;
+    ds_state = DS_CONFIG;
+    return 1;
+}
+
+int ds18b20_start_conversion(void)
+{
+    static const u8 convert[] = {0xCC, 0x44};
+    if (!ds_free())
+        return 0;
+    if (!ow_start(1, convert, sizeof(convert), 0, 0))
+        return 0;
+    ds_state = DS_CONVERT;
+    return 1;
+}
+
+int ds18b20_ready(void)
+{
+    u8 presence;
+    switch (ds_state)
+    {
+    case DS_CONVERT:
+        if (!ow_done(&presence))
+            return 0;
+        if (!presence)
+        {
+            ds_state = DS_IDLE;
+            return -1;
+        }
+        ds_state = DS_CONVERTING;
+        return 0;
+    case DS_CONVERTING:
+        // a sensor answers read slots with 0 until its conversion is over
+        if (ow_start(0, 0, 0, ds_rx, 1))
+            ds_state = DS_POLL;
+        return 0;
+    case DS_POLL:
+        if (!ow_done(0))
+            return 0;
+        ds_state = (ds_rx[0] & 1) ? DS_CONVERTED : DS_CONVERTING;
+        return ds_state == DS_CONVERTED;
+    case DS_CONVERTED:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Read Scratchpad of ds_sensor, Match ROM once the bus has been searched
+static int ds_read_start(void)
+{
+    u8 read[10], i;
+    if (!ds_count)
+    {
+        read[0] = 0xCC;
+        read[1] = 0xBE;
+        return ow_start(1, read, 2, ds_rx, sizeof(ds_rx));
+    }
+    read[0] = 0x55;
+    for (i = 0; i < 8; i++)
+        read[1 + i] = ds_rom[ds_sensor][i];
+    read[9] = 0xBE;
+    return ow_start(1, read, sizeof(read), ds_rx, sizeof(ds_rx));
+}
+
+// Temperature in the scratchpad read, DS18B20_ERROR if it is corrupt.
+// The low bits the resolution does not fill are undefined.
+static float ds_decode(u8 _presence)
+{
+    s16 raw;
+    u8 bits;
+    // a bus stuck low reads zeros, whose CRC is 0 as well, the reserved
+    // bits of the configuration always read 1
+    if (!_presence || ow_crc8(ds_rx, 9) != 0 || (ds_rx[4] & 0x1F) != 0x1F)
+        return DS18B20_ERROR;
+    bits = 9 + ((ds_rx[4] >> 5) & 3);
+    raw = (s16)((ds_rx[1] << 8) | ds_rx[0]);
+    raw &= ~((1 << (12 - bits)) - 1);
+    ds_good++;
+    return raw / 16.0f;
+}
+
+// Temperatures of the last conversion, _celsius holds one per sensor found,
+// or one without a search. A sensor that cannot be read is DS18B20_ERROR.
+// Returns 1 once every sensor is read, -1 if none of them could be.
+int ds18b20_fetch(float *_celsius)
+{
+    u8 presence;
+    if (ds_state == DS_CONVERTED)
+    {
+        ds_sensor = 0;
+        ds_good = 0;
+        if (!ds_read_start())
+            return 0;
+        ds_state = DS_READ;
+        return 0;
+    }
+    if (ds_state != DS_READ || !ow_done(&presence))
+        return 0;
+    _celsius[ds_sensor] = ds_decode(presence);
+    if (++ds_sensor < ds_count)
+    {
+        // the bus was freed by the read that just ended
+        ds_read_start();
+        return 0;
+    }
+    ds_state = DS_IDLE;
+    return ds_good ? 1 : -1;
+}
+
+// Blocking read of the first sensor on top of the asynchronous driver,
+// DS18B20_ERROR without a sensor
+float ds18b20_read(void)
+{
+    float result[DS18B20_MAX_SENSORS];
+    int status;
+    if (!ds_initialized)
+        ds18b20_init();
+    while (!ds18b20_start_conversion());
+    while ((status = ds18b20_ready()) == 0);
+    if (status < 0)
+        return DS18B20_ERROR;
+    while ((status = ds18b20_fetch(result)) == 0);
+    if (status < 0)
+        return DS18B20_ERROR;
+    return result[0];
+}
@@ -0,0 +1,59 @@
+/*
+ * ds18b20.h
+ *
+ *  DS18B20 temperature sensors on a 1-Wire bus of an STM32F10x, see
+ *  ds18b20.c for how the calls go together. Every call but ds18b20_init,
+ *  ds18b20_count, ds18b20_rom and ds18b20_read returns 0 while the bus is
+ *  busy and -1 if no sensor answers, so the control loop never waits.
+ */
+
+#ifndef DS18B20_H
+#define DS18B20_H
+
+#include "stm32f10x.h"
+
+// Data pin of the bus, open drain with an external pull up. Define both
+// before this header to move it.
+#ifndef DQ_GPIO
+#define DQ_GPIO             GPIOA
+#define DQ_PIN              0
+#endif
+
+#ifndef DS18B20_MAX_SENSORS
+#define DS18B20_MAX_SENSORS 8
+#endif
+
+// Family code, the first byte of the ROM code of every DS18B20
+#define DS18B20_FAMILY      0x28
+
+// Temperature of a sensor that could not be read
+#define DS18B20_ERROR       (-127.0f)
+
+// Blocking 1-Wire, the timings are stretched by the interrupts meanwhile
+void onewire_reset(void);
+void onewire_write(char data);
+unsigned char onewire_read(void);
+
+// Pin and timer of the asynchronous driver, before any other call
+void ds18b20_init(void);
+// ROM codes of the DS18B20 on the bus, one search step per call. Returns
+// the number found once the search is over.
+int ds18b20_search(void);
+// Sensors found by the last search, and the ROM code of one of them,
+// 0 past the last
+u8 ds18b20_count(void);
+const u8 *ds18b20_rom(u8 _sensor);
+// Resolution of 9 to 12 bits of every sensor. Returns 1 once it is sent.
+int ds18b20_set_resolution(u8 _bits);
+// Convert T on every sensor at once. Returns 1 once it is sent.
+int ds18b20_start_conversion(void);
+// Returns 1 once the conversion of every sensor is over
+int ds18b20_ready(void);
+// Temperatures in degC of the last conversion, DS18B20_MAX_SENSORS of
+// them at most in _celsius. Returns 1 once every sensor is read.
+int ds18b20_fetch(float *_celsius);
+
+// Blocking conversion and read of the first sensor
+float ds18b20_read(void);
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * command_mailbox_bench.cpp
+ *
+ *  Compares the time the physics thread spends reading the latest command
+ *  through CommandMailbox with the boost::mutex path it replaced, while a
+ *  second thread writes commands as fast as it can, like a flood of control
+ *  messages on the ros callback thread.
+ *
+ *  usage: command_mailbox_bench [reads]
+ */
+
+#include <suruiha_gazebo_plugins/command_mailbox.h>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Targets
+{
+  double throttle;
+  double pitch;
+  double roll;
+  double yaw;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result
+{
+  double meanNs;
+  double p99Ns;
+  double maxNs;
+  unsigned long writes;
+  unsigned long torn;
+};
+
+/// \brief the old path, SetControl and UpdateStates share one mutex
+class MutexPath
+{
+  public: void Write(const Targets &_t) {
+      boost::mutex::scoped_lock lock(mutex_);
+      targets_ = _t;
+  }
+  public: Targets Read() {
+      boost::mutex::scoped_lock lock(mutex_);
+      return targets_;
+  }
+  private: boost::mutex mutex_;
+  private: Targets targets_ = Targets();
+};
+
+class MailboxPath
+{
+  public: void Write(const Targets &_t) { mailbox_.Write(_t); }
+  public: Targets Read() { return mailbox_.Read(); }
+  private: gazebo::CommandMailbox<Targets> mailbox_;
+};
+
+template <typename Path>
+Result Run(unsigned long _reads) {
+  Path path;
+  boost::atomic<bool> running(true);
+  unsigned long writes = 0;
+
+  // every field of a write holds the same value, a read with different
+  // values mixed two writes
+  boost::thread writer([&]() {
+      double v = 0;
+      while (running.load(boost::memory_order_relaxed)) {
+          v += 1;
+          Targets t = {v, v, v, v};
+          path.Write(t);
+          ++writes;
+      }
+  });
+
+  std::vector<double> samples(_reads);
+  unsigned long torn = 0;
+  for (unsigned long i = 0; i < _reads; ++i) {
+      Clock::time_point start = Clock::now();
+      Targets t = path.Read();
+      Clock::time_point end = Clock::now();
+      samples[i] = std::chrono::duration<double, std::nano>(end - start).count();
+      if (t.throttle != t.pitch || t.pitch != t.roll || t.roll != t.yaw) {
+          ++torn;
+      }
+  }
+  running = false;
+  writer.join();
+
+  Result r;
+  double sum = 0;
+  for (unsigned long i = 0; i < _reads; ++i) {
+      sum += samples[i];
+  }
+  r.meanNs = sum / _reads;
+  std::sort(samples.begin(), samples.end());
+  r.p99Ns = samples[static_cast<unsigned long>(0.99 * (_reads - 1))];
+  r.maxNs = samples.back();
+  r.writes = writes;
+  r.torn = torn;
+  return r;
+}
+
+void Print(const char *_name, const Result &_r) {
+  std::printf("%-14s mean %8.1f ns  p99 %8.1f ns  max %10.1f ns  writes %10lu  torn %lu\n",
+          _name, _r.meanNs, _r.p99Ns, _r.maxNs, _r.writes, _r.torn);
+}
+}
+
+int main(int argc, char **argv) {
+  unsigned long reads = 2000000;
+  if (argc > 1) {
+      reads = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (reads == 0) {
+      std::fprintf(stderr, "usage: %s [reads]\n", argv[0]);
+      return 1;
+  }
+
+  std::printf("%lu reads against a writer thread\n", reads);
+  Print("boost::mutex", Run<MutexPath>(reads));
+  Print("mailbox", Run<MailboxPath>(reads));
+  return 0;
+}
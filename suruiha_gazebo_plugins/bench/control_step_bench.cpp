@@ -0,0 +1,452 @@
+/*
+ * control_step_bench.cpp
+ *
+ *  Google benchmarks of the per physics step controller paths: the three
+ *  JointArray types, the zephyr joint commands and the iris mixer, for 1
+ *  to 1000 vehicles. The joints belong to stand-in models in a world that is
+ *  loaded in process and never stepped, so SetForce only records the force
+ *  and the numbers are the cost of the controller alone.
+ *
+ *  BM_CommonPid and BM_PidBank compare the rotor PIDs of that many iris one
+ *  common::PID at a time and batched, main checks first that both give the
+ *  same commands.
+ *
+ *  BM_IrisStepRecorded is BM_IrisStep with every iris recorded by a
+ *  FlightRecorder into a log in /tmp, the difference is the recording cost
+ *  on the physics thread.
+ *
+ *  BM_IrisConfigParse parses the plugin sdf of every iris as each spawn did
+ *  before the IrisConfig cache, BM_IrisLoad loads every iris from the cached
+ *  config as a spawn does now, its step is the bring-up of all vehicles.
+ *
+ *  Every benchmark reports the time of one step over all its vehicles and
+ *  allocs/step, the operator new calls of that step.
+ *
+ *  usage: control_step_bench [--benchmark_filter=<regex>]
+ */
+
+#include <suruiha_gazebo_plugins/joint_control.h>
+#include <suruiha_gazebo_plugins/zephyr_vehicle.h>
+#include <suruiha_gazebo_plugins/iris_vehicle.h>
+#include <suruiha_gazebo_plugins/vehicle_config.h>
+#include <suruiha_gazebo_plugins/rotor_bank.h>
+#include <suruiha_gazebo_plugins/pid_bank.h>
+#include <suruiha_gazebo_plugins/flight_recorder.h>
+#include <benchmark/benchmark.h>
+#include <gazebo/gazebo.hh>
+#include <gazebo/physics/physics.hh>
+#include <sdf/sdf.hh>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::atomic<unsigned long> allocations(0);
+}
+
+void* operator new(std::size_t _size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = std::malloc(_size == 0 ? 1 : _size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *_p) noexcept {
+    std::free(_p);
+}
+
+void operator delete(void *_p, std::size_t) noexcept {
+    std::free(_p);
+}
+
+namespace {
+
+using namespace gazebo;
+
+const int MAX_VEHICLES = 1000;
+const double STEP = 0.001;
+
+std::string ZephyrModel(int _i) {
+    std::ostringstream s;
+    s << "<model name='zephyr_" << _i << "'><pose>" << _i * 4 << " 0 1 0 0 0</pose>"
+      << "<link name='wing'/><link name='propeller'/>"
+      << "<link name='flap_left'/><link name='flap_right'/>";
+    const char* joints[] = {"propeller", "flap_left", "flap_right"};
+    for (int j = 0; j < 3; ++j) {
+        s << "<joint name='" << joints[j] << "_joint' type='revolute'>"
+          << "<parent>wing</parent><child>" << joints[j] << "</child>"
+          << "<axis><xyz>1 0 0</xyz></axis></joint>";
+    }
+    s << "</model>";
+    return s.str();
+}
+
+std::string IrisModel(int _i) {
+    std::ostringstream s;
+    s << "<model name='iris_" << _i << "'><pose>" << _i * 4 << " 4 1 0 0 0</pose>"
+      << "<link name='base_link'/>";
+    for (int r = 0; r < 4; ++r) {
+        s << "<link name='rotor_" << r << "'/>"
+          << "<joint name='rotor_" << r << "_joint' type='revolute'>"
+          << "<parent>base_link</parent><child>rotor_" << r << "</child>"
+          << "<axis><xyz>0 0 1</xyz></axis></joint>";
+    }
+    s << "</model>";
+    return s.str();
+}
+
+/// \brief the world with MAX_VEHICLES zephyr and iris stand-ins, loaded once
+physics::WorldPtr BenchWorld() {
+    static physics::WorldPtr world;
+    if (world) {
+        return world;
+    }
+
+    gazebo::setupServer();
+    std::ostringstream s;
+    s << "<sdf version='1.6'><world name='bench'>";
+    for (int i = 0; i < MAX_VEHICLES; ++i) {
+        s << ZephyrModel(i) << IrisModel(i);
+    }
+    s << "</world></sdf>";
+
+    sdf::SDFPtr sdfWorld(new sdf::SDF());
+    sdf::init(sdfWorld);
+    sdf::readString(s.str(), sdfWorld);
+    world = physics::create_world();
+    physics::load_world(world, sdfWorld->Root()->GetElement("world"));
+    physics::init_world(world);
+    return world;
+}
+
+/// \brief plugin element of a model with the given controller parameters
+sdf::ElementPtr PluginSdf(const std::string &_model, const std::string &_params) {
+    std::ostringstream s;
+    s << "<sdf version='1.6'><model name='" << _model << "'><link name='l'/>"
+      << "<plugin name='controller' filename='none'>" << _params
+      << "</plugin></model></sdf>";
+    // the returned element is only valid while its document lives
+    static std::vector<sdf::SDFPtr> parsed;
+    sdf::SDFPtr sdfModel(new sdf::SDF());
+    sdf::init(sdfModel);
+    sdf::readString(s.str(), sdfModel);
+    parsed.push_back(sdfModel);
+    return sdfModel->Root()->GetElement("model")->GetElement("plugin");
+}
+
+std::string ZephyrParams() {
+    std::ostringstream s;
+    s << "<joint_control><name>propeller_joint</name><type>velocity</type>"
+      << "<p>0.1</p><i>0</i><d>0</d><imax>0</imax><imin>0</imin>"
+      << "<cmdmax>800</cmdmax><cmdmin>0</cmdmin></joint_control>";
+    const char* flaps[] = {"flap_left_joint", "flap_right_joint"};
+    for (int f = 0; f < 2; ++f) {
+        s << "<joint_control><name>" << flaps[f] << "</name><type>position</type>"
+          << "<p>10.0</p><i>0.0</i><d>0.0</d><imax>1.0</imax><imin>-1.0</imin>"
+          << "<cmdmax>2.0</cmdmax><cmdmin>-2.0</cmdmin></joint_control>";
+    }
+    s << "<poseUpdateRate>10</poseUpdateRate>";
+    return s.str();
+}
+
+std::string IrisParams() {
+    const double mix[4][3] = {{1, 1, 1}, {-1, -1, 1}, {1, -1, -1}, {-1, 1, -1}};
+    const char* direction[4] = {"ccw", "ccw", "cw", "cw"};
+    std::ostringstream s;
+    for (int r = 0; r < 4; ++r) {
+        s << "<rotor id='" << r << "'>"
+          << "<vel_p_gain>0.2</vel_p_gain><vel_i_gain>0</vel_i_gain><vel_d_gain>0</vel_d_gain>"
+          << "<vel_i_max>0</vel_i_max><vel_i_min>0</vel_i_min>"
+          << "<vel_cmd_max>3.0</vel_cmd_max><vel_cmd_min>-3.0</vel_cmd_min>"
+          << "<jointName>rotor_" << r << "_joint</jointName>"
+          << "<mixPitch>" << mix[r][0] << "</mixPitch><mixRoll>" << mix[r][1] << "</mixRoll>"
+          << "<mixYaw>" << mix[r][2] << "</mixYaw><trim>1</trim>"
+          << "<turningDirection>" << direction[r] << "</turningDirection>"
+          << "<rotorVelocitySlowdownSim>1</rotorVelocitySlowdownSim></rotor>";
+    }
+    s << "<poseUpdateRate>10</poseUpdateRate>";
+    return s.str();
+}
+
+void Report(benchmark::State &_state, unsigned long _allocations, int _vehicles) {
+    _state.counters["vehicles"] = _vehicles;
+    _state.counters["allocs/step"] =
+            static_cast<double>(_allocations) / std::max<size_t>(_state.iterations(), 1);
+}
+
+void VehicleCounts(benchmark::internal::Benchmark *_bench) {
+    for (int n = 1; n <= MAX_VEHICLES; n *= 10) {
+        _bench->Arg(n);
+    }
+}
+
+/// \brief one JointArray of the given type over every joint of every zephyr
+template <JointType TYPE>
+void BM_JointArray(benchmark::State &_state) {
+    physics::WorldPtr world = BenchWorld();
+    const int vehicles = _state.range(0);
+    const char* names[] = {"propeller_joint", "flap_left_joint", "flap_right_joint"};
+
+    common::PID pid;
+    pid.Init(10.0, 0.0, 0.0, 1.0, -1.0, 2.0, -2.0);
+    JointArray<TYPE> array;
+    for (int i = 0; i < vehicles; ++i) {
+        physics::ModelPtr model = world->ModelByName("zephyr_" + std::to_string(i));
+        for (int j = 0; j < 3; ++j) {
+            array.Add(names[j], model->GetJoint(names[j]), pid, array.Size());
+        }
+    }
+    std::vector<double> commands(array.Size(), 0.0);
+    std::vector<double> positions(array.Size(), 0.0);
+    std::vector<double> velocities(array.Size(), 0.0);
+
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        for (unsigned k = 0; k < commands.size(); ++k) {
+            commands[k] += 1e-3;
+        }
+        array.Update(STEP, commands, positions, velocities);
+    }
+    Report(_state, allocations.load() - before, vehicles);
+}
+
+/// \brief ZephyrVehicle::CalculateJoints on a state read once per step
+void BM_ZephyrStep(benchmark::State &_state) {
+    physics::WorldPtr world = BenchWorld();
+    const int vehicles = _state.range(0);
+
+    std::deque<ZephyrVehicle> zephyrs(vehicles);
+    for (int i = 0; i < vehicles; ++i) {
+        std::string name = "zephyr_" + std::to_string(i);
+        zephyrs[i].Load(world->ModelByName(name), PluginSdf(name, ZephyrParams()));
+    }
+
+    common::Time time;
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        time += STEP;
+        for (int i = 0; i < vehicles; ++i) {
+            ZephyrVehicle &zephyr = zephyrs[i];
+            zephyr.state.Read(zephyr.model, zephyr.jointPtrs, time, zephyr.stats);
+            zephyr.CalculateJoints(10.0, 0.01, -0.01, STEP);
+        }
+    }
+    Report(_state, allocations.load() - before, vehicles);
+
+    for (int i = 0; i < vehicles; ++i) {
+        zephyrs[i].Unload();
+    }
+}
+
+/// \brief IrisVehicle::CalculateRotors for every iris, one RotorBank::Mix
+/// and the rotor PIDs, the way the swarm runs a step. Every iris is
+/// recorded if there is a _recorder.
+void IrisStep(benchmark::State &_state, FlightRecorder* _recorder) {
+    physics::WorldPtr world = BenchWorld();
+    const int vehicles = _state.range(0);
+
+    RotorBank bank;
+    std::deque<IrisVehicle> irises(vehicles);
+    for (int i = 0; i < vehicles; ++i) {
+        std::string name = "iris_" + std::to_string(i);
+        irises[i].Load(world->ModelByName(name), PluginSdf(name, IrisParams()), &bank);
+        irises[i].controlActive = true;
+        irises[i].controlTick = true;
+        irises[i].controlDt = STEP;
+        if (_recorder != nullptr) {
+            irises[i].recorder = _recorder;
+            irises[i].recordId = _recorder->AddVehicle(name);
+        }
+    }
+
+    common::Time time;
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        time += STEP;
+        for (int i = 0; i < vehicles; ++i) {
+            IrisVehicle &iris = irises[i];
+            iris.state.Read(iris.model, iris.rotorJoints, time, iris.stats);
+            iris.CalculateRotors(0.6, 0.01, -0.01, 0.0);
+        }
+        bank.Mix();
+        for (int i = 0; i < vehicles; ++i) {
+            irises[i].Actuate();
+        }
+    }
+    Report(_state, allocations.load() - before, vehicles);
+
+    for (int i = 0; i < vehicles; ++i) {
+        irises[i].Unload();
+    }
+}
+
+void BM_IrisStep(benchmark::State &_state) {
+    IrisStep(_state, nullptr);
+}
+
+void BM_IrisStepRecorded(benchmark::State &_state) {
+    FlightRecorder recorder;
+    if (!recorder.Open("/tmp/control_step_bench.log", 1 << 17)) {
+        _state.SkipWithError("cannot open /tmp/control_step_bench.log");
+        return;
+    }
+    IrisStep(_state, &recorder);
+    recorder.Close();
+    _state.counters["dropped"] = recorder.Dropped();
+}
+
+/// \brief plugin sdf of every iris, parsed outside of the timed steps
+std::vector<sdf::ElementPtr> IrisSdfs(int _vehicles) {
+    std::vector<sdf::ElementPtr> sdfs;
+    for (int i = 0; i < _vehicles; ++i) {
+        sdfs.push_back(PluginSdf("iris_" + std::to_string(i), IrisParams()));
+    }
+    return sdfs;
+}
+
+void BM_IrisConfigParse(benchmark::State &_state) {
+    const int vehicles = _state.range(0);
+    std::vector<sdf::ElementPtr> sdfs = IrisSdfs(vehicles);
+
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        for (int i = 0; i < vehicles; ++i) {
+            IrisConfig config;
+            benchmark::DoNotOptimize(config.Load(sdfs[i]));
+        }
+    }
+    Report(_state, allocations.load() - before, vehicles);
+}
+
+void BM_IrisLoad(benchmark::State &_state) {
+    physics::WorldPtr world = BenchWorld();
+    const int vehicles = _state.range(0);
+    std::vector<sdf::ElementPtr> sdfs = IrisSdfs(vehicles);
+    std::vector<physics::ModelPtr> models;
+    for (int i = 0; i < vehicles; ++i) {
+        models.push_back(world->ModelByName("iris_" + std::to_string(i)));
+    }
+
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        RotorBank bank;
+        std::deque<IrisVehicle> irises(vehicles);
+        for (int i = 0; i < vehicles; ++i) {
+            irises[i].Load(models[i], sdfs[i], &bank);
+        }
+        for (int i = 0; i < vehicles; ++i) {
+            irises[i].Unload();
+        }
+    }
+    Report(_state, allocations.load() - before, vehicles);
+}
+
+/// \brief gains of the iris rotor PIDs, clamped by vel_cmd_max and vel_cmd_min
+common::PID RotorPid() {
+    return common::PID(0.2, 0, 0, 0, 0, 3.0, -3.0);
+}
+
+/// \brief errors around the command limits, switching sign every rotor
+double RotorError(unsigned _rotor, unsigned _step) {
+    return ((_rotor + _step) % 7) * 3.0 - 9.0 + 1e-3 * _step;
+}
+
+void BM_CommonPid(benchmark::State &_state) {
+    const int vehicles = _state.range(0);
+    std::vector<common::PID> pids(vehicles * 4, RotorPid());
+    std::vector<double> force(pids.size());
+
+    unsigned step = 0;
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        ++step;
+        for (unsigned i = 0; i < pids.size(); ++i) {
+            force[i] = pids[i].Update(RotorError(i, step), STEP);
+        }
+        benchmark::DoNotOptimize(force.data());
+    }
+    Report(_state, allocations.load() - before, vehicles);
+}
+
+void BM_PidBank(benchmark::State &_state) {
+    const int vehicles = _state.range(0);
+    PidBank bank;
+    for (int i = 0; i < vehicles * 4; ++i) {
+        bank.Add(RotorPid());
+    }
+    std::vector<double> error(bank.Size()), dt(bank.Size(), STEP), force(bank.Size());
+
+    unsigned step = 0;
+    const unsigned long before = allocations.load();
+    for (auto _ : _state) {
+        ++step;
+        for (unsigned i = 0; i < error.size(); ++i) {
+            error[i] = RotorError(i, step);
+        }
+        bank.Update(error.data(), dt.data(), force.data());
+        benchmark::DoNotOptimize(force.data());
+    }
+    Report(_state, allocations.load() - before, vehicles);
+}
+
+/// \brief number of PidBank commands that differ from common::PID
+unsigned long PidMismatches() {
+    const unsigned n = 4 * 13 + 3;
+    std::vector<common::PID> pids;
+    PidBank bank;
+    for (unsigned i = 0; i < n; ++i) {
+        common::PID pid(0.1 * (i % 5), 0.05 * (i % 3), 0.01 * (i % 4), 1.0, -1.0,
+                (i % 2) ? 3.0 : 0.0, -3.0);
+        pids.push_back(pid);
+        bank.Add(pid);
+    }
+
+    unsigned long mismatches = 0;
+    std::vector<double> error(n), dt(n), force(n);
+    for (unsigned step = 0; step < 1000; ++step) {
+        for (unsigned i = 0; i < n; ++i) {
+            error[i] = RotorError(i, step);
+            dt[i] = (i + step) % 11 == 0 ? 0.0 : STEP;
+        }
+        bank.Update(error.data(), dt.data(), force.data());
+        for (unsigned i = 0; i < n; ++i) {
+            double expected = pids[i].Update(error[i], dt[i]);
+            if (std::memcmp(&expected, &force[i], sizeof(double)) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+BENCHMARK(BM_CommonPid)->Apply(VehicleCounts);
+BENCHMARK(BM_PidBank)->Apply(VehicleCounts);
+BENCHMARK_TEMPLATE(BM_JointArray, POSITION)->Apply(VehicleCounts);
+BENCHMARK_TEMPLATE(BM_JointArray, VELOCITY)->Apply(VehicleCounts);
+BENCHMARK_TEMPLATE(BM_JointArray, EFFORT)->Apply(VehicleCounts);
+BENCHMARK(BM_ZephyrStep)->Apply(VehicleCounts);
+BENCHMARK(BM_IrisStep)->Apply(VehicleCounts);
+BENCHMARK(BM_IrisStepRecorded)->Apply(VehicleCounts);
+BENCHMARK(BM_IrisConfigParse)->Apply(VehicleCounts);
+BENCHMARK(BM_IrisLoad)->Apply(VehicleCounts);
+
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    unsigned long mismatches = PidMismatches();
+    std::printf("PidBank %s kernel, %lu commands differ from common::PID\n",
+            PidBank::Kernel(), mismatches);
+    benchmark::RunSpecifiedBenchmarks();
+    gazebo::shutdown();
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * callback_dispatcher.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_CALLBACK_DISPATCHER_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_CALLBACK_DISPATCHER_H_
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <boost/thread.hpp>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+/// \brief Callback queue of the ros topics of a controller and the way it is serviced.
+/// Selected by <callbackDispatch> in the plugin sdf:
+///   thread  a thread sleeps on the queue and runs callbacks as they arrive
+///   update  no thread, the world update hook runs the queued callbacks
+///           through Dispatch() before it updates the vehicles
+/// In both modes a control message is used by the first step after it arrived.
+class CallbackDispatcher
+{
+  public: enum Mode { THREAD, UPDATE };
+
+  public: CallbackDispatcher();
+  public: virtual ~CallbackDispatcher();
+
+  /// \brief Mode from <callbackDispatch>, THREAD if it is not given.
+  /// UPDATE whenever <lockstep> is true, lockstep commands are taken on the
+  /// update thread.
+  public: static Mode ModeFromSdf(sdf::ElementPtr _sdf);
+
+  /// \brief Start servicing the queue, the node handle must outlive Stop()
+  public: void Start(ros::NodeHandle* _rosnode, Mode _mode);
+
+  /// \brief Run the queued callbacks if the mode is UPDATE, called by the update hook
+  public: void Dispatch();
+
+  /// \brief Drop the queued callbacks and join the thread
+  public: void Stop();
+
+  public: Mode GetMode() const;
+
+  /// \brief queue to pass in the ros::SubscribeOptions of the controller topics
+  public: ros::CallbackQueue* Queue();
+
+  private: void QueueThread();
+
+  private: ros::NodeHandle* rosnode_;
+  private: Mode mode_;
+  private: ros::CallbackQueue queue_;
+  private: boost::thread callback_queue_thread_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_CALLBACK_DISPATCHER_H_ */
@@ -0,0 +1,77 @@
+/*
+ * command_mailbox.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_MAILBOX_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_MAILBOX_H_
+
+#include <atomic>
+
+namespace gazebo {
+/// \brief Latest value handed from one writer thread to one reader thread.
+/// Triple buffer: the writer fills its own back buffer and swaps it with the
+/// middle one, the reader swaps the middle one with its front buffer when a
+/// new value was written. Neither side ever waits for the other, and the
+/// reader always sees a whole value, never half of two writes.
+/// Only one thread may call Write and only one thread may call Read.
+template <typename T>
+class CommandMailbox
+{
+  public: CommandMailbox() : middle_(1) {
+      back_ = 0;
+      front_ = 2;
+      buffers_[0] = buffers_[1] = buffers_[2] = T();
+  }
+
+  /// \brief Copies the last written value.
+  /// Mailboxes are only copied while no thread is using them, e.g. when a
+  /// vehicle is stored in its slot.
+  public: CommandMailbox(const CommandMailbox &_other) : middle_(1) {
+      *this = _other;
+  }
+
+  public: CommandMailbox& operator=(const CommandMailbox &_other) {
+      if (this != &_other) {
+          back_ = 0;
+          front_ = 2;
+          buffers_[0] = buffers_[2] = T();
+          buffers_[1] = _other.Latest();
+          middle_.store(1 | DIRTY, std::memory_order_release);
+      }
+      return *this;
+  }
+
+  /// \brief Publish a new value, called by the writer thread only
+  public: void Write(const T &_value) {
+      buffers_[back_] = _value;
+      back_ = middle_.exchange(back_ | DIRTY, std::memory_order_acq_rel) & INDEX;
+  }
+
+  /// \brief The newest value written so far, called by the reader thread only.
+  /// The reference stays valid until the next Read.
+  public: const T& Read() {
+      if (middle_.load(std::memory_order_relaxed) & DIRTY) {
+          front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+      }
+      return buffers_[front_];
+  }
+
+  private: const T& Latest() const {
+      unsigned middle = middle_.load(std::memory_order_acquire);
+      return (middle & DIRTY) ? buffers_[middle & INDEX] : buffers_[front_];
+  }
+
+  private: static const unsigned INDEX = 3;
+  private: static const unsigned DIRTY = 4;
+
+  private: T buffers_[3];
+  /// \brief index of the middle buffer, DIRTY if it is newer than the front one
+  private: std::atomic<unsigned> middle_;
+  /// \brief owned by the writer
+  private: unsigned back_;
+  /// \brief owned by the reader
+  private: unsigned front_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_MAILBOX_H_ */
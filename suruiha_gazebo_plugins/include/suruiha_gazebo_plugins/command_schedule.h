@@ -0,0 +1,58 @@
+/*
+ * command_schedule.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_SCHEDULE_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_SCHEDULE_H_
+
+#include <gazebo/common/Time.hh>
+#include <deque>
+#include <utility>
+
+namespace gazebo {
+/// \brief Commands stamped with sim time, waiting for the step they are due.
+/// Used by the lockstep mode, where the control callbacks and the world
+/// update run on the same thread, so there is no locking.
+template <typename T>
+class CommandSchedule
+{
+  /// \brief Queue a command stamped _stamp, _now is the current sim time.
+  /// Commands with the same stamp are applied in arrival order.
+  /// \return false if the stamp is already in the past, the command is
+  /// then applied by the next step, later than it should be
+  public: bool Push(const common::Time &_stamp, const T &_value, const common::Time &_now) {
+      typename std::deque<Entry>::iterator it = queue_.end();
+      while (it != queue_.begin() && _stamp < (it - 1)->first) {
+          --it;
+      }
+      queue_.insert(it, Entry(_stamp, _value));
+      return !(_stamp < _now);
+  }
+
+  /// \brief Take every command due at _now.
+  /// \return false if none is due, _value is then unchanged,
+  /// otherwise _value is the last one due
+  public: bool PopDue(const common::Time &_now, T &_value) {
+      bool due = false;
+      while (!queue_.empty() && queue_.front().first <= _now) {
+          _value = queue_.front().second;
+          queue_.pop_front();
+          due = true;
+      }
+      return due;
+  }
+
+  public: void Clear() {
+      queue_.clear();
+  }
+
+  public: unsigned Size() const {
+      return queue_.size();
+  }
+
+  private: typedef std::pair<common::Time, T> Entry;
+  private: std::deque<Entry> queue_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_COMMAND_SCHEDULE_H_ */
@@ -0,0 +1,71 @@
+/*
+ * control_clock.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_CONTROL_CLOCK_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_CONTROL_CLOCK_H_
+
+#include <gazebo/common/Time.hh>
+#include <suruiha_gazebo_plugins/util.h>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+/// \brief When a vehicle runs its controller, at a fixed rate below the
+/// physics rate. Between two ticks the vehicle holds its last forces.
+/// Vehicles of a swarm get different phases so that their ticks fall on
+/// different physics steps.
+class ControlClock
+{
+  public: ControlClock() : period(0), phase(0), phaseSet(false), started_(false), next_(0) {
+  }
+
+  /// \brief Read <controlRate> in Hz and <controlPhase> in seconds
+  public: void Load(sdf::ElementPtr _sdf) {
+      double value;
+      Util::GetSdfParam(_sdf, "controlRate", value, 0);
+      SetRate(value);
+      phaseSet = Util::GetSdfParam(_sdf, "controlPhase", value, 0);
+      phase = value;
+  }
+
+  /// \brief Tick every _rate Hz, 0 to tick every physics step
+  public: void SetRate(double _rate) {
+      period = _rate > 0.0 ? common::Time(1.0 / _rate) : common::Time(0);
+  }
+
+  public: bool EveryStep() const {
+      return period <= common::Time(0);
+  }
+
+  /// \brief Whether the controller runs at _now. The first tick is _phase
+  /// after the first call, ticks that fell between two calls are skipped.
+  public: bool Due(const common::Time &_now) {
+      if (EveryStep()) {
+          return true;
+      }
+      if (!started_) {
+          next_ = _now + phase;
+          started_ = true;
+      }
+      if (_now < next_) {
+          return false;
+      }
+      while (next_ <= _now) {
+          next_ += period;
+      }
+      return true;
+  }
+
+  /// \brief time between two ticks, 0 for every step
+  public: common::Time period;
+  /// \brief offset of the first tick
+  public: common::Time phase;
+  /// \brief phase was given in the sdf, the swarm does not spread it
+  public: bool phaseSet;
+
+  private: bool started_;
+  private: common::Time next_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_CONTROL_CLOCK_H_ */
@@ -0,0 +1,124 @@
+/*
+ * flight_log.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_LOG_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Layout of a flight log file, written by FlightLogWriter.
+/// All integers are uint32 in host byte order, all values double.
+///   header   magic "SRHLOG1\0", version, column count,
+///            then every column name in COLUMN_NAME_SIZE bytes
+///   records  each starts on an 8 byte boundary with kind and count
+///     ROWS     count rows, the values stored column after column,
+///              count doubles per column
+///     VEHICLE  id, name length, reserved, the name padded to 8 bytes
+/// The file is only appended to. It grows in GROW_SIZE steps and the space
+/// not written yet is zero, a kind of 0 ends the log. A log whose writer
+/// did not close it is still read up to its last whole record.
+struct FlightLog
+{
+  static const char MAGIC[8];
+  static const uint32_t VERSION = 1;
+  static const unsigned COLUMN_NAME_SIZE = 16;
+  static const std::size_t GROW_SIZE = 16 << 20;
+
+  enum Kind {
+      END = 0,
+      ROWS = 1,
+      VEHICLE = 2
+  };
+};
+
+/// \brief Appends records to a flight log through a shared memory map.
+/// Not thread safe, FlightRecorder calls it from its writer thread only.
+class FlightLogWriter
+{
+  public: FlightLogWriter();
+  public: ~FlightLogWriter();
+
+  /// \brief Create or truncate _path and write the header
+  /// \return false if the file cannot be created or mapped
+  public: bool Open(const std::string &_path, const std::vector<std::string> &_columns);
+
+  public: bool IsOpen() const;
+
+  /// \brief Name the vehicle that rows with _id in their vehicle column belong to
+  public: bool AppendVehicle(uint32_t _id, const std::string &_name);
+
+  /// \brief Append _rows rows, value of column c and row r at _values[c * _stride + r]
+  public: bool AppendRows(const double* _values, unsigned _rows, unsigned _stride);
+
+  /// \brief Cut the file to the written size and close it
+  public: void Close();
+
+  /// \brief bytes written so far
+  public: std::size_t Size() const;
+
+  /// \brief Make room for _bytes more, growing and remapping the file
+  private: bool Reserve(std::size_t _bytes);
+  private: void Write(const void* _data, std::size_t _bytes);
+
+  private: int fd_;
+  private: char* map_;
+  private: std::size_t mapped_;
+  private: std::size_t size_;
+  private: unsigned columns_;
+};
+
+/// \brief Read access to a flight log, the whole file mapped read only.
+/// Values are used in place, Data points into the map.
+class FlightLogReader
+{
+  public: FlightLogReader();
+  public: ~FlightLogReader();
+
+  /// \brief Map _path and index its records
+  /// \return false if it is not a flight log
+  public: bool Open(const std::string &_path);
+  public: void Close();
+
+  public: const std::vector<std::string>& Columns() const;
+  /// \brief index of the column called _name, -1 if there is none
+  public: int Column(const std::string &_name) const;
+
+  /// \brief ROWS records of the log
+  public: unsigned BlockCount() const;
+  public: unsigned BlockRows(unsigned _block) const;
+  public: std::size_t RowCount() const;
+
+  /// \brief the BlockRows(_block) values of _column in _block
+  public: const double* Data(unsigned _block, unsigned _column) const;
+
+  /// \brief every value of _column, block after block
+  public: std::vector<double> Read(unsigned _column) const;
+
+  /// \brief vehicle names by id
+  public: const std::map<uint32_t, std::string>& Vehicles() const;
+  /// \brief name of the vehicle _id, its number if the log does not name it
+  public: std::string VehicleName(uint32_t _id) const;
+
+  private: struct Block
+  {
+      unsigned rows;
+      const double* data;
+  };
+
+  private: int fd_;
+  private: const char* map_;
+  private: std::size_t mapped_;
+  private: std::vector<std::string> columns_;
+  private: std::vector<Block> blocks_;
+  private: std::size_t rows_;
+  private: std::map<uint32_t, std::string> vehicles_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_LOG_H_ */
@@ -0,0 +1,123 @@
+/*
+ * flight_recorder.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_RECORDER_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_RECORDER_H_
+
+#include <suruiha_gazebo_plugins/flight_log.h>
+#include <suruiha_gazebo_plugins/spsc_ring.h>
+#include <suruiha_gazebo_plugins/vehicle_state.h>
+#include <sdf/sdf.hh>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief One row of the flight log, the state of a vehicle after a step.
+/// Actuators are the rotors of an iris or the controlled joints of a
+/// zephyr, in bank or <joint_control> order. Columns a vehicle does not
+/// have, e.g. the PID terms of an effort joint, are NaN.
+struct FlightSample
+{
+  static const unsigned ACTUATORS = 4;
+
+  enum Column {
+      TIME,
+      VEHICLE,
+      /// \brief 1 if the controller ran in this step, 0 if it held its forces
+      TICK,
+      X, Y, Z,
+      QW, QX, QY, QZ,
+      /// \brief linear velocity in the world frame
+      VX, VY, VZ,
+      /// \brief angular velocity in the body frame
+      P, Q, R,
+      /// \brief rotor command of the mixer, or joint command
+      CMD,
+      /// \brief proportional, integral and derivative error of the actuator PID
+      P_ERR = CMD + ACTUATORS,
+      I_ERR = P_ERR + ACTUATORS,
+      D_ERR = I_ERR + ACTUATORS,
+      COLUMN_COUNT = D_ERR + ACTUATORS
+  };
+
+  /// \brief names of the columns in the log, cmd0, cmd1, ... per actuator
+  static std::vector<std::string> ColumnNames();
+
+  /// \brief time, pose and velocities from _state, actuators NaN
+  void SetState(uint32_t _vehicle, const VehicleState &_state, bool _tick);
+
+  double values[COLUMN_COUNT];
+};
+
+/// \brief Records the state of every vehicle of a controller in a flight log.
+/// Record copies the sample into a ring and returns, a writer thread moves
+/// the samples from the ring into blocks of the log file, see FlightLog.
+/// A full ring drops samples instead of stalling the physics thread, the
+/// number of dropped samples is reported when the log is closed.
+/// Only one thread may call Record, the world update thread.
+class FlightRecorder
+{
+  public: FlightRecorder();
+  public: ~FlightRecorder();
+
+  /// \brief Open <recordFile> if the controller sdf has one.
+  /// <recordBuffer> is the number of samples the ring holds.
+  /// \return false if there is no <recordFile> or it cannot be opened
+  public: bool Load(sdf::ElementPtr _sdf);
+
+  /// \brief Create the log and start the writer thread
+  public: bool Open(const std::string &_path, unsigned _bufferSamples = 1 << 14);
+
+  /// \brief Write what is still in the ring and close the log
+  public: void Close();
+
+  public: bool IsOpen() const;
+
+  /// \brief Id of the vehicle called _name, written to the log
+  /// before any of its samples
+  public: uint32_t AddVehicle(const std::string &_name);
+
+  /// \brief Queue a sample, never blocks
+  /// \return false if the ring is full and the sample is dropped
+  public: bool Record(const FlightSample &_sample) {
+      if (ring_.Push(_sample)) {
+          return true;
+      }
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+  }
+
+  public: unsigned long Dropped() const;
+
+  /// \brief rows of one block of the log
+  public: static const unsigned BLOCK_ROWS = 512;
+
+  private: void WriterThread();
+  /// \brief Append the pending vehicles and the staged rows as one block
+  private: void WriteBlock();
+
+  private: SpscRing<FlightSample> ring_;
+  private: std::atomic<unsigned long> dropped_;
+  private: std::atomic<bool> running_;
+  private: boost::thread writer_thread_;
+  private: FlightLogWriter writer_;
+  private: std::string path_;
+
+  /// \brief name of every vehicle by id and the ids not written to the
+  /// log yet, guarded by vehicles_mutex_
+  private: boost::mutex vehicles_mutex_;
+  private: std::vector<std::string> vehicles_;
+  private: std::vector<uint32_t> pendingVehicles_;
+
+  /// \brief rows taken from the ring, column after column, writer thread only
+  private: std::vector<double> staged_;
+  private: unsigned stagedRows_;
+  /// \brief a write failed, reported once
+  private: bool writeFailed_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_FLIGHT_RECORDER_H_ */
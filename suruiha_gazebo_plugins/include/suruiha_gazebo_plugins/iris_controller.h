@@ -3,15 +3,14 @@
 
 #include <ros/ros.h>
 #include <sensor_msgs/JointState.h>
-#include <ros/callback_queue.h>
 
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/physics/physics.hh>
 #include <gazebo/transport/TransportTypes.hh>
 #include <gazebo/common/Time.hh>
 #include <gazebo/common/Events.hh>
-#include <suruiha_gazebo_plugins/rotor_control.h>
-#include <vector>
+#include <suruiha_gazebo_plugins/iris_vehicle.h>
+#include <suruiha_gazebo_plugins/callback_dispatcher.h>
 
 namespace gazebo
 {
@@ -28,32 +27,20 @@ namespace gazebo
 		private: physics::ModelPtr model_;
 		
 		private: std::string robot_namespace_;
-//		private: std::string user_command_topic_name_;
 		private: ros::NodeHandle* rosnode_;
-        private: ros::Subscriber control_twist_sub_;
-//        private: ros::Subscriber user_command_sub_;
-        private: ros::Publisher pose_pub_;
-//	    private: sensor_msgs::JointState last_joint_states_;
-        private: double targetThrottle;
-        private: double targetPitch;
-        private: double targetRoll;
-        private: double targetYaw;
-
-        private: std::vector<RotorControl*> rotors_;
+        private: IrisVehicle vehicle_;
+        private: RotorBank rotors_;
+        /// \brief slot in the swarm, -1 if this plugin runs the vehicle itself
+        private: int swarmSlot_;
 	    private: void SetControl(const geometry_msgs::Twist::ConstPtr& control);
-//	    private: void ProcessUserCommand(const std_msgs::String::ConstPtr& user_command);
-	    private: void CalculateRotors(double targetThrottle, double targetPitch, double targetRoll,
-	    		double targetYaw, common::Time dt);
+	    private: void SetControlStamped(const geometry_msgs::TwistStamped::ConstPtr& _control);
 
-		private: boost::mutex update_mutex_;
-		private: ros::CallbackQueue queue_;
-		private: boost::thread callback_queue_thread_;
-	    private: void QueueThread();
-
-        private: common::Time lastUpdateTime;
-
-        private: common::Time lastPosePublishTime;
-        private: int poseUpdateRate;
+		private: CallbackDispatcher dispatcher_;
+		/// \brief flight log of the vehicle if the sdf has a <recordFile>
+		private: FlightRecorder recorder_;
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+		private: StepProfiler profiler_;
+#endif
 
 	};
 }
@@ -0,0 +1,169 @@
+/*
+ * iris_vehicle.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_IRIS_VEHICLE_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_IRIS_VEHICLE_H_
+
+#include <ros/ros.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/TwistStamped.h>
+
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/Time.hh>
+#include <suruiha_gazebo_plugins/rotor_bank.h>
+#include <suruiha_gazebo_plugins/lift_drag_bank.h>
+#include <suruiha_gazebo_plugins/command_mailbox.h>
+#include <suruiha_gazebo_plugins/command_schedule.h>
+#include <suruiha_gazebo_plugins/control_clock.h>
+#include <suruiha_gazebo_plugins/vehicle_state.h>
+#include <suruiha_gazebo_plugins/step_profiler.h>
+#include <suruiha_gazebo_plugins/flight_recorder.h>
+#include <suruiha_gazebo_plugins/position_hold.h>
+#include <suruiha_gazebo_plugins/VehicleHandoff.h>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Targets of the last control message of an iris
+struct IrisTargets
+{
+  double throttle;
+  double pitch;
+  double roll;
+  double yaw;
+};
+
+/// \brief Controller state of one iris quadrotor.
+/// It holds no thread or node handle of its own so that it can be owned
+/// either by a standalone IrisController or by the SwarmController.
+class IrisVehicle
+{
+  public: IrisVehicle();
+
+  /// \brief Add the rotors of the IrisConfig of the plugin sdf to the bank
+  /// and the <lift_drag> elements to liftDrag. A <positionHold> element
+  /// turns the onboard hold on.
+  /// \return false if the vehicle cannot be controlled
+  public: bool Load(physics::ModelPtr _model, sdf::ElementPtr _sdf, RotorBank* _bank);
+
+  /// \brief Release the rotors, the vehicle must not be updated afterwards
+  public: void Unload();
+
+  /// \brief Hand new targets to the next Prepare, never blocks, or a new
+  /// setpoint with the onboard hold. Called from the ros callback thread.
+  public: void SetControl(const geometry_msgs::Twist &_control);
+
+  /// \brief Queue targets until the sim time of their stamp, lockstep mode only.
+  /// Called from the world update thread, see CommandSchedule.
+  public: void SetControlStamped(const geometry_msgs::TwistStamped &_control,
+          const common::Time &_now);
+
+  /// \brief <name>_control, or <name>_control_stamped in lockstep mode
+  public: std::string ControlTopic() const;
+
+  /// \brief Write the model, targets, setpoint and the state of the rotor
+  /// and hold PIDs into _msg, all but its regions and model_sdf.
+  /// Called from the world update thread, the reader of the mailboxes.
+  public: void Export(suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Continue the flight exported into _msg by a vehicle of the same sdf.
+  /// Called from the world update thread before the control topic is subscribed,
+  /// the mailboxes have no other writer then. Commands waiting in the lockstep
+  /// schedules of the sender are not part of it.
+  /// \return false if _msg has another rotor or hold layout, nothing is restored then
+  public: bool Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Publish the pose and apply rotor forces for one world step,
+  /// same as Prepare, RotorBank::Mix and Actuate
+  public: void Update(const common::Time &_currTime);
+
+  /// \brief Read the state, publish the pose and set the mixer input of the vehicle.
+  /// A swarm prepares every vehicle, mixes the shared bank once
+  /// and then actuates every vehicle.
+  public: void Prepare(const common::Time &_currTime);
+
+  /// \brief Apply the rotor forces computed by the last RotorBank::Mix,
+  /// or hold the previous ones between two control ticks, and the lift
+  /// and drag of the blades. The step is then recorded if there is a recorder.
+  public: void Actuate();
+
+  /// \brief Set the mixer inputs from the state of this step, called by Prepare.
+  /// Public so that a step can be driven without a control publisher, e.g. by the benchmarks.
+  public: void CalculateRotors(double targetThrottle, double targetPitch, double targetRoll,
+          double targetYaw);
+
+  private: void PublishPose(const common::Time &_currTime);
+  /// \brief Hand the state, rotor commands and PID errors of this step to the recorder
+  private: void Record();
+
+  /// \brief name of the model, prefix of the pose and control topics
+  public: std::string name;
+  public: physics::ModelPtr model;
+
+  public: ros::Subscriber controlSub;
+  public: ros::Publisher posePub;
+
+  /// \brief written by SetControl, read once per step by Prepare
+  public: CommandMailbox<IrisTargets> command;
+
+  /// \brief apply only commands stamped with a sim time that has been reached
+  public: bool lockstep;
+  public: CommandSchedule<IrisTargets> schedule;
+
+  /// \brief control messages are setpoints of hold, written by SetControl
+  /// into setpoint, or by Prepare from holdSchedule in lockstep mode.
+  /// The vehicle keeps holding the last one once its publisher is gone.
+  public: bool onboardHold;
+  public: PositionHold hold;
+  public: CommandMailbox<IrisSetpoint> setpoint;
+  public: CommandSchedule<IrisSetpoint> holdSchedule;
+
+  /// \brief targets in use for the current step
+  public: double targetThrottle;
+  public: double targetPitch;
+  public: double targetRoll;
+  public: double targetYaw;
+
+  /// \brief bank holding the rotors, not owned
+  public: RotorBank* bank;
+  public: int bankIndex;
+  /// \brief rotor joints in bank order, read into state every step
+  public: std::vector<physics::JointPtr> rotorJoints;
+
+  /// \brief blades of the vehicle, applied every step whether the
+  /// controller runs or not
+  public: LiftDragBank liftDrag;
+
+  /// \brief snapshot of the current step
+  public: VehicleState state;
+  public: ControllerStats stats;
+  /// \brief sim time between two stats reports, 0 for none
+  public: common::Time statsInterval;
+  /// \brief step timings, not owned, nullptr unless instrumented
+  public: StepProfiler* profiler;
+  /// \brief flight log, not owned, nullptr if the flight is not recorded
+  public: FlightRecorder* recorder;
+  public: uint32_t recordId;
+  /// \brief <recordRate> of the samples, every step by default
+  public: ControlClock recordClock;
+
+  /// \brief pitch angle the vehicle hovers level at
+  public: double pitchOffset;
+
+  /// \brief whether the vehicle is controlled at all, whether the last Prepare
+  /// ran the controller, and the time since the previous run
+  public: bool controlActive;
+  public: bool controlTick;
+  public: common::Time controlDt;
+  /// \brief rate of the controller, the rotor forces are held in between
+  public: ControlClock controlClock;
+
+  /// \brief last time the controller ran, or the last step without control
+  public: common::Time lastUpdateTime;
+  public: common::Time lastPosePublishTime;
+  public: int poseUpdateRate;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_IRIS_VEHICLE_H_ */
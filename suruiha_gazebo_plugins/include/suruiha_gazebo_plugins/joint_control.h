@@ -6,37 +6,175 @@
 #define SURUIHA_GAZEBO_PLUGINS_JOINT_CONTROL_H
 
 #include <string>
+#include <vector>
 #include <gazebo/physics/Joint.hh>
 #include <gazebo/common/Time.hh>
 #include <gazebo/common/PID.hh>
+#include <suruiha_gazebo_plugins/pid_bank.h>
 
 namespace gazebo
 {
-    class JointControl
+    /// \brief How a joint follows its command, fixed when the sdf is loaded
+    enum JointType {
+        POSITION,
+        VELOCITY,
+        EFFORT
+    };
+
+    /// \brief Parse position, velocity or effort
+    /// \return false for any other name
+    bool JointTypeFromString(const std::string &_name, JointType &_type);
+
+    /// \brief PID of a joint that has no gains in the sdf
+    common::PID DefaultJointPid();
+
+    /// \brief What a joint of type TYPE feeds to its PID, or the force itself
+    /// for effort joints. One specialization per type so that JointArray
+    /// never branches on it.
+    template <JointType TYPE> struct JointTraits;
+
+    template <> struct JointTraits<POSITION>
     {
-        enum JointType {
-            POSITION,
-            VELOCITY,
-            EFFORT
-        };
+        static const bool USES_PID = true;
+        static double Input(double _cmd, double _pos, double /*_vel*/) {
+            return _pos - _cmd;
+        }
+    };
+
+    template <> struct JointTraits<VELOCITY>
+    {
+        static const bool USES_PID = true;
+        static double Input(double _cmd, double /*_pos*/, double _vel) {
+            return _vel - _cmd;
+        }
+    };
+
+    template <> struct JointTraits<EFFORT>
+    {
+        static const bool USES_PID = false;
+        static double Input(double _cmd, double /*_pos*/, double /*_vel*/) {
+            return _cmd;
+        }
+    };
+
+    /// \brief Every joint of one type of a vehicle, updated in one loop
+    /// and one PidBank::Update.
+    /// Commands, positions and velocities are indexed by the joint index of
+    /// the vehicle, see JointBank.
+    template <JointType TYPE>
+    class JointArray
+    {
+        public: void Add(const std::string &_name, physics::JointPtr _joint,
+                const common::PID &_pid, unsigned _index) {
+            names.push_back(_name);
+            joints.push_back(_joint);
+            if (JointTraits<TYPE>::USES_PID) {
+                pid.Add(_pid);
+            }
+            index.push_back(_index);
+            input.push_back(0.0);
+            dt.push_back(0.0);
+            force.push_back(0.0);
+        }
+
+        public: void Update(const common::Time &_dt, const std::vector<double> &_commands,
+                const std::vector<double> &_positions, const std::vector<double> &_velocities) {
+            const unsigned n = joints.size();
+            const double step = _dt.Double();
+            for (unsigned i = 0; i < n; ++i) {
+                const unsigned j = index[i];
+                input[i] = JointTraits<TYPE>::Input(_commands[j], _positions[j], _velocities[j]);
+                dt[i] = step;
+            }
+
+            const double* out = input.data();
+            if (JointTraits<TYPE>::USES_PID) {
+                pid.Update(input.data(), dt.data(), force.data());
+                out = force.data();
+            }
+            for (unsigned i = 0; i < n; ++i) {
+                joints[i]->SetForce(0, out[i]);
+            }
+        }
+
+        /// \brief Apply the forces of the last Update again
+        public: void Hold() {
+            const double* out = JointTraits<TYPE>::USES_PID ? force.data() : input.data();
+            const unsigned n = joints.size();
+            for (unsigned i = 0; i < n; ++i) {
+                joints[i]->SetForce(0, out[i]);
+            }
+        }
+
+        public: unsigned Size() const {
+            return joints.size();
+        }
+
+        public: void Clear() {
+            names.clear();
+            joints.clear();
+            pid.Clear();
+            index.clear();
+            input.clear();
+            dt.clear();
+            force.clear();
+        }
+
+        public: std::vector<std::string> names;
+        public: std::vector<physics::JointPtr> joints;
+        /// \brief empty for effort joints
+        public: PidBank pid;
+        /// \brief joint index in the vehicle
+        public: std::vector<unsigned> index;
+
+        /// \brief scratch of Update, PID input, step and force of every joint
+        private: std::vector<double> input;
+        private: std::vector<double> dt;
+        private: std::vector<double> force;
+    };
+
+    /// \brief Controlled joints of a vehicle kept by value in one array per type.
+    /// Joints are numbered in the order they are added, the order of the
+    /// <joint_control> elements, and that is also the order of the state the
+    /// vehicle reads every step.
+    class JointBank
+    {
+        /// \brief Add a joint of the given type, _type as in the sdf.
+        /// Unknown types are controlled by effort.
+        public: void Add(const std::string &_name, const std::string &_type,
+                physics::JointPtr _joint, const common::PID &_pid);
+
+        /// \brief Add a joint of a type already parsed, e.g. by ZephyrConfig
+        public: void Add(const std::string &_name, JointType _type,
+                physics::JointPtr _joint, const common::PID &_pid);
 
-        public: JointControl();
-        public: virtual ~JointControl();
-        public: std::string jointName;
-        public: JointControl::JointType jointType;
-        public: physics::JointPtr joint;
+        public: void SetCommand(unsigned _joint, double _command) {
+            commands[_joint] = _command;
+        }
 
-        private: common::PID pid;
+        /// \brief Apply the commands, one loop per joint type
+        public: void Update(const common::Time &_dt,
+                const std::vector<double> &_positions, const std::vector<double> &_velocities) {
+            position.Update(_dt, commands, _positions, _velocities);
+            velocity.Update(_dt, commands, _positions, _velocities);
+            effort.Update(_dt, commands, _positions, _velocities);
+        }
 
-        public: void SetJointType(std::string jointTypeString);
-        public: void SetPIDParams(double p, double i, double d, double imax, double imin, double cmdMax, double cmdMin);
-        public: void SetCommand(double cmd, common::Time dt_);
+        /// \brief Apply the forces of the last Update again
+        public: void Hold() {
+            position.Hold();
+            velocity.Hold();
+            effort.Hold();
+        }
 
-        private: void SetPosition(double position, common::Time dt_);
-        private: void SetVelocity(double velocity, common::Time dt_);
-        private: void SetEffort(double force);
+        public: unsigned Size() const;
+        public: void Clear();
 
-        private: void ApplyForce(double force);
+        public: JointArray<POSITION> position;
+        public: JointArray<VELOCITY> velocity;
+        public: JointArray<EFFORT> effort;
+        /// \brief last command of every joint
+        public: std::vector<double> commands;
     };
 }
 
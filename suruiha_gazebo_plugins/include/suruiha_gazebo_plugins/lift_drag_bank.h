@@ -0,0 +1,70 @@
+/*
+ * lift_drag_bank.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_BANK_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_BANK_H_
+
+#include <gazebo/physics/physics.hh>
+#include <ignition/math.hh>
+#include <sdf/sdf.hh>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Lift and drag of many surfaces, the model of gazebo's LiftDragPlugin
+/// for all blades and wings of a vehicle in one pass.
+/// Every surface takes the parameters of a LiftDragPlugin sdf. The state of a
+/// link is read once per Update however many surfaces it carries, and the
+/// velocity at the centre of pressure is computed from it.
+class LiftDragBank
+{
+  /// \brief Add one surface, _sdf holds a0, cla, cda, ..., link_name and
+  /// optionally control_joint_name as for LiftDragPlugin.
+  /// \return false if the link or the control joint is not found
+  public: bool Add(physics::ModelPtr _model, sdf::ElementPtr _sdf);
+
+  /// \brief Add every _element child of _sdf
+  /// \return false if one of them is not added
+  public: bool Load(physics::ModelPtr _model, sdf::ElementPtr _sdf, const std::string &_element);
+
+  /// \brief Apply lift and drag of every surface for one step
+  public: void Update();
+
+  public: unsigned Size() const;
+  public: void Clear();
+
+  /// \brief surface parameters, one entry per surface
+  public: std::vector<std::string> names;
+  /// \brief index into links of the link the surface is attached to
+  public: std::vector<unsigned> link;
+  /// \brief centre of pressure, forward and upward direction in the link frame
+  public: std::vector<ignition::math::Vector3d> cp;
+  public: std::vector<ignition::math::Vector3d> forward;
+  public: std::vector<ignition::math::Vector3d> upward;
+  /// \brief upward follows the inflow, for propeller blades
+  public: std::vector<bool> radialSymmetry;
+  public: std::vector<double> alpha0;
+  public: std::vector<double> cla;
+  public: std::vector<double> cda;
+  public: std::vector<double> alphaStall;
+  public: std::vector<double> claStall;
+  public: std::vector<double> cdaStall;
+  /// \brief area times half the air density
+  public: std::vector<double> halfRhoArea;
+  /// \brief joint whose angle adds to the lift coefficient, may be null
+  public: std::vector<physics::JointPtr> controlJoint;
+  public: std::vector<double> controlJointRadToCL;
+
+  /// \brief links carrying a surface and their centres of gravity
+  public: std::vector<physics::LinkPtr> links;
+  public: std::vector<ignition::math::Vector3d> linkCoG;
+
+  /// \brief scratch of Update, state of every link
+  private: std::vector<ignition::math::Pose3d> pose_;
+  private: std::vector<ignition::math::Vector3d> vel_;
+  private: std::vector<ignition::math::Vector3d> angularVel_;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_BANK_H_ */
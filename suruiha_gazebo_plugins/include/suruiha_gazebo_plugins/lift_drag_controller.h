@@ -0,0 +1,31 @@
+/*
+ * lift_drag_controller.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_CONTROLLER_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_CONTROLLER_H_
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/physics.hh>
+#include <suruiha_gazebo_plugins/lift_drag_bank.h>
+
+namespace gazebo
+{
+	/// \brief Model plugin applying the lift and drag of every <surface> of
+	/// its sdf from one update hook, in place of one LiftDragPlugin per surface.
+	/// Each <surface> takes the elements of a LiftDragPlugin. An iris takes
+	/// its blades as <lift_drag> elements of the iris_controller instead.
+	class LiftDragController : public ModelPlugin
+	{
+		public: virtual ~LiftDragController();
+
+		public: void Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf);
+		protected: virtual void UpdateStates();
+		private: event::ConnectionPtr update_connection_;
+
+		private: LiftDragBank surfaces_;
+	};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_LIFT_DRAG_CONTROLLER_H_ */
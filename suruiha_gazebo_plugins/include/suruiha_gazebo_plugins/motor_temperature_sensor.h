@@ -0,0 +1,66 @@
+/*
+ * motor_temperature_sensor.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_MOTOR_TEMPERATURE_SENSOR_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_MOTOR_TEMPERATURE_SENSOR_H_
+
+#include <ros/ros.h>
+#include <std_msgs/UInt8MultiArray.h>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/physics.hh>
+#include <uav_ground_control/telemetry_protocol.h>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+	/// \brief Model plugin standing in for the DS18B20 probes on the motors.
+	/// Every <motor> joint heats with the square of its velocity and cools
+	/// towards <ambient>:
+	///   dT/dt = heating * w^2 - cooling * (T - ambient)
+	/// The temperatures are sampled at <sampleRate> Hz in 1/16 degC like the
+	/// sensors read them, and every <batch> rows go out as one frame of
+	/// uav_ground_control/telemetry_protocol.h on <topic>, <model>_telemetry
+	/// by default. The ground control decodes it like the frames of the MCU.
+	class MotorTemperatureSensor : public ModelPlugin
+	{
+		public: MotorTemperatureSensor();
+		public: virtual ~MotorTemperatureSensor();
+
+		public: void Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf);
+		protected: virtual void UpdateStates();
+
+		/// \brief send the rows sampled so far as one frame
+		private: void Publish();
+
+		private: event::ConnectionPtr update_connection_;
+		private: physics::WorldPtr world_;
+		private: ros::NodeHandle* rosnode_;
+		private: ros::Publisher telemetryPub_;
+
+		private: std::vector<physics::JointPtr> motors_;
+		/// \brief temperature of every motor in degC
+		private: std::vector<double> temperatures_;
+		private: double ambient_;
+		private: double heating_;
+		private: double cooling_;
+
+		private: common::Time lastUpdateTime_;
+		private: common::Time samplePeriod_;
+		private: common::Time nextSample_;
+		private: unsigned batch_;
+
+		/// \brief rows of the next frame, motor after motor, and the time of its first row
+		private: std::vector<int16_t> rows_;
+		private: unsigned rowCount_;
+		private: uint32_t firstRowMs_;
+		private: uint8_t sequence_;
+		/// \brief reused for every frame, its data keeps its capacity
+		private: std_msgs::UInt8MultiArray msg_;
+		private: uint8_t frame_[TELEMETRY_MAX_FRAME];
+	};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_MOTOR_TEMPERATURE_SENSOR_H_ */
@@ -0,0 +1,56 @@
+/*
+ * pid_bank.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_PID_BANK_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_PID_BANK_H_
+
+#include <gazebo/common/PID.hh>
+#include <vector>
+
+namespace gazebo {
+/// \brief Many PID controllers kept as structure of arrays and updated in one call.
+/// Update gives the same commands as common::PID::Update of gazebo 9, bit for
+/// bit, as long as pid_bank.cpp and gazebo are built without fused multiply-add
+/// contraction (pid_bank.cpp always is). With AVX2 four controllers are
+/// updated per instruction, two with NEON on aarch64, else one at a time.
+class PidBank
+{
+  /// \brief Append a controller with the gains, limits and errors of _pid
+  /// \return its index
+  public: unsigned Add(const common::PID &_pid);
+
+  /// \brief Drop _count controllers starting at _first
+  public: void Erase(unsigned _first, unsigned _count);
+
+  public: void Clear();
+
+  public: unsigned Size() const;
+
+  /// \brief For every controller i, _cmd[i] = common::PID::Update(_error[i], _dt[i]).
+  /// A zero _dt or an error that is not finite gives 0 and leaves the controller as is.
+  public: void Update(const double* _error, const double* _dt, double* _cmd);
+
+  /// \brief name of the kernel Update uses, avx2, neon or scalar
+  public: static const char* Kernel();
+
+  /// \brief gains and integral limits as in common::PID
+  public: std::vector<double> pGain;
+  public: std::vector<double> iGain;
+  public: std::vector<double> dGain;
+  public: std::vector<double> iMax;
+  public: std::vector<double> iMin;
+  /// \brief command limits, infinite where common::PID has 0 for no limit
+  public: std::vector<double> cmdMax;
+  public: std::vector<double> cmdMin;
+
+  /// \brief integral error, last proportional error, derivative error
+  /// and last command of every controller
+  public: std::vector<double> iErr;
+  public: std::vector<double> pErrLast;
+  public: std::vector<double> dErr;
+  public: std::vector<double> cmd;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_PID_BANK_H_ */
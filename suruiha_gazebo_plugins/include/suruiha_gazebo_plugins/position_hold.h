@@ -0,0 +1,74 @@
+/*
+ * position_hold.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_POSITION_HOLD_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_POSITION_HOLD_H_
+
+#include <suruiha_gazebo_plugins/pid_bank.h>
+#include <suruiha_gazebo_plugins/vehicle_state.h>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+/// \brief Position an iris has to hold, from linear and angular.z of a
+/// control message when the vehicle runs a PositionHold
+struct IrisSetpoint
+{
+  IrisSetpoint() : x(0), y(0), z(0), yaw(0), valid(false) {
+  }
+
+  /// \brief world position in meters and heading in radians
+  double x;
+  double y;
+  double z;
+  double yaw;
+  /// \brief false until the first setpoint is received
+  bool valid;
+};
+
+/// \brief Cascaded position hold of an iris, run on the control ticks of
+/// the vehicle so that the outer loops do not wait for a pose to go out
+/// and a control message to come back.
+/// The position error gives a velocity setpoint, limited to <maxSpeed>
+/// horizontally and <maxClimb> vertically. The velocity error goes through
+/// one PID per axis to a tilt in the heading frame, limited to <maxTilt>,
+/// and to a throttle around <hoverThrottle>. These are the throttle, pitch,
+/// roll and yaw targets the mixer holds otherwise for a control message.
+class PositionHold
+{
+  public: PositionHold();
+
+  /// \brief Read the gains of a <positionHold> element, missing ones keep
+  /// their defaults
+  public: void Load(sdf::ElementPtr _sdf);
+
+  /// \brief Clear the integrators
+  public: void Reset();
+
+  /// \brief Targets of the attitude loop for the state of this step,
+  /// _dt seconds after the previous
+  public: void Update(const VehicleState &_state, const IrisSetpoint &_setpoint, double _dt,
+          double &_throttle, double &_pitch, double &_roll, double &_yaw);
+
+  /// \brief Replace the controllers, the tilt gains serve both FORWARD and LEFT
+  private: void SetLoops(const common::PID &_tilt, const common::PID &_climb);
+
+  /// \brief velocity setpoint per meter of position error
+  public: double positionGain;
+  public: double altitudeGain;
+  /// \brief limits of the velocity setpoint in m/s
+  public: double maxSpeed;
+  public: double maxClimb;
+  /// \brief throttle that about holds the weight of the vehicle
+  public: double hoverThrottle;
+
+  /// \brief the loops of pid, forward and left velocity to pitch and roll,
+  /// vertical velocity to throttle, each limited to its output range
+  public: enum Loop { FORWARD, LEFT, CLIMB, LOOPS };
+  /// \brief a bank so that the integrators can be read and restored,
+  /// see Handoff
+  public: PidBank pid;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_POSITION_HOLD_H_ */
@@ -0,0 +1,108 @@
+/*
+ * region_partition.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_REGION_PARTITION_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_REGION_PARTITION_H_
+
+#include <ros/ros.h>
+#include <suruiha_gazebo_plugins/VehicleHandoff.h>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/common/Time.hh>
+#include <gazebo/physics/physics.hh>
+#include <gazebo/transport/transport.hh>
+#include <sdf/sdf.hh>
+#include <boost/thread/mutex.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+	/// \brief World plugin that runs one region of a world split over several
+	/// gzservers, on one host or many sharing a ROS master.
+	/// Every server loads the same world, scenery and vehicles included, with
+	/// its own <self> region, or the ~region parameter of its gazebo node.
+	/// A vehicle belongs to the first <region> whose box holds its x y
+	/// position, else to the nearest one. At the first check every server
+	/// removes the vehicles of the other regions.
+	///
+	/// A vehicle that flies more than <margin> out of the region is exported
+	/// by the swarm_controller with its targets and PID state, its model is
+	/// removed and the whole is published on <handoffTopic>/<region> of the
+	/// region it flew into. That server spawns the model where it left, the
+	/// swarm keeps it parked until the state is restored, and then subscribes
+	/// and advertises the same <model>_control and <model>_pose topics.
+	/// A vehicle stays put while nobody listens on its target topic.
+	///
+	///   <region><min>-500 -500</min><max>0 500</max></region>
+	///   <region><min>0 -500</min><max>500 500</max></region>
+	///   <self>0</self> <margin>5</margin> <checkRate>10</checkRate>
+	class RegionPartition : public WorldPlugin
+	{
+		public: RegionPartition();
+		public: virtual ~RegionPartition();
+
+		public: void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+		protected: virtual void UpdateStates();
+
+		/// \brief x y box of a region
+		private: struct Region
+		{
+			ignition::math::Vector2d min;
+			ignition::math::Vector2d max;
+		};
+
+		/// \brief a vehicle spawned from a handoff, waiting for its plugin
+		private: struct Arrival
+		{
+			suruiha_gazebo_plugins::VehicleHandoffConstPtr msg;
+			common::Time start;
+		};
+
+		/// \brief region _position belongs to
+		private: unsigned Owner(const ignition::math::Vector3d &_position) const;
+		/// \brief distance of _position to the box of _region, 0 inside
+		private: double Distance(unsigned _region, const ignition::math::Vector3d &_position) const;
+		/// \brief Hand off or drop the vehicles of this world that left it
+		private: void CheckVehicles();
+		private: void HandOff(const std::string &_name, unsigned _region);
+		/// \brief Remove the top level model of _model, through the request
+		/// topic of the world so that it is not deleted in the middle of a step
+		private: void RemoveModel(physics::ModelPtr _model);
+		/// \brief Spawn the received vehicles and import those that are loaded
+		private: void ReceiveArrivals();
+		private: void Spawn(const suruiha_gazebo_plugins::VehicleHandoffConstPtr &_msg);
+		private: void HandoffCallback(const suruiha_gazebo_plugins::VehicleHandoffConstPtr &_msg);
+
+		private: event::ConnectionPtr update_connection_;
+		private: physics::WorldPtr world_;
+		private: ros::NodeHandle* rosnode_;
+		private: transport::NodePtr node_;
+		/// \brief one publisher per region, none for this one
+		private: std::vector<ros::Publisher> handoffPubs_;
+		private: ros::Subscriber handoffSub_;
+
+		private: std::vector<Region> regions_;
+		private: unsigned self_;
+		/// \brief meters a vehicle may fly out of the region before it is handed off
+		private: double margin_;
+		/// \brief sim time between two checks
+		private: common::Time checkPeriod_;
+		private: common::Time lastCheck_;
+		/// \brief the vehicles of the world file have been sorted out
+		private: bool started_;
+		/// \brief wall time to wait for a received vehicle to load
+		private: double handoffTimeout_;
+
+		/// \brief received on the handoff topic, taken by the update hook
+		private: boost::mutex receiveMutex_;
+		private: std::vector<suruiha_gazebo_plugins::VehicleHandoffConstPtr> received_;
+		private: std::vector<Arrival> arrivals_;
+		/// \brief vehicles warned about while their target region is not listening
+		private: std::set<std::string> waiting_;
+	};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_REGION_PARTITION_H_ */
@@ -0,0 +1,112 @@
+/*
+ * rotor_bank.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_ROTOR_BANK_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_ROTOR_BANK_H_
+
+#include <gazebo/common/PID.hh>
+#include <gazebo/common/Time.hh>
+#include <gazebo/physics/Joint.hh>
+#include <suruiha_gazebo_plugins/rotor_control.h>
+#include <suruiha_gazebo_plugins/pid_bank.h>
+#include <vector>
+
+namespace gazebo {
+/// \brief Rotors of one or more vehicles kept as structure of arrays.
+/// The rotors of a vehicle are stored next to each other. Every rotor has a
+/// row of the mixer matrix, so all rotor commands are computed as
+///   cmd = trim * throttle * (1 + mixPitch * pitch) * (1 + mixRoll * roll) * (1 + mixYaw * yaw)
+/// in one pass over the bank, whatever the number of rotors per vehicle,
+/// and the velocity PIDs of every rotor in one PidBank::Update.
+class RotorBank
+{
+  /// \brief Reserve a vehicle index, its rotors are added with AddRotor
+  public: int AddVehicle();
+
+  /// \brief Append a rotor of the vehicle,
+  /// rotors of one vehicle must be added one after another
+  public: void AddRotor(int _vehicle, const RotorControl &_rotor);
+
+  /// \brief Drop the rotors of the vehicle, the index may be reused
+  public: void RemoveVehicle(int _vehicle);
+
+  /// \brief Set the mixer input of the vehicle for this step
+  public: void SetInputs(int _vehicle, double _throttle, double _pitch, double _roll, double _yaw);
+
+  /// \brief Set the step and the rotor joint velocities the PIDs of the vehicle use
+  /// \param[in] _velocities joint velocity of every rotor of the vehicle,
+  /// in the order they were added
+  public: void SetFeedback(int _vehicle, common::Time _dt, const std::vector<double> &_velocities);
+
+  /// \brief Leave the PIDs of the vehicle untouched in the next Mix
+  public: void Idle(int _vehicle);
+
+  /// \brief Compute the commands, filter the velocities and compute
+  /// the forces of every rotor
+  public: void Mix();
+
+  /// \brief Apply the rotor forces of the vehicle computed by the last Mix
+  public: void Apply(int _vehicle);
+
+  /// \brief Apply the forces of the last Mix in which the vehicle was not idle
+  public: void Hold(int _vehicle);
+
+  public: unsigned RotorCount() const;
+  public: unsigned RotorCount(int _vehicle) const;
+  /// \brief index of the first rotor of the vehicle in the per rotor arrays
+  public: unsigned FirstRotor(int _vehicle) const;
+
+  /// \brief per vehicle, first rotor and number of rotors
+  private: std::vector<unsigned> first_;
+  private: std::vector<unsigned> count_;
+  private: std::vector<int> freeVehicles_;
+
+  /// \brief per rotor mixer input, copied from the vehicle in SetInputs
+  public: std::vector<double> throttle;
+  public: std::vector<double> pitch;
+  public: std::vector<double> roll;
+  public: std::vector<double> yaw;
+
+  /// \brief per rotor mixer matrix row
+  public: std::vector<double> trim;
+  public: std::vector<double> mixPitch;
+  public: std::vector<double> mixRoll;
+  public: std::vector<double> mixYaw;
+
+  /// \brief per rotor turning direction over rotorVelocitySlowdownSim
+  public: std::vector<double> velocityScale;
+
+  /// \brief per rotor command and joint velocity target, output of Mix
+  public: std::vector<double> cmd;
+  public: std::vector<double> velTarget;
+
+  /// \brief per rotor step and joint velocity, set by SetFeedback
+  public: std::vector<double> dt;
+  public: std::vector<double> velocity;
+
+  /// \brief per rotor velocity filter
+  ///   y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2
+  /// over the last two velocities x1, x2 and filtered velocities y1, y2.
+  /// One pole filters have b1 = b2 = a2 = 0, unfiltered rotors b0 = 1 only,
+  /// so every rotor costs the same.
+  public: std::vector<double> filterB0;
+  public: std::vector<double> filterB1;
+  public: std::vector<double> filterB2;
+  public: std::vector<double> filterA1;
+  public: std::vector<double> filterA2;
+  public: std::vector<double> velocityX1;
+  public: std::vector<double> velocityX2;
+  public: std::vector<double> filteredY1;
+  public: std::vector<double> filteredY2;
+
+  /// \brief per rotor velocity error and rotor force, output of Mix
+  public: std::vector<double> error;
+  public: std::vector<double> force;
+
+  public: PidBank pid;
+  public: std::vector<physics::JointPtr> joints;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_ROTOR_BANK_H_ */
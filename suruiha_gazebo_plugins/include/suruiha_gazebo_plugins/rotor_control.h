@@ -14,7 +14,7 @@
 #include <string>
 
 namespace gazebo {
-/// \brief Rotor class
+/// \brief Rotor class, parsed from a <rotor> element and copied into a RotorBank
 class RotorControl
 {
   /// \brief Constructor
@@ -26,9 +26,6 @@ class RotorControl
   /// \brief Max rotor propeller RPM.
   public: double maxRpm = 838.0;
 
-  /// \brief Next command to be applied to the propeller
-  public: double cmd = 0;
-
   /// \brief Velocity PID for motor control
   public: common::PID pid;
 
@@ -41,11 +38,24 @@ class RotorControl
   /// \brief direction multiplier for this rotor
   public: double multiplier = 1;
 
-  /// \brief unused coefficients
+  /// \brief mixer matrix row, how much the rotor speeds up
+  /// for a positive pitch, roll and yaw error
+  public: double mixPitch = 0;
+  public: double mixRoll = 0;
+  public: double mixYaw = 0;
+
+  /// \brief throttle scale to balance the rotor thrust
+  public: double trim = 1;
+
+  /// \brief the joint spins this many times slower than the real rotor
   public: double rotorVelocitySlowdownSim;
+
+  /// \brief low pass filter of the rotor velocity fed to the PID,
+  /// 0 for none, 1 for one pole, 2 for second order butterworth
+  public: int filterOrder = 0;
+  /// \brief cutoff and sampling frequency of the filter, Hz
   public: double frequencyCutoff;
   public: double samplingRate;
-  public: ignition::math::OnePole<double> velocityFilter;
 };
 
 }
@@ -0,0 +1,68 @@
+/*
+ * scenery_tiles.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_SCENERY_TILES_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_SCENERY_TILES_H_
+
+#include <string>
+#include <vector>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/physics/physics.hh>
+#include <gazebo/transport/transport.hh>
+#include <ignition/math.hh>
+
+namespace gazebo
+{
+	/// \brief World plugin that keeps only the scenery tiles near a vehicle
+	/// in the world. Every <tile> holds one static <model>, usually written by
+	/// uav_gazebo/scripts/tile_scenery.py. A tile is inserted once a tracked
+	/// model is within <loadRadius> of it and removed once every tracked model
+	/// is beyond <unloadRadius>.
+	class SceneryTiles : public WorldPlugin
+	{
+		public: SceneryTiles();
+		public: virtual ~SceneryTiles();
+
+		public: void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+		protected: virtual void Update();
+
+		/// \brief one <tile> of the sdf
+		private: struct Tile
+		{
+			std::string name;
+			/// \brief centre and edge of the square the tile covers, xy in the world
+			ignition::math::Vector2d center;
+			double size;
+			/// \brief sdf inserted when the tile loads
+			std::string sdf;
+			bool loaded;
+		};
+
+		private: bool LoadTile(sdf::ElementPtr _tile);
+		/// \brief whether _model is one of the vehicles tiles are loaded for
+		private: bool Tracked(const physics::ModelPtr &_model) const;
+		/// \brief distance of _pos to the square of _tile in xy, 0 inside it
+		private: static double Distance(const Tile &_tile, const ignition::math::Vector3d &_pos);
+
+		private: physics::WorldPtr world_;
+		private: event::ConnectionPtr update_connection_;
+		private: transport::NodePtr node_;
+		private: transport::PublisherPtr request_pub_;
+
+		private: std::vector<Tile> tiles_;
+		/// \brief name prefixes of the tracked models, every non static model if empty
+		private: std::vector<std::string> track_;
+		private: double load_radius_;
+		private: double unload_radius_;
+		private: common::Time update_period_;
+		private: common::Time last_update_;
+		private: bool updated_;
+
+		/// \brief positions of the tracked models, kept between updates
+		private: std::vector<ignition::math::Vector3d> positions_;
+	};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_SCENERY_TILES_H_ */
@@ -0,0 +1,110 @@
+/*
+ * spawn_pool.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPAWN_POOL_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPAWN_POOL_H_
+
+#include <ros/ros.h>
+#include <std_msgs/String.h>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+#include <gazebo/common/Time.hh>
+#include <gazebo/physics/physics.hh>
+#include <sdf/sdf.hh>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+	/// \brief World plugin that brings a swarm up in one batch.
+	/// Every <template> model file is found and read once, with its includes
+	/// resolved. The <spawn> elements then rename and place the template on
+	/// a grid for each instance and queue it with InsertModelSDF, and the
+	/// world loads all of them in one factory pass instead of one
+	/// spawn_model call each. What is saved is the lookup, the file read and
+	/// the service round trip per vehicle: InsertModelSDF still serializes
+	/// every instance and the world parses it again, and the meshes are
+	/// loaded by the MeshManager the first time an instance needs them.
+	///
+	/// With a swarm_controller loaded before it, the vehicles are parked
+	/// until all instances are there, see Swarm::DeferActivation. They are
+	/// then activated <activatePerStep> per world step, or on demand by
+	/// model name on <activateTopic> if <autoActivate> is false ("all"
+	/// activates every one). The wall time of every phase is printed.
+	///
+	///   <template name="iris">model://iris_quadrotor_with_plugin</template>
+	///   <spawn>
+	///     <template>iris</template> <count>200</count> <prefix>iris</prefix>
+	///     <origin>0 0 0.2</origin> <spacing>3</spacing> <columns>20</columns>
+	///   </spawn>
+	class SpawnPool : public WorldPlugin
+	{
+		public: SpawnPool();
+		public: virtual ~SpawnPool();
+
+		public: void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+		protected: virtual void UpdateStates();
+
+		/// \brief a model read once, its <model> element is renamed and
+		/// placed for every instance
+		private: struct Template
+		{
+			std::string name;
+			sdf::SDFPtr sdf;
+			sdf::ElementPtr model;
+		};
+
+		/// \brief one instance of a template
+		private: struct Instance
+		{
+			unsigned templateIndex;
+			std::string name;
+			ignition::math::Pose3d pose;
+		};
+
+		/// \brief Find and read the model file of the template
+		/// \return false if the model cannot be read
+		private: bool LoadTemplate(const std::string &_name, const std::string &_uri);
+		/// \brief the instances of one <spawn> element
+		private: bool LoadSpawn(sdf::ElementPtr _sdf);
+		/// \brief true once every instance is in the world or the spawn timed out
+		private: bool Spawned();
+		private: void Activate();
+		private: void ActivateCallback(const std_msgs::String::ConstPtr &_name);
+		private: void Report(const std::string &_phase, common::Time _start, unsigned _count);
+
+		private: event::ConnectionPtr update_connection_;
+		private: physics::WorldPtr world_;
+		private: ros::NodeHandle* rosnode_;
+		private: ros::Subscriber activateSub_;
+
+		private: std::vector<Template> templates_;
+		private: std::vector<Instance> instances_;
+		/// \brief instances inserted so far, and found in the world so far
+		private: unsigned inserted_;
+		private: unsigned present_;
+		/// \brief inserted per world step, 0 for all in the first step
+		private: unsigned spawnPerStep_;
+		private: unsigned activatePerStep_;
+		private: bool autoActivate_;
+		/// \brief wall time to wait for the world to load the instances
+		private: double spawnTimeout_;
+		/// \brief vehicles are parked by the swarm until activated
+		private: bool deferred_;
+
+		/// \brief names received on activateTopic, taken by the update hook
+		private: boost::mutex activateMutex_;
+		private: std::vector<std::string> activateNames_;
+
+		/// \brief wall times of the phases of the bring-up
+		private: common::Time loadStart_;
+		private: common::Time spawnStart_;
+		private: common::Time activateStart_;
+		private: enum Phase { SPAWN, WAIT, ACTIVATE, DONE };
+		private: Phase phase_;
+	};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPAWN_POOL_H_ */
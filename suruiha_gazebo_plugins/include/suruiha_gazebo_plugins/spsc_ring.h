@@ -0,0 +1,98 @@
+/*
+ * spsc_ring.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPSC_RING_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace gazebo {
+/// \brief Bounded queue from one producer thread to one consumer thread.
+/// Push and Pop never wait and never allocate, a full ring refuses the value.
+/// Each side keeps its own copy of the other side's index and reads the
+/// shared one only when that copy says the ring is full or empty, so most
+/// calls touch no cache line the other thread writes.
+/// Only one thread may call Push and only one thread may call Pop.
+template <typename T>
+class SpscRing
+{
+  /// \brief _capacity is rounded up to a power of two
+  public: explicit SpscRing(std::size_t _capacity = 1024) {
+      Reset(_capacity);
+  }
+
+  /// \brief Drop every value and change the capacity, no thread may be
+  /// using the ring
+  public: void Reset(std::size_t _capacity) {
+      std::size_t size = 2;
+      while (size < _capacity) {
+          size <<= 1;
+      }
+      buffer_.assign(size, T());
+      mask_ = size - 1;
+      head_.store(0, std::memory_order_relaxed);
+      tail_.store(0, std::memory_order_relaxed);
+      cachedHead_ = 0;
+      cachedTail_ = 0;
+  }
+
+  /// \brief Append a value, called by the producer only
+  /// \return false if the ring is full, the value is dropped
+  public: bool Push(const T &_value) {
+      const std::size_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail - cachedHead_ > mask_) {
+          cachedHead_ = head_.load(std::memory_order_acquire);
+          if (tail - cachedHead_ > mask_) {
+              return false;
+          }
+      }
+      buffer_[tail & mask_] = _value;
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+  }
+
+  /// \brief Take the oldest value, called by the consumer only
+  /// \return false if the ring is empty
+  public: bool Pop(T &_value) {
+      const std::size_t head = head_.load(std::memory_order_relaxed);
+      if (head == cachedTail_) {
+          cachedTail_ = tail_.load(std::memory_order_acquire);
+          if (head == cachedTail_) {
+              return false;
+          }
+      }
+      _value = buffer_[head & mask_];
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+  }
+
+  public: std::size_t Capacity() const {
+      return mask_ + 1;
+  }
+
+  private: static const std::size_t CACHE_LINE = 64;
+
+  private: std::vector<T> buffer_;
+  private: std::size_t mask_;
+
+  /// \brief padding instead of alignas, which new does not honour before C++17,
+  /// keeps the indices of the two sides on different cache lines
+  private: char padHead_[CACHE_LINE];
+  /// \brief next value to pop, written by the consumer
+  private: std::atomic<std::size_t> head_;
+  /// \brief consumer copy of tail_
+  private: std::size_t cachedTail_;
+
+  private: char padTail_[CACHE_LINE];
+  /// \brief next free slot, written by the producer
+  private: std::atomic<std::size_t> tail_;
+  /// \brief producer copy of head_
+  private: std::size_t cachedHead_;
+  private: char padEnd_[CACHE_LINE];
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_SPSC_RING_H_ */
@@ -0,0 +1,137 @@
+/*
+ * step_profiler.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_STEP_PROFILER_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_STEP_PROFILER_H_
+
+// Per step timing of the controller plugins, built only with
+// -DSURUIHA_ENABLE_INSTRUMENTATION=ON. Without it SURUIHA_PROFILE_SCOPE
+// expands to nothing and StepProfiler is only declared.
+
+namespace gazebo {
+class StepProfiler;
+}
+
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+
+#include <gazebo/common/Time.hh>
+#include <sdf/sdf.hh>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace gazebo {
+/// \brief Histogram of durations, bucket i counts durations below 2^i ns
+class StepHistogram
+{
+  public: static const unsigned BUCKETS = 32;
+
+  public: StepHistogram() {
+      Reset();
+  }
+
+  public: void Add(uint64_t _ns) {
+      unsigned bucket = 0;
+      while (bucket < BUCKETS - 1 && (_ns >> bucket) != 0) {
+          ++bucket;
+      }
+      buckets[bucket]++;
+      count++;
+      sum += _ns;
+      if (_ns > max) {
+          max = _ns;
+      }
+  }
+
+  /// \brief upper bound of the bucket holding the _q quantile
+  public: uint64_t Quantile(double _q) const;
+
+  public: void Reset();
+
+  public: uint64_t buckets[BUCKETS];
+  public: uint64_t count;
+  public: uint64_t sum;
+  public: uint64_t max;
+};
+
+/// \brief Time spent per step in each part of the controller update.
+/// Owned by an IrisController, ZephyrController or Swarm, the vehicles get
+/// a pointer to it.
+class StepProfiler
+{
+  public: enum Section {
+      /// \brief whole update hook
+      STEP,
+      /// \brief ros callbacks run by the update hook
+      DISPATCH,
+      /// \brief waiting for the swarm update_mutex_
+      LOCK_WAIT,
+      /// \brief VehicleState::Read
+      STATE,
+      /// \brief RotorBank::Mix, the mixer and the rotor PIDs
+      MIXER,
+      /// \brief joint PIDs and SetForce
+      PID,
+      /// \brief pose and vehicle state messages
+      PUBLISH,
+      /// \brief samples handed to the FlightRecorder
+      RECORD,
+      SECTION_COUNT
+  };
+
+  public: StepProfiler();
+
+  /// \brief Read <profileInterval>, sim seconds between two reports
+  public: void Load(sdf::ElementPtr _sdf);
+
+  public: static const char* SectionName(Section _section);
+
+  /// \brief Print every section with gzdbg every _interval of sim time
+  /// and start over
+  public: void Report(const std::string &_name, const common::Time &_time);
+
+  public: void Add(Section _section, uint64_t _ns) {
+      histograms[_section].Add(_ns);
+  }
+
+  /// \brief sim time between two reports
+  public: common::Time interval;
+  public: StepHistogram histograms[SECTION_COUNT];
+
+  private: common::Time lastReportTime;
+};
+
+/// \brief Adds the time to the end of the scope to a profiler section
+class ScopedSectionTimer
+{
+  public: ScopedSectionTimer(StepProfiler *_profiler, StepProfiler::Section _section)
+      : profiler(_profiler), section(_section), start(std::chrono::steady_clock::now()) {
+  }
+
+  public: ~ScopedSectionTimer() {
+      if (profiler != nullptr) {
+          profiler->Add(section, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count());
+      }
+  }
+
+  private: StepProfiler *profiler;
+  private: StepProfiler::Section section;
+  private: std::chrono::steady_clock::time_point start;
+};
+}
+
+#define SURUIHA_PROFILE_CONCAT_(a, b) a##b
+#define SURUIHA_PROFILE_CONCAT(a, b) SURUIHA_PROFILE_CONCAT_(a, b)
+#define SURUIHA_PROFILE_SCOPE(profiler, section) \
+    ::gazebo::ScopedSectionTimer SURUIHA_PROFILE_CONCAT(suruihaTimer, __LINE__)( \
+            profiler, ::gazebo::StepProfiler::section)
+
+#else
+
+#define SURUIHA_PROFILE_SCOPE(profiler, section)
+
+#endif
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_STEP_PROFILER_H_ */
@@ -0,0 +1,179 @@
+/*
+ * swarm.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_SWARM_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_SWARM_H_
+
+#include <ros/ros.h>
+#include <geometry_msgs/Twist.h>
+#include <suruiha_gazebo_plugins/VehicleStates.h>
+#include <suruiha_gazebo_plugins/VehicleHandoff.h>
+
+#include <gazebo/physics/physics.hh>
+#include <suruiha_gazebo_plugins/iris_vehicle.h>
+#include <suruiha_gazebo_plugins/zephyr_vehicle.h>
+#include <suruiha_gazebo_plugins/callback_dispatcher.h>
+#include <suruiha_gazebo_plugins/step_profiler.h>
+#include <suruiha_gazebo_plugins/flight_recorder.h>
+#include <boost/thread.hpp>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Controller state of every vehicle in a world.
+/// Created by the SwarmController world plugin. World plugins are loaded
+/// before the model plugins, so IrisController and ZephyrController find the
+/// swarm through Instance() and register their vehicle here instead of
+/// starting their own node handle, callback queue thread and update hook.
+class Swarm
+{
+  public: Swarm(physics::WorldPtr _world, const std::string &_robotNamespace,
+          CallbackDispatcher::Mode _dispatchMode = CallbackDispatcher::THREAD,
+          bool _lockstep = false);
+  public: virtual ~Swarm();
+
+  /// \brief the swarm of the running world, nullptr without a SwarmController
+  public: static Swarm* Instance();
+
+  /// \brief Load a vehicle from its controller plugin sdf.
+  /// \return slot of the vehicle, -1 if it could not be loaded
+  public: int AddIris(physics::ModelPtr _model, sdf::ElementPtr _sdf);
+  public: void RemoveIris(int _slot);
+  public: int AddZephyr(physics::ModelPtr _model, sdf::ElementPtr _sdf);
+  public: void RemoveZephyr(int _slot);
+
+  /// \brief Park the vehicles added from now on: they are updated, but
+  /// their control topic is not subscribed nor their pose advertised
+  /// until Activate. A SpawnPool defers them while it brings a batch up.
+  public: void DeferActivation(bool _defer);
+
+  /// \brief Subscribe and advertise the topics of up to _max parked
+  /// vehicles, every one if _max is 0.
+  /// \return the number of vehicles activated
+  public: unsigned Activate(unsigned _max);
+
+  /// \brief Activate the parked vehicle of model _name
+  /// \return false if no vehicle of that name is parked
+  public: bool Activate(const std::string &_name);
+
+  public: unsigned ParkedCount();
+
+  /// \brief Park the vehicle of model _name when it is added, until Import
+  /// hands it the state it left another gzserver with, see RegionPartition
+  public: void ExpectHandoff(const std::string &_name);
+
+  /// \brief Stop expecting _name, e.g. when its model never came
+  public: void CancelHandoff(const std::string &_name);
+
+  /// \brief Restore _msg into the expected vehicle of its name and activate it
+  /// \return false while that vehicle is not loaded yet
+  public: bool Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Write the state of the vehicle of model _name into _msg and
+  /// release it. Called from the world update thread.
+  /// \return the model of the vehicle, null if there is none
+  public: physics::ModelPtr Export(const std::string &_name,
+          suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Close the topics of the vehicle of model _name, it is about to be
+  /// removed from this world and goes on in another one
+  /// \return the model of the vehicle, null if there is none
+  public: physics::ModelPtr Release(const std::string &_name);
+
+  /// \brief Name and world position of every vehicle of this world that is
+  /// neither released nor expected, as the last step read it
+  public: void Positions(std::vector<std::string> &_names,
+          std::vector<ignition::math::Vector3d> &_positions);
+
+  /// \brief Also publish the state of every vehicle in one VehicleStates
+  /// message on _topic, at the poseUpdateRate of the fastest vehicle
+  public: void AdvertiseStates(const std::string &_topic);
+
+  /// \brief Record every vehicle added afterwards in the <recordFile> of
+  /// the swarm controller sdf, see FlightRecorder::Load
+  public: bool OpenRecorder(sdf::ElementPtr _sdf);
+
+  /// \brief Run the control callbacks if they are dispatched by the update
+  /// hook, then update every vehicle. Called once per world step.
+  public: void Update();
+
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+  /// \brief step timings of the whole swarm, shared by its vehicles
+  public: StepProfiler& Profiler();
+#endif
+
+  private: void UpdateVehicles(const common::Time &_currTime);
+  private: void PublishStates(const common::Time &_currTime);
+  private: void FillState(unsigned _index, const std::string &_name,
+          const VehicleState &_state, bool _withName);
+  /// \brief control callbacks, bound to the vehicle and not to its slot so
+  /// that they never read the deques that AddIris and AddZephyr grow
+  private: void SetIrisControl(IrisVehicle* _vehicle, const geometry_msgs::Twist::ConstPtr& _control);
+  private: void SetZephyrControl(ZephyrVehicle* _vehicle, const geometry_msgs::Twist::ConstPtr& _control);
+  private: void SetIrisControlStamped(IrisVehicle* _vehicle, const geometry_msgs::TwistStamped::ConstPtr& _control);
+  private: void SetZephyrControlStamped(ZephyrVehicle* _vehicle, const geometry_msgs::TwistStamped::ConstPtr& _control);
+  /// \brief Subscribe the control topic and advertise the pose of a vehicle,
+  /// called with update_mutex_ held. The subscriber is shut down before
+  /// its slot is freed or given to another vehicle.
+  private: void ConnectIris(int _slot);
+  private: void ConnectZephyr(int _slot);
+  /// \brief slot of the loaded vehicle of model _name, -1 if there is none
+  private: int FindIris(const std::string &_name) const;
+  private: int FindZephyr(const std::string &_name) const;
+  /// \brief lockstep needs the callbacks on the update thread
+  private: bool CheckLockstep(bool _lockstep, const std::string &_name);
+  /// \brief Give the clock of a new vehicle the next physics step of its control
+  /// period, unless the sdf sets its phase, so that vehicles tick on different steps
+  private: void SpreadControl(ControlClock &_clock);
+
+  private: static Swarm* instance_;
+
+  private: physics::WorldPtr world_;
+  private: ros::NodeHandle* rosnode_;
+
+  /// \brief vehicles are kept by value, removed slots are reused.
+  /// A deque so that adding a vehicle never moves the others while
+  /// their control callbacks run.
+  private: std::deque<IrisVehicle> irisVehicles_;
+  /// \brief rotors of every iris, mixed in one pass per step
+  private: RotorBank irisRotors_;
+  private: std::vector<int> freeIrisSlots_;
+  private: std::deque<ZephyrVehicle> zephyrVehicles_;
+  private: std::vector<int> freeZephyrSlots_;
+  /// \brief slots of the vehicles waiting for Activate, in the order added
+  private: bool deferActivation_;
+  private: std::deque<int> parkedIris_;
+  private: std::deque<int> parkedZephyr_;
+  /// \brief names of the vehicles handed over to this world and not imported
+  /// yet, and of the vehicles handed away and not removed yet
+  private: std::set<std::string> expected_;
+  private: std::set<std::string> released_;
+
+  private: ros::Publisher statesPub_;
+  /// \brief reused between publishes, resized only when vehicles come or go
+  private: suruiha_gazebo_plugins::VehicleStates statesMsg_;
+  /// \brief a vehicle was added or removed since the last publish
+  private: bool statesLayoutChanged_;
+  /// \brief smallest poseUpdateRate of the vehicles, milliseconds
+  private: int statesUpdateRate_;
+  private: common::Time lastStatesPublishTime_;
+
+  /// \brief guards adding and removing vehicles against Update,
+  /// control callbacks go through the vehicle mailboxes instead
+  private: boost::mutex update_mutex_;
+  private: CallbackDispatcher dispatcher_;
+  /// \brief every vehicle runs in lockstep mode
+  private: bool lockstep_;
+  /// \brief vehicles given a phase by SpreadControl so far
+  private: unsigned spreadIndex_;
+  private: FlightRecorder recorder_;
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+  private: StepProfiler profiler_;
+#endif
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_SWARM_H_ */
@@ -0,0 +1,31 @@
+#ifndef SWARM_CONTROLLER_H
+#define SWARM_CONTROLLER_H
+
+#include <ros/ros.h>
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/Events.hh>
+#include <suruiha_gazebo_plugins/swarm.h>
+
+namespace gazebo
+{
+	/// \brief World plugin that drives every IrisController and
+	/// ZephyrController of the world from one callback queue and one update hook.
+	/// Put it in the world sdf to enable it, the model sdfs stay the same.
+	class SwarmController : public WorldPlugin
+    {
+		public: SwarmController();
+		public: virtual ~SwarmController();
+
+		public: void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+		protected: virtual void UpdateStates();
+		private: event::ConnectionPtr update_connection_;
+
+		private: physics::WorldPtr world_;
+		private: std::string robot_namespace_;
+		private: Swarm* swarm_;
+	};
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * vehicle_config.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_CONFIG_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_CONFIG_H_
+
+#include <gazebo/common/PID.hh>
+#include <gazebo/common/Time.hh>
+#include <suruiha_gazebo_plugins/rotor_control.h>
+#include <suruiha_gazebo_plugins/joint_control.h>
+#include <suruiha_gazebo_plugins/control_clock.h>
+#include <suruiha_gazebo_plugins/position_hold.h>
+#include <sdf/sdf.hh>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Parameters of an iris plugin sdf, everything a vehicle needs
+/// but the model it is attached to.
+/// Get parses an sdf once, every model spawned from the same plugin sdf
+/// then shares the config and only looks its joints up.
+class IrisConfig
+{
+  public: IrisConfig();
+
+  /// \brief The config of _sdf, parsed on the first call for its text
+  /// \return null if _sdf is not valid, the errors were printed then
+  public: static std::shared_ptr<const IrisConfig> Get(sdf::ElementPtr _sdf);
+
+  /// \brief Parse and check _sdf
+  /// \return false if no vehicle can be controlled with it
+  public: bool Load(sdf::ElementPtr _sdf);
+
+  public: int poseUpdateRate;
+  public: double pitchOffset;
+  public: common::Time statsInterval;
+  public: bool lockstep;
+  public: ControlClock controlClock;
+  public: double recordRate;
+  public: bool onboardHold;
+  public: PositionHold hold;
+
+  /// \brief rotors in sdf order, without their joint. A samplingRate of 0
+  /// is the controlRate, or the physics rate of the world the vehicle is
+  /// spawned in without one.
+  public: std::vector<RotorControl> rotors;
+};
+
+/// \brief One <joint_control> element of a zephyr
+struct ZephyrJointConfig
+{
+  std::string name;
+  JointType type;
+  common::PID pid;
+};
+
+/// \brief Parameters of a zephyr plugin sdf, see IrisConfig
+class ZephyrConfig
+{
+  public: ZephyrConfig();
+
+  public: static std::shared_ptr<const ZephyrConfig> Get(sdf::ElementPtr _sdf);
+
+  /// \brief Parse and check _sdf, it needs at least the propeller and
+  /// the two flap joints
+  public: bool Load(sdf::ElementPtr _sdf);
+
+  public: int poseUpdateRate;
+  public: common::Time statsInterval;
+  public: bool lockstep;
+  public: ControlClock controlClock;
+  public: double recordRate;
+  public: std::vector<ZephyrJointConfig> joints;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_CONFIG_H_ */
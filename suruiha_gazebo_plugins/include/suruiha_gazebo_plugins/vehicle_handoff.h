@@ -0,0 +1,39 @@
+/*
+ * vehicle_handoff.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_HANDOFF_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_HANDOFF_H_
+
+#include <suruiha_gazebo_plugins/VehicleHandoff.h>
+#include <suruiha_gazebo_plugins/pid_bank.h>
+#include <gazebo/physics/physics.hh>
+#include <vector>
+
+namespace gazebo {
+/// \brief Read and restore the parts of a VehicleHandoff that IrisVehicle
+/// and ZephyrVehicle have in common. The receiving vehicle is loaded from
+/// the same sdf, so its controllers and joints come in the order they left.
+class Handoff {
+	/// \brief Append the errors and commands of _count controllers of _pid from _first
+	public: static void SavePid(const PidBank &_pid, unsigned _first, unsigned _count,
+			suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+	/// \brief Restore _count controllers of _pid from _first, read from _offset
+	/// of the arrays of _msg, _offset is moved past them
+	/// \return false if _msg has fewer controllers left, nothing is restored then
+	public: static bool RestorePid(PidBank &_pid, unsigned _first, unsigned _count,
+			const suruiha_gazebo_plugins::VehicleHandoff &_msg, unsigned &_offset);
+
+	/// \brief Pose and velocity of _model and the position and velocity of _joints
+	public: static void SaveModel(physics::ModelPtr _model, const std::vector<physics::JointPtr> &_joints,
+			suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+	/// \brief Put _model and _joints where _msg left them
+	/// \return false if _msg has another number of joints, the model is not moved then
+	public: static bool RestoreModel(physics::ModelPtr _model, const std::vector<physics::JointPtr> &_joints,
+			const suruiha_gazebo_plugins::VehicleHandoff &_msg);
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_HANDOFF_H_ */
@@ -0,0 +1,64 @@
+/*
+ * vehicle_state.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_STATE_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_STATE_H_
+
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/Time.hh>
+#include <ignition/math.hh>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Counters of the work a controller does, to check the per step costs
+class ControllerStats
+{
+  public: ControllerStats();
+
+  /// \brief Print the counters with gzdbg every _interval of sim time,
+  /// nothing if _interval is zero
+  public: void Report(const std::string &_name, const common::Time &_time,
+          const common::Time &_interval);
+
+  public: unsigned long steps;
+  /// \brief model pose and joint reads besides the VehicleState::Read of
+  /// each step, counted where the model is asked directly. 0 per step once
+  /// everything takes the snapshot.
+  public: unsigned long poseReads;
+  public: unsigned long jointReads;
+  /// \brief lockstep commands that arrived after the sim time of their stamp
+  public: unsigned long lateCommands;
+
+  private: common::Time lastReportTime;
+};
+
+/// \brief Model and joint state of a vehicle, read once per step.
+/// The mixer, the pose publisher and the joint controllers all use this
+/// snapshot instead of asking the model again.
+class VehicleState
+{
+  public: VehicleState();
+
+  /// \brief Read the model and the given joints for the step at _time
+  public: void Read(const physics::ModelPtr &_model,
+          const std::vector<physics::JointPtr> &_joints,
+          const common::Time &_time);
+
+  public: common::Time time;
+  public: ignition::math::Pose3d pose;
+  /// \brief roll, pitch and yaw of pose
+  public: ignition::math::Vector3d euler;
+  /// \brief linear velocity in the world frame
+  public: ignition::math::Vector3d linearVel;
+  /// \brief angular velocity in the body frame
+  public: ignition::math::Vector3d bodyRates;
+
+  /// \brief axis 0 of every joint, in the order passed to Read
+  public: std::vector<double> jointPositions;
+  public: std::vector<double> jointVelocities;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_VEHICLE_STATE_H_ */
@@ -3,14 +3,14 @@
 
 #include <ros/ros.h>
 #include <geometry_msgs/Twist.h>
-#include <ros/callback_queue.h>
 
 #include <gazebo/common/Plugin.hh>
 #include <gazebo/physics/physics.hh>
 #include <gazebo/transport/TransportTypes.hh>
 #include <gazebo/common/Time.hh>
 #include <gazebo/common/Events.hh>
-#include <suruiha_gazebo_plugins/joint_control.h>
+#include <suruiha_gazebo_plugins/zephyr_vehicle.h>
+#include <suruiha_gazebo_plugins/callback_dispatcher.h>
 
 namespace gazebo
 {
@@ -29,33 +29,19 @@ namespace gazebo
 //		private: physics::LinkPtr bodyLink_;
 		
 		private: std::string robot_namespace_;
-//		private: std::string control_topic_name_;
-//		private: std::string pose_topic_name_;
-//		private: std::string user_command_topic_name_;
 		private: ros::NodeHandle* rosnode_;
-        private: ros::Subscriber control_twist_sub_;
-//        private: ros::Subscriber user_command_sub_;
-        private: ros::Publisher pose_pub_;
-
-        private: double targetThrottle;
-        private: double targetPitch;
-        private: double targetRoll;
-
-        private: std::vector<JointControl*> joints_;
-        private: void SetPIDParams(JointControl* jointControl, sdf::ElementPtr _sdf);
+        private: ZephyrVehicle vehicle_;
+        /// \brief slot in the swarm, -1 if this plugin runs the vehicle itself
+        private: int swarmSlot_;
 	    private: void SetControl(const geometry_msgs::Twist::ConstPtr& controlTwist);
-//	    private: void ProcessUserCommand(const std_msgs::String::ConstPtr& user_command);
-	    private: void CalculateJoints(double targetThrottle, double targetPitch, double targetRoll, common::Time dt);
-
-		private: boost::mutex update_mutex_;
-		private: ros::CallbackQueue queue_;
-		private: boost::thread callback_queue_thread_;
-	    private: void QueueThread();
+	    private: void SetControlStamped(const geometry_msgs::TwistStamped::ConstPtr& _control);
 
-        private: common::Time lastUpdateTime;
-
-        private: common::Time lastPosePublishTime;
-        private: int poseUpdateRate;
+		private: CallbackDispatcher dispatcher_;
+		/// \brief flight log of the vehicle if the sdf has a <recordFile>
+		private: FlightRecorder recorder_;
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+		private: StepProfiler profiler_;
+#endif
 
 	};
 }
@@ -0,0 +1,126 @@
+/*
+ * zephyr_vehicle.h
+ */
+
+#ifndef INCLUDE_SURUIHA_GAZEBO_PLUGINS_ZEPHYR_VEHICLE_H_
+#define INCLUDE_SURUIHA_GAZEBO_PLUGINS_ZEPHYR_VEHICLE_H_
+
+#include <ros/ros.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/TwistStamped.h>
+
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/Time.hh>
+#include <suruiha_gazebo_plugins/joint_control.h>
+#include <suruiha_gazebo_plugins/command_mailbox.h>
+#include <suruiha_gazebo_plugins/command_schedule.h>
+#include <suruiha_gazebo_plugins/control_clock.h>
+#include <suruiha_gazebo_plugins/vehicle_state.h>
+#include <suruiha_gazebo_plugins/step_profiler.h>
+#include <suruiha_gazebo_plugins/flight_recorder.h>
+#include <suruiha_gazebo_plugins/VehicleHandoff.h>
+#include <string>
+#include <vector>
+
+namespace gazebo {
+/// \brief Targets of the last control message of a zephyr
+struct ZephyrTargets
+{
+  double throttle;
+  double pitch;
+  double roll;
+};
+
+/// \brief Controller state of one zephyr fixed wing plane.
+/// See IrisVehicle, it is owned by a ZephyrController or by the SwarmController.
+class ZephyrVehicle
+{
+  public: ZephyrVehicle();
+
+  /// \brief Control the <joint_control> joints of the plugin sdf, see ZephyrConfig.
+  /// \return false if the vehicle cannot be controlled
+  public: bool Load(physics::ModelPtr _model, sdf::ElementPtr _sdf);
+
+  /// \brief Release the joints, the vehicle must not be updated afterwards
+  public: void Unload();
+
+  /// \brief Hand new targets to the next Update, never blocks.
+  /// Called from the ros callback thread.
+  public: void SetControl(const geometry_msgs::Twist &_control);
+
+  /// \brief Queue targets until the sim time of their stamp, lockstep mode only.
+  /// Called from the world update thread, see CommandSchedule.
+  public: void SetControlStamped(const geometry_msgs::TwistStamped &_control,
+          const common::Time &_now);
+
+  /// \brief <name>_control, or <name>_control_stamped in lockstep mode
+  public: std::string ControlTopic() const;
+
+  /// \brief Write the model, targets and the state of the joint PIDs into _msg,
+  /// see IrisVehicle::Export
+  public: void Export(suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Continue the flight exported into _msg, see IrisVehicle::Import
+  /// \return false if _msg has another joint layout, nothing is restored then
+  public: bool Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg);
+
+  /// \brief Read the state, publish the pose and command the joints for one
+  /// world step, and record it if there is a recorder
+  public: void Update(const common::Time &_currTime);
+
+  /// \brief Command the joints from the state of this step, called by Update.
+  /// Public so that a step can be driven without a control publisher, e.g. by the benchmarks.
+  public: void CalculateJoints(double targetThrottle, double targetPitch, double targetRoll, common::Time dt);
+
+  private: void PublishPose(const common::Time &_currTime);
+  /// \brief Hand the state, joint commands and PID errors of this step to the recorder
+  private: void Record(bool _tick);
+
+  /// \brief name of the model, prefix of the pose and control topics
+  public: std::string name;
+  public: physics::ModelPtr model;
+
+  public: ros::Subscriber controlSub;
+  public: ros::Publisher posePub;
+
+  /// \brief written by SetControl, read once per step by Update
+  public: CommandMailbox<ZephyrTargets> command;
+
+  /// \brief apply only commands stamped with a sim time that has been reached
+  public: bool lockstep;
+  public: CommandSchedule<ZephyrTargets> schedule;
+
+  /// \brief targets in use for the current step
+  public: double targetThrottle;
+  public: double targetPitch;
+  public: double targetRoll;
+
+  /// \brief controlled joints in <joint_control> order
+  public: JointBank joints;
+  /// \brief the same joints, read into state every step
+  public: std::vector<physics::JointPtr> jointPtrs;
+
+  /// \brief snapshot of the current step
+  public: VehicleState state;
+  public: ControllerStats stats;
+  /// \brief sim time between two stats reports, 0 for none
+  public: common::Time statsInterval;
+  /// \brief step timings, not owned, nullptr unless instrumented
+  public: StepProfiler* profiler;
+  /// \brief flight log, not owned, nullptr if the flight is not recorded
+  public: FlightRecorder* recorder;
+  public: uint32_t recordId;
+  /// \brief <recordRate> of the samples, every step by default
+  public: ControlClock recordClock;
+
+  /// \brief rate of the controller, the joint forces are held in between
+  public: ControlClock controlClock;
+
+  /// \brief last time the controller ran, or the last step without control
+  public: common::Time lastUpdateTime;
+  public: common::Time lastPosePublishTime;
+  public: int poseUpdateRate;
+};
+}
+
+#endif /* INCLUDE_SURUIHA_GAZEBO_PLUGINS_ZEPHYR_VEHICLE_H_ */
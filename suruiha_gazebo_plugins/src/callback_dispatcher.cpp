@@ -0,0 +1,81 @@
+/*
+ * callback_dispatcher.cpp
+ */
+
+#include <suruiha_gazebo_plugins/callback_dispatcher.h>
+#include <gazebo/common/Console.hh>
+
+namespace gazebo {
+
+    CallbackDispatcher::CallbackDispatcher() {
+        rosnode_ = nullptr;
+        mode_ = THREAD;
+    }
+
+    CallbackDispatcher::~CallbackDispatcher() {
+        Stop();
+    }
+
+    CallbackDispatcher::Mode CallbackDispatcher::ModeFromSdf(sdf::ElementPtr _sdf) {
+        bool lockstep = _sdf->HasElement("lockstep") && _sdf->Get<bool>("lockstep");
+        if (!_sdf->HasElement("callbackDispatch")) {
+            return lockstep ? UPDATE : THREAD;
+        }
+        std::string mode = _sdf->Get<std::string>("callbackDispatch");
+        if (mode == "update") {
+            return UPDATE;
+        }
+        if (mode != "thread") {
+            gzerr << "unknown callbackDispatch [" << mode
+                  << "], use 'thread' or 'update'. Default 'thread'.\n";
+        }
+        if (lockstep) {
+            gzwarn << "lockstep needs callbackDispatch 'update', using it.\n";
+            return UPDATE;
+        }
+        return THREAD;
+    }
+
+    void CallbackDispatcher::Start(ros::NodeHandle* _rosnode, Mode _mode) {
+        this->rosnode_ = _rosnode;
+        this->mode_ = _mode;
+        if (this->mode_ == THREAD) {
+            this->callback_queue_thread_ =
+                    boost::thread(boost::bind(&CallbackDispatcher::QueueThread, this));
+        }
+    }
+
+    void CallbackDispatcher::Dispatch() {
+        if (this->mode_ == UPDATE) {
+            // zero timeout, only what is already queued
+            this->queue_.callAvailable(ros::WallDuration(0));
+        }
+    }
+
+    void CallbackDispatcher::Stop() {
+        this->queue_.clear();
+        // disable also wakes up the thread waiting in callAvailable
+        this->queue_.disable();
+        if (this->callback_queue_thread_.joinable()) {
+            this->callback_queue_thread_.join();
+        }
+    }
+
+    CallbackDispatcher::Mode CallbackDispatcher::GetMode() const {
+        return this->mode_;
+    }
+
+    ros::CallbackQueue* CallbackDispatcher::Queue() {
+        return &this->queue_;
+    }
+
+    void CallbackDispatcher::QueueThread() {
+        // callAvailable waits on the condition variable of the queue and
+        // returns as soon as a callback is added, the timeout only bounds
+        // how long shutdown of the node is noticed without a disable()
+        static const double timeout = 1.0;
+        while (this->rosnode_->ok() && this->queue_.isEnabled()) {
+            this->queue_.callAvailable(ros::WallDuration(timeout));
+        }
+    }
+}
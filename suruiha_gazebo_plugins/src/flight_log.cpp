@@ -0,0 +1,288 @@
+/*
+ * flight_log.cpp
+ */
+
+#include <suruiha_gazebo_plugins/flight_log.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gazebo {
+
+const char FlightLog::MAGIC[8] = {'S', 'R', 'H', 'L', 'O', 'G', '1', '\0'};
+
+static std::size_t Align8(std::size_t _bytes) {
+    return (_bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+FlightLogWriter::FlightLogWriter() : fd_(-1), map_(nullptr), mapped_(0), size_(0), columns_(0) {
+}
+
+FlightLogWriter::~FlightLogWriter() {
+    Close();
+}
+
+bool FlightLogWriter::Open(const std::string &_path, const std::vector<std::string> &_columns) {
+    Close();
+    fd_ = ::open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    columns_ = _columns.size();
+
+    const std::size_t header = Align8(sizeof(FlightLog::MAGIC) + 2 * sizeof(uint32_t) +
+            columns_ * FlightLog::COLUMN_NAME_SIZE);
+    if (!Reserve(header)) {
+        Close();
+        return false;
+    }
+    Write(FlightLog::MAGIC, sizeof(FlightLog::MAGIC));
+    const uint32_t version = FlightLog::VERSION;
+    const uint32_t count = columns_;
+    Write(&version, sizeof(version));
+    Write(&count, sizeof(count));
+    for (unsigned c = 0; c < columns_; ++c) {
+        char name[FlightLog::COLUMN_NAME_SIZE] = {0};
+        std::strncpy(name, _columns[c].c_str(), FlightLog::COLUMN_NAME_SIZE - 1);
+        Write(name, sizeof(name));
+    }
+    size_ = header;
+    return true;
+}
+
+bool FlightLogWriter::IsOpen() const {
+    return fd_ >= 0;
+}
+
+bool FlightLogWriter::AppendVehicle(uint32_t _id, const std::string &_name) {
+    const std::size_t bytes = 4 * sizeof(uint32_t) + Align8(_name.size());
+    if (!Reserve(bytes)) {
+        return false;
+    }
+    // the kind is written last, a reader of a live log stops before an unfinished record
+    const std::size_t start = size_;
+    const uint32_t fields[3] = {_id, static_cast<uint32_t>(_name.size()), 0};
+    size_ += sizeof(uint32_t);
+    Write(fields, sizeof(fields));
+    Write(_name.data(), _name.size());
+    const uint32_t kind = FlightLog::VEHICLE;
+    std::memcpy(map_ + start, &kind, sizeof(kind));
+    size_ = start + bytes;
+    return true;
+}
+
+bool FlightLogWriter::AppendRows(const double* _values, unsigned _rows, unsigned _stride) {
+    if (_rows == 0) {
+        return true;
+    }
+    const std::size_t bytes = 2 * sizeof(uint32_t) + std::size_t(columns_) * _rows * sizeof(double);
+    if (!Reserve(bytes)) {
+        return false;
+    }
+    const std::size_t start = size_;
+    size_ += sizeof(uint32_t);
+    const uint32_t rows = _rows;
+    Write(&rows, sizeof(rows));
+    for (unsigned c = 0; c < columns_; ++c) {
+        Write(_values + std::size_t(c) * _stride, _rows * sizeof(double));
+    }
+    const uint32_t kind = FlightLog::ROWS;
+    std::memcpy(map_ + start, &kind, sizeof(kind));
+    return true;
+}
+
+void FlightLogWriter::Close() {
+    if (map_ != nullptr) {
+        ::munmap(map_, mapped_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        // drop the zeros of the last grow step, a reader stops at them anyway
+        const int result = ::ftruncate(fd_, size_);
+        (void) result;
+        ::close(fd_);
+        fd_ = -1;
+    }
+    mapped_ = 0;
+    size_ = 0;
+}
+
+std::size_t FlightLogWriter::Size() const {
+    return size_;
+}
+
+bool FlightLogWriter::Reserve(std::size_t _bytes) {
+    if (fd_ < 0) {
+        return false;
+    }
+    if (size_ + _bytes <= mapped_) {
+        return true;
+    }
+    std::size_t mapped = mapped_;
+    while (mapped < size_ + _bytes) {
+        mapped += FlightLog::GROW_SIZE;
+    }
+    if (::ftruncate(fd_, mapped) != 0) {
+        return false;
+    }
+    if (map_ != nullptr) {
+        ::munmap(map_, mapped_);
+    }
+    void* map = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        map_ = nullptr;
+        mapped_ = 0;
+        return false;
+    }
+    map_ = static_cast<char*>(map);
+    mapped_ = mapped;
+    return true;
+}
+
+void FlightLogWriter::Write(const void* _data, std::size_t _bytes) {
+    std::memcpy(map_ + size_, _data, _bytes);
+    size_ += _bytes;
+}
+
+FlightLogReader::FlightLogReader() : fd_(-1), map_(nullptr), mapped_(0), rows_(0) {
+}
+
+FlightLogReader::~FlightLogReader() {
+    Close();
+}
+
+bool FlightLogReader::Open(const std::string &_path) {
+    Close();
+    fd_ = ::open(_path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FlightLog::MAGIC) + 8)) {
+        Close();
+        return false;
+    }
+    void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    map_ = static_cast<const char*>(map);
+    mapped_ = st.st_size;
+
+    uint32_t version, count;
+    std::memcpy(&version, map_ + sizeof(FlightLog::MAGIC), sizeof(version));
+    std::memcpy(&count, map_ + sizeof(FlightLog::MAGIC) + 4, sizeof(count));
+    std::size_t offset = sizeof(FlightLog::MAGIC) + 8;
+    if (std::memcmp(map_, FlightLog::MAGIC, sizeof(FlightLog::MAGIC)) != 0 ||
+            version != FlightLog::VERSION ||
+            offset + std::size_t(count) * FlightLog::COLUMN_NAME_SIZE > mapped_) {
+        Close();
+        return false;
+    }
+    for (uint32_t c = 0; c < count; ++c) {
+        const char* name = map_ + offset;
+        columns_.push_back(std::string(name, strnlen(name, FlightLog::COLUMN_NAME_SIZE)));
+        offset += FlightLog::COLUMN_NAME_SIZE;
+    }
+    offset = Align8(offset);
+
+    while (offset + 2 * sizeof(uint32_t) <= mapped_) {
+        uint32_t kind, value;
+        std::memcpy(&kind, map_ + offset, sizeof(kind));
+        std::memcpy(&value, map_ + offset + 4, sizeof(value));
+        if (kind == FlightLog::ROWS) {
+            const std::size_t bytes = 8 + std::size_t(count) * value * sizeof(double);
+            if (offset + bytes > mapped_) {
+                break;
+            }
+            Block block;
+            block.rows = value;
+            block.data = reinterpret_cast<const double*>(map_ + offset + 8);
+            blocks_.push_back(block);
+            rows_ += value;
+            offset += bytes;
+        } else if (kind == FlightLog::VEHICLE) {
+            if (offset + 16 > mapped_) {
+                break;
+            }
+            uint32_t length;
+            std::memcpy(&length, map_ + offset + 8, sizeof(length));
+            const std::size_t bytes = 16 + Align8(length);
+            if (offset + bytes > mapped_) {
+                break;
+            }
+            vehicles_[value] = std::string(map_ + offset + 16, length);
+            offset += bytes;
+        } else {
+            // END, or the unwritten tail of a log that is still open
+            break;
+        }
+    }
+    return true;
+}
+
+void FlightLogReader::Close() {
+    if (map_ != nullptr) {
+        ::munmap(const_cast<char*>(map_), mapped_);
+        map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    mapped_ = 0;
+    rows_ = 0;
+    columns_.clear();
+    blocks_.clear();
+    vehicles_.clear();
+}
+
+const std::vector<std::string>& FlightLogReader::Columns() const {
+    return columns_;
+}
+
+int FlightLogReader::Column(const std::string &_name) const {
+    std::vector<std::string>::const_iterator it = std::find(columns_.begin(), columns_.end(), _name);
+    return it == columns_.end() ? -1 : static_cast<int>(it - columns_.begin());
+}
+
+unsigned FlightLogReader::BlockCount() const {
+    return blocks_.size();
+}
+
+unsigned FlightLogReader::BlockRows(unsigned _block) const {
+    return blocks_[_block].rows;
+}
+
+std::size_t FlightLogReader::RowCount() const {
+    return rows_;
+}
+
+const double* FlightLogReader::Data(unsigned _block, unsigned _column) const {
+    return blocks_[_block].data + std::size_t(_column) * blocks_[_block].rows;
+}
+
+std::vector<double> FlightLogReader::Read(unsigned _column) const {
+    std::vector<double> values;
+    values.reserve(rows_);
+    for (unsigned b = 0; b < blocks_.size(); ++b) {
+        const double* data = Data(b, _column);
+        values.insert(values.end(), data, data + blocks_[b].rows);
+    }
+    return values;
+}
+
+const std::map<uint32_t, std::string>& FlightLogReader::Vehicles() const {
+    return vehicles_;
+}
+
+std::string FlightLogReader::VehicleName(uint32_t _id) const {
+    std::map<uint32_t, std::string>::const_iterator it = vehicles_.find(_id);
+    return it == vehicles_.end() ? std::to_string(_id) : it->second;
+}
+
+}
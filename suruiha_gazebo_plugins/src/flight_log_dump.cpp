@@ -0,0 +1,83 @@
+/*
+ * flight_log_dump.cpp
+ *
+ *  Prints a flight log written by the recordFile option of the controllers
+ *  as csv, one row per sample with the vehicle named instead of numbered.
+ *
+ *  usage: flight_log_dump <log> [vehicle]
+ *         flight_log_dump --info <log>
+ */
+
+#include <suruiha_gazebo_plugins/flight_log.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using gazebo::FlightLogReader;
+
+static int Info(const FlightLogReader &_log) {
+    std::printf("%zu rows in %u blocks, %zu columns\n", _log.RowCount(), _log.BlockCount(),
+            _log.Columns().size());
+    const int vehicle = _log.Column("vehicle");
+    for (std::map<uint32_t, std::string>::const_iterator it = _log.Vehicles().begin();
+            it != _log.Vehicles().end(); ++it) {
+        std::size_t rows = 0;
+        for (unsigned b = 0; vehicle >= 0 && b < _log.BlockCount(); ++b) {
+            const double* ids = _log.Data(b, vehicle);
+            for (unsigned r = 0; r < _log.BlockRows(b); ++r) {
+                rows += ids[r] == it->first ? 1 : 0;
+            }
+        }
+        std::printf("  %u %s: %zu rows\n", it->first, it->second.c_str(), rows);
+    }
+    return 0;
+}
+
+static int Dump(const FlightLogReader &_log, const char* _vehicle) {
+    const std::vector<std::string> &columns = _log.Columns();
+    const int vehicle = _log.Column("vehicle");
+    for (unsigned c = 0; c < columns.size(); ++c) {
+        std::printf(c == 0 ? "%s" : ",%s", columns[c].c_str());
+    }
+    std::printf("\n");
+
+    for (unsigned b = 0; b < _log.BlockCount(); ++b) {
+        for (unsigned r = 0; r < _log.BlockRows(b); ++r) {
+            std::string name;
+            if (vehicle >= 0) {
+                name = _log.VehicleName(static_cast<uint32_t>(_log.Data(b, vehicle)[r]));
+                if (_vehicle != nullptr && name != _vehicle) {
+                    continue;
+                }
+            }
+            for (unsigned c = 0; c < columns.size(); ++c) {
+                if (c > 0) {
+                    std::printf(",");
+                }
+                if (static_cast<int>(c) == vehicle) {
+                    std::printf("%s", name.c_str());
+                } else {
+                    std::printf("%.9g", _log.Data(b, c)[r]);
+                }
+            }
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const bool info = argc > 1 && std::strcmp(argv[1], "--info") == 0;
+    const int first = info ? 2 : 1;
+    if (argc <= first || argc > first + (info ? 1 : 2)) {
+        std::fprintf(stderr, "usage: %s <log> [vehicle]\n       %s --info <log>\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    FlightLogReader log;
+    if (!log.Open(argv[first])) {
+        std::fprintf(stderr, "%s is not a flight log\n", argv[first]);
+        return 1;
+    }
+    return info ? Info(log) : Dump(log, argc > first + 1 ? argv[first + 1] : nullptr);
+}
@@ -0,0 +1,178 @@
+/*
+ * flight_recorder.cpp
+ */
+
+#include <suruiha_gazebo_plugins/flight_recorder.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/common/Console.hh>
+#include <boost/bind.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace gazebo {
+
+    const unsigned FlightSample::ACTUATORS;
+    const unsigned FlightRecorder::BLOCK_ROWS;
+
+    std::vector<std::string> FlightSample::ColumnNames() {
+        const char* state[] = {"time", "vehicle", "tick", "x", "y", "z", "qw", "qx", "qy", "qz",
+                "vx", "vy", "vz", "p", "q", "r"};
+        std::vector<std::string> names(state, state + CMD);
+        const char* actuator[] = {"cmd", "p_err", "i_err", "d_err"};
+        for (unsigned a = 0; a < sizeof(actuator) / sizeof(actuator[0]); ++a) {
+            for (unsigned i = 0; i < ACTUATORS; ++i) {
+                names.push_back(actuator[a] + std::to_string(i));
+            }
+        }
+        return names;
+    }
+
+    void FlightSample::SetState(uint32_t _vehicle, const VehicleState &_state, bool _tick) {
+        values[TIME] = _state.time.Double();
+        values[VEHICLE] = _vehicle;
+        values[TICK] = _tick ? 1.0 : 0.0;
+        values[X] = _state.pose.Pos().X();
+        values[Y] = _state.pose.Pos().Y();
+        values[Z] = _state.pose.Pos().Z();
+        values[QW] = _state.pose.Rot().W();
+        values[QX] = _state.pose.Rot().X();
+        values[QY] = _state.pose.Rot().Y();
+        values[QZ] = _state.pose.Rot().Z();
+        values[VX] = _state.linearVel.X();
+        values[VY] = _state.linearVel.Y();
+        values[VZ] = _state.linearVel.Z();
+        values[P] = _state.bodyRates.X();
+        values[Q] = _state.bodyRates.Y();
+        values[R] = _state.bodyRates.Z();
+        for (unsigned c = CMD; c < COLUMN_COUNT; ++c) {
+            values[c] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    FlightRecorder::FlightRecorder() : ring_(2), dropped_(0), running_(false), stagedRows_(0),
+            writeFailed_(false) {
+    }
+
+    FlightRecorder::~FlightRecorder() {
+        Close();
+    }
+
+    bool FlightRecorder::Load(sdf::ElementPtr _sdf) {
+        if (!_sdf->HasElement("recordFile")) {
+            return false;
+        }
+        const std::string path = _sdf->Get<std::string>("recordFile");
+        double buffer;
+        Util::GetSdfParam(_sdf, "recordBuffer", buffer, 1 << 14);
+        if (!Open(path, buffer > 0 ? static_cast<unsigned>(buffer) : 1)) {
+            gzerr << "cannot open flight log [" << path << "]: " << std::strerror(errno)
+                  << ", nothing is recorded\n";
+            return false;
+        }
+        gzmsg << "recording flights to [" << path << "]\n";
+        return true;
+    }
+
+    bool FlightRecorder::Open(const std::string &_path, unsigned _bufferSamples) {
+        Close();
+        if (!writer_.Open(_path, FlightSample::ColumnNames())) {
+            return false;
+        }
+        path_ = _path;
+        ring_.Reset(_bufferSamples);
+        dropped_.store(0);
+        staged_.assign(FlightSample::COLUMN_COUNT * BLOCK_ROWS, 0.0);
+        stagedRows_ = 0;
+        writeFailed_ = false;
+        running_.store(true);
+        this->writer_thread_ = boost::thread(boost::bind(&FlightRecorder::WriterThread, this));
+        return true;
+    }
+
+    void FlightRecorder::Close() {
+        if (!running_.load()) {
+            return;
+        }
+        running_.store(false, std::memory_order_release);
+        if (this->writer_thread_.joinable()) {
+            this->writer_thread_.join();
+        }
+        writer_.Close();
+        if (dropped_.load() > 0) {
+            gzwarn << "flight log [" << path_ << "] dropped " << dropped_.load()
+                   << " samples, raise <recordBuffer>\n";
+        }
+        boost::mutex::scoped_lock lock(this->vehicles_mutex_);
+        vehicles_.clear();
+        pendingVehicles_.clear();
+    }
+
+    bool FlightRecorder::IsOpen() const {
+        return running_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t FlightRecorder::AddVehicle(const std::string &_name) {
+        boost::mutex::scoped_lock lock(this->vehicles_mutex_);
+        const uint32_t id = vehicles_.size();
+        vehicles_.push_back(_name);
+        pendingVehicles_.push_back(id);
+        return id;
+    }
+
+    unsigned long FlightRecorder::Dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    void FlightRecorder::WriterThread() {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point lastWrite = Clock::now();
+        FlightSample sample;
+        while (true) {
+            // read before draining, every sample recorded before Close is in the ring by now
+            const bool running = running_.load(std::memory_order_acquire);
+            while (stagedRows_ < BLOCK_ROWS && ring_.Pop(sample)) {
+                for (unsigned c = 0; c < FlightSample::COLUMN_COUNT; ++c) {
+                    staged_[c * BLOCK_ROWS + stagedRows_] = sample.values[c];
+                }
+                stagedRows_++;
+            }
+            if (stagedRows_ == BLOCK_ROWS) {
+                WriteBlock();
+                lastWrite = Clock::now();
+                continue;
+            }
+            if (!running) {
+                WriteBlock();
+                return;
+            }
+            // a slow simulation still gets its rows into the file every second
+            if (stagedRows_ > 0 && Clock::now() - lastWrite > std::chrono::seconds(1)) {
+                WriteBlock();
+                lastWrite = Clock::now();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void FlightRecorder::WriteBlock() {
+        bool written = true;
+        {
+            boost::mutex::scoped_lock lock(this->vehicles_mutex_);
+            for (unsigned i = 0; i < pendingVehicles_.size(); ++i) {
+                const uint32_t id = pendingVehicles_[i];
+                written = writer_.AppendVehicle(id, vehicles_[id]) && written;
+            }
+            pendingVehicles_.clear();
+        }
+        written = writer_.AppendRows(staged_.data(), stagedRows_, BLOCK_ROWS) && written;
+        stagedRows_ = 0;
+        if (!written && !writeFailed_) {
+            gzerr << "cannot write flight log [" << path_ << "]: " << std::strerror(errno)
+                  << ", samples are lost\n";
+            writeFailed_ = true;
+        }
+    }
+}
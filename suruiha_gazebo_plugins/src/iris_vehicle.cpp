@@ -0,0 +1,348 @@
+/*
+ * iris_vehicle.cpp
+ */
+
+#include <suruiha_gazebo_plugins/iris_vehicle.h>
+#include <suruiha_gazebo_plugins/vehicle_config.h>
+#include <suruiha_gazebo_plugins/vehicle_handoff.h>
+#include <geometry_msgs/Pose.h>
+#include <ignition/math.hh>
+#include <sdf/sdf.hh>
+#include <algorithm>
+
+namespace gazebo {
+
+    IrisVehicle::IrisVehicle() {
+        lastUpdateTime = 0;
+        lastPosePublishTime = 0;
+        targetThrottle = 0.0;
+        targetPitch = 0.0;
+        targetRoll = 0.0;
+        targetYaw = 0.0;
+        poseUpdateRate = 100;
+        bank = nullptr;
+        bankIndex = -1;
+        pitchOffset = 0.041;
+        controlActive = false;
+        controlTick = false;
+        statsInterval = 0;
+        profiler = nullptr;
+        recorder = nullptr;
+        recordId = 0;
+        lockstep = false;
+        onboardHold = false;
+    }
+
+    bool IrisVehicle::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf, RotorBank* _bank) {
+        this->model = _model;
+        this->name = _sdf->GetParent()->GetAttribute("name")->GetAsString();
+
+        // parsed once for every model spawned from the same sdf
+        std::shared_ptr<const IrisConfig> config = IrisConfig::Get(_sdf);
+        if (!config) {
+            gzerr << "iris [" << this->name << "] is not controlled.\n";
+            return false;
+        }
+        poseUpdateRate = config->poseUpdateRate;
+        pitchOffset = config->pitchOffset;
+        statsInterval = config->statsInterval;
+        lockstep = config->lockstep;
+        controlClock = config->controlClock;
+        recordClock.SetRate(config->recordRate);
+        onboardHold = config->onboardHold;
+        hold = config->hold;
+
+        // every joint is found before the bank takes any rotor
+        std::vector<physics::JointPtr> joints;
+        for (unsigned i = 0; i < config->rotors.size(); ++i) {
+            physics::JointPtr joint = model->GetJoint(config->rotors[i].jointName);
+            if (joint == nullptr) {
+                gzerr << "Couldn't find specified joint ["
+                      << config->rotors[i].jointName << "]. This plugin will not run.\n";
+                return false;
+            }
+            joints.push_back(joint);
+        }
+
+        this->bank = _bank;
+        this->bankIndex = this->bank->AddVehicle();
+        // the filters advance on control ticks only, RotorBank::Idle stops
+        // them in between, so they sample at the control rate if there is one
+        const double physicsRate = 1.0 / this->model->GetWorld()->Physics()->GetMaxStepSize();
+        const double filterRate = controlClock.EveryStep() ? physicsRate :
+                std::min(physicsRate, 1.0 / controlClock.period.Double());
+        for (unsigned i = 0; i < config->rotors.size(); ++i) {
+            RotorControl rotor = config->rotors[i];
+            rotor.joint = joints[i];
+            if (rotor.filterOrder > 0 && rotor.samplingRate <= 0) {
+                rotor.samplingRate = filterRate;
+                if (rotor.frequencyCutoff >= rotor.samplingRate / 2) {
+                    gzerr << "rotor for joint [" << rotor.jointName
+                          << "] needs a frequencyCutoff below half the "
+                          << (controlClock.EveryStep() ? "physics" : "control") << " rate,"
+                          << " velocity not filtered.\n";
+                    rotor.filterOrder = 0;
+                }
+            }
+            this->bank->AddRotor(this->bankIndex, rotor);
+            this->rotorJoints.push_back(rotor.joint);
+        }
+
+        // a blade that cannot be found is left out, as LiftDragPlugin would do
+        this->liftDrag.Load(this->model, _sdf, "lift_drag");
+        return true;
+    }
+
+    void IrisVehicle::Unload() {
+        controlSub.shutdown();
+        posePub.shutdown();
+        if (bank != nullptr && bankIndex >= 0) {
+            bank->RemoveVehicle(bankIndex);
+        }
+        bank = nullptr;
+        bankIndex = -1;
+        rotorJoints.clear();
+        liftDrag.Clear();
+        schedule.Clear();
+        holdSchedule.Clear();
+        hold.Reset();
+        model.reset();
+    }
+
+    static IrisTargets TargetsFromTwist(const geometry_msgs::Twist &_control) {
+        IrisTargets targets;
+        targets.throttle = _control.linear.z;
+        targets.pitch = _control.angular.y;
+        targets.roll = _control.angular.x;
+        targets.yaw = _control.angular.z;
+        return targets;
+    }
+
+    static IrisSetpoint SetpointFromTwist(const geometry_msgs::Twist &_control) {
+        IrisSetpoint setpoint;
+        setpoint.x = _control.linear.x;
+        setpoint.y = _control.linear.y;
+        setpoint.z = _control.linear.z;
+        setpoint.yaw = _control.angular.z;
+        setpoint.valid = true;
+        return setpoint;
+    }
+
+    void IrisVehicle::SetControl(const geometry_msgs::Twist &_control) {
+        if (onboardHold) {
+            setpoint.Write(SetpointFromTwist(_control));
+        } else {
+            command.Write(TargetsFromTwist(_control));
+        }
+    }
+
+    void IrisVehicle::SetControlStamped(const geometry_msgs::TwistStamped &_control,
+            const common::Time &_now) {
+        common::Time stamp(_control.header.stamp.sec, _control.header.stamp.nsec);
+        bool onTime;
+        if (onboardHold) {
+            onTime = holdSchedule.Push(stamp, SetpointFromTwist(_control.twist), _now);
+        } else {
+            onTime = schedule.Push(stamp, TargetsFromTwist(_control.twist), _now);
+        }
+        if (!onTime) {
+            stats.lateCommands++;
+        }
+    }
+
+    std::string IrisVehicle::ControlTopic() const {
+        return name + (lockstep ? "_control_stamped" : "_control");
+    }
+
+    void IrisVehicle::Export(suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        _msg.name = name;
+        _msg.type = "iris";
+        Handoff::SaveModel(model, rotorJoints, _msg);
+        stats.poseReads++;
+        stats.jointReads += rotorJoints.size();
+
+        const IrisTargets &last = command.Read();
+        _msg.targets.assign({last.throttle, last.pitch, last.roll, last.yaw});
+        const IrisSetpoint &held = setpoint.Read();
+        if (onboardHold && held.valid) {
+            _msg.setpoint.assign({held.x, held.y, held.z, held.yaw});
+        }
+
+        const unsigned first = bank->FirstRotor(bankIndex);
+        const unsigned count = bank->RotorCount(bankIndex);
+        Handoff::SavePid(bank->pid, first, count, _msg);
+        Handoff::SavePid(hold.pid, 0, hold.pid.Size(), _msg);
+        for (unsigned i = first; i < first + count; ++i) {
+            _msg.filter.push_back(bank->velocityX1[i]);
+            _msg.filter.push_back(bank->velocityX2[i]);
+            _msg.filter.push_back(bank->filteredY1[i]);
+            _msg.filter.push_back(bank->filteredY2[i]);
+        }
+    }
+
+    bool IrisVehicle::Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        const unsigned first = bank->FirstRotor(bankIndex);
+        const unsigned count = bank->RotorCount(bankIndex);
+        if (_msg.targets.size() != 4 || _msg.filter.size() != 4 * count ||
+                _msg.i_err.size() != count + hold.pid.Size()) {
+            gzerr << "iris [" << name << "] handoff does not match its rotors, not restored.\n";
+            return false;
+        }
+        if (!Handoff::RestoreModel(model, rotorJoints, _msg)) {
+            gzerr << "iris [" << name << "] handoff does not match its joints, not restored.\n";
+            return false;
+        }
+
+        unsigned offset = 0;
+        Handoff::RestorePid(bank->pid, first, count, _msg, offset);
+        Handoff::RestorePid(hold.pid, 0, hold.pid.Size(), _msg, offset);
+        for (unsigned i = 0; i < count; ++i) {
+            bank->velocityX1[first + i] = _msg.filter[4 * i];
+            bank->velocityX2[first + i] = _msg.filter[4 * i + 1];
+            bank->filteredY1[first + i] = _msg.filter[4 * i + 2];
+            bank->filteredY2[first + i] = _msg.filter[4 * i + 3];
+        }
+
+        IrisTargets last;
+        last.throttle = targetThrottle = _msg.targets[0];
+        last.pitch = targetPitch = _msg.targets[1];
+        last.roll = targetRoll = _msg.targets[2];
+        last.yaw = targetYaw = _msg.targets[3];
+        command.Write(last);
+        if (_msg.setpoint.size() == 4) {
+            IrisSetpoint held;
+            held.x = _msg.setpoint[0];
+            held.y = _msg.setpoint[1];
+            held.z = _msg.setpoint[2];
+            held.yaw = _msg.setpoint[3];
+            held.valid = true;
+            setpoint.Write(held);
+        }
+        return true;
+    }
+
+    void IrisVehicle::Update(const common::Time &_currTime) {
+        Prepare(_currTime);
+        if (controlTick) {
+            SURUIHA_PROFILE_SCOPE(profiler, MIXER);
+            bank->Mix();
+        }
+        Actuate();
+    }
+
+    void IrisVehicle::Prepare(const common::Time &_currTime) {
+    	stats.steps++;
+    	{
+    		SURUIHA_PROFILE_SCOPE(profiler, STATE);
+    		state.Read(this->model, this->rotorJoints, _currTime);
+    	}
+    	{
+    		SURUIHA_PROFILE_SCOPE(profiler, PUBLISH);
+    		PublishPose(_currTime);
+    	}
+
+    	// in lockstep mode this thread is also the only writer of the mailbox
+    	IrisTargets due;
+    	if (lockstep && schedule.PopDue(_currTime, due)) {
+    		command.Write(due);
+    	}
+    	IrisSetpoint dueSetpoint;
+    	if (lockstep && holdSchedule.PopDue(_currTime, dueSetpoint)) {
+    		setpoint.Write(dueSetpoint);
+    	}
+
+    	const IrisSetpoint *holdSetpoint = nullptr;
+    	if (onboardHold) {
+    		holdSetpoint = &setpoint.Read();
+    		controlActive = holdSetpoint->valid;
+    	} else {
+    		controlActive = controlSub.getNumPublishers() > 0;
+    	}
+    	controlTick = controlActive && controlClock.Due(_currTime);
+    	if (controlTick) {
+    		controlDt = (_currTime - lastUpdateTime).Double();
+    		if (onboardHold) {
+    			// the outer loops run on this tick, no pose has to go out first
+    			hold.Update(state, *holdSetpoint, controlDt.Double(),
+    					targetThrottle, targetPitch, targetRoll, targetYaw);
+    		} else {
+    			const IrisTargets &targets = command.Read();
+    			targetThrottle = targets.throttle;
+    			targetPitch = targets.pitch;
+    			targetRoll = targets.roll;
+    			targetYaw = targets.yaw;
+    		}
+
+			// get joint values from planner and set joints
+			CalculateRotors(targetThrottle, targetPitch, targetRoll, targetYaw);
+    	} else {
+    		bank->Idle(bankIndex);
+    	}
+
+        if (controlTick || !controlActive) {
+            this->lastUpdateTime = _currTime;
+        }
+        stats.Report(this->name, _currTime, statsInterval);
+    }
+
+    void IrisVehicle::PublishPose(const common::Time &_currTime) {
+    	if (this->posePub.getNumSubscribers() > 0) {
+    		double dt_ = (_currTime - lastPosePublishTime).Double()*1000; // miliseconds
+    		if (dt_ > poseUpdateRate) {
+    			const ignition::math::Pose3d &pose = state.pose;
+    			geometry_msgs::Pose poseMsg;
+    			poseMsg.position.x = pose.Pos().X();
+    			poseMsg.position.y = pose.Pos().Y();
+    			poseMsg.position.z = pose.Pos().Z();
+    			poseMsg.orientation.x = pose.Rot().X();
+    			poseMsg.orientation.y = pose.Rot().Y();
+    			poseMsg.orientation.z = pose.Rot().Z();
+    			poseMsg.orientation.w = pose.Rot().W();
+    			this->posePub.publish(poseMsg);
+    			lastPosePublishTime = _currTime;
+    		}
+    	}
+    }
+
+    void IrisVehicle::Actuate() {
+        SURUIHA_PROFILE_SCOPE(profiler, PID);
+        if (controlTick) {
+            bank->Apply(bankIndex);
+        } else if (controlActive) {
+            // forces are cleared every step, apply the last ones again
+            bank->Hold(bankIndex);
+        }
+        liftDrag.Update();
+        Record();
+    }
+
+    void IrisVehicle::Record() {
+        if (recorder == nullptr || !recordClock.Due(state.time)) {
+            return;
+        }
+        SURUIHA_PROFILE_SCOPE(profiler, RECORD);
+        FlightSample sample;
+        sample.SetState(recordId, state, controlTick);
+        const unsigned first = bank->FirstRotor(bankIndex);
+        const unsigned count = std::min(bank->RotorCount(bankIndex), FlightSample::ACTUATORS);
+        for (unsigned k = 0; k < count; ++k) {
+            sample.values[FlightSample::CMD + k] = bank->cmd[first + k];
+            sample.values[FlightSample::P_ERR + k] = bank->pid.pErrLast[first + k];
+            sample.values[FlightSample::I_ERR + k] = bank->pid.iErr[first + k];
+            sample.values[FlightSample::D_ERR + k] = bank->pid.dErr[first + k];
+        }
+        recorder->Record(sample);
+    }
+
+    void IrisVehicle::CalculateRotors(double targetThrottle, double targetPitch, double targetRoll,
+    		double targetYaw) {
+	const ignition::math::Vector3d &euler = state.euler;
+	double pitchFactor = euler.Y() + pitchOffset - targetPitch;
+	double rollFactor = euler.X() - targetRoll;
+	double yawFactor = euler.Z() - targetYaw; //Normalize(euler.Z());
+
+	// the rotor commands are computed for the whole bank by RotorBank::Mix
+	bank->SetInputs(bankIndex, targetThrottle, pitchFactor, rollFactor, yawFactor);
+	bank->SetFeedback(bankIndex, controlDt, state.jointVelocities);
+}
+}
@@ -6,68 +6,61 @@
 
 namespace gazebo {
 
-JointControl::JointControl() {
-    this->pid.Init(0.1, 0, 0, 0, 1.0, -1.0);
-    this->jointType = JointType::EFFORT;
-}
-
-JointControl::~JointControl() {
+bool JointTypeFromString(const std::string &_name, JointType &_type) {
+    if (_name == "position") {
+        _type = POSITION;
+    } else if (_name == "velocity") {
+        _type = VELOCITY;
+    } else if (_name == "effort") {
+        _type = EFFORT;
+    } else {
+        return false;
+    }
+    return true;
 }
 
-void JointControl::SetPIDParams(double p, double i, double d, double imax, double imin, double cmdMax, double cmdMin) {
-    this->pid.Init(p, i, d, imax, imin, cmdMax, cmdMin);
+common::PID DefaultJointPid() {
+    common::PID pid;
+    pid.Init(0.1, 0, 0, 0, 1.0, -1.0);
+    return pid;
 }
 
-void JointControl::SetJointType(std::string jointTypeString) {
-    if (jointTypeString == "position") {
-        this->jointType = JointType::POSITION;
-    } else if (jointTypeString == "velocity") {
-        this->jointType = JointType::VELOCITY;
-    } else if (jointTypeString == "effort") {
-        this->jointType = JointType::EFFORT;
-    } else {
-        gzerr << "Unknown joint type\n";
+void JointBank::Add(const std::string &_name, const std::string &_type,
+        physics::JointPtr _joint, const common::PID &_pid) {
+    JointType type = EFFORT;
+    if (!JointTypeFromString(_type, type)) {
+        gzerr << "Unknown joint type [" << _type << "] of joint ["
+              << _name << "], controlled by effort\n";
     }
+    Add(_name, type, _joint, _pid);
 }
 
-void JointControl::SetCommand(double command, common::Time dt_) {
-    switch (this->jointType) {
-        case JointType::POSITION:
-            this->SetPosition(command, dt_);
+void JointBank::Add(const std::string &_name, JointType _type,
+        physics::JointPtr _joint, const common::PID &_pid) {
+    const unsigned index = commands.size();
+    switch (_type) {
+        case POSITION:
+            position.Add(_name, _joint, _pid, index);
             break;
-        case JointType::VELOCITY:
-            this->SetVelocity(command, dt_);
+        case VELOCITY:
+            velocity.Add(_name, _joint, _pid, index);
             break;
-        case JointType::EFFORT:
-            this->SetEffort(command);
+        case EFFORT:
+            effort.Add(_name, _joint, _pid, index);
             break;
-        default:
-            gzerr << "Unknown joint type\n";
     }
+    commands.push_back(0.0);
 }
 
-void JointControl::SetPosition(double position, common::Time dt_) {
-    const double currentPos = this->joint->Position(0);
-    const double error = currentPos - position;
-    const double force = this->pid.Update(error, dt_);
-//    gzdbg << "position current:" << currentPos << " target:" << position << " err:" << error << " force:" << force << "\n";
-    this->ApplyForce(force);
-}
-
-void JointControl::SetVelocity(double velocity, common::Time dt_) {
-    const double currentVel = this->joint->GetVelocity(0);
-    const double error = currentVel - velocity;
-    const double force = this->pid.Update(error, dt_);
-//    gzdbg << "velocity current:" << currentVel << " target:" << velocity << " err:" << error << " force:" << force << "\n";
-    this->ApplyForce(force);
-}
-
-void JointControl::SetEffort(double effort) {
-    this->ApplyForce(effort);
+unsigned JointBank::Size() const {
+    return commands.size();
 }
 
-void JointControl::ApplyForce(double force) {
-    joint->SetForce(0, force);
+void JointBank::Clear() {
+    position.Clear();
+    velocity.Clear();
+    effort.Clear();
+    commands.clear();
 }
 
 }
@@ -0,0 +1,207 @@
+/*
+ * lift_drag_bank.cpp
+ */
+
+#include <suruiha_gazebo_plugins/lift_drag_bank.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <algorithm>
+#include <cmath>
+
+namespace gazebo {
+
+static ignition::math::Vector3d GetVector(sdf::ElementPtr _sdf, const std::string &_name,
+        const ignition::math::Vector3d &_defaultValue) {
+    if (!_sdf->HasElement(_name)) {
+        return _defaultValue;
+    }
+    return _sdf->Get<ignition::math::Vector3d>(_name);
+}
+
+bool LiftDragBank::Add(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
+    std::string name = _sdf->HasAttribute("name") ? _sdf->GetAttribute("name")->GetAsString() : "";
+    if (!_sdf->HasElement("link_name")) {
+        gzerr << "surface [" << name << "] has no link_name, it is ignored.\n";
+        return false;
+    }
+    const std::string linkName = _sdf->Get<std::string>("link_name");
+    physics::LinkPtr surfaceLink = _model->GetLink(linkName);
+    if (surfaceLink == nullptr) {
+        gzerr << "Link with name [" << linkName << "] of surface [" << name << "] not found.\n";
+        return false;
+    }
+
+    physics::JointPtr joint;
+    double radToCL;
+    Util::GetSdfParam(_sdf, "control_joint_rad_to_cl", radToCL, 4.0);
+    if (_sdf->HasElement("control_joint_name")) {
+        const std::string jointName = _sdf->Get<std::string>("control_joint_name");
+        joint = _model->GetJoint(jointName);
+        if (joint == nullptr) {
+            gzerr << "Joint with name [" << jointName << "] of surface [" << name << "] not found.\n";
+            return false;
+        }
+    }
+
+    // defaults of LiftDragPlugin
+    double value;
+    Util::GetSdfParam(_sdf, "a0", value, 0.0);
+    alpha0.push_back(value);
+    Util::GetSdfParam(_sdf, "cla", value, 1.0);
+    cla.push_back(value);
+    Util::GetSdfParam(_sdf, "cda", value, 0.01);
+    cda.push_back(value);
+    Util::GetSdfParam(_sdf, "alpha_stall", value, 0.5 * M_PI);
+    alphaStall.push_back(value);
+    Util::GetSdfParam(_sdf, "cla_stall", value, 0.0);
+    claStall.push_back(value);
+    Util::GetSdfParam(_sdf, "cda_stall", value, 1.0);
+    cdaStall.push_back(value);
+    double area, rho;
+    Util::GetSdfParam(_sdf, "area", area, 1.0);
+    Util::GetSdfParam(_sdf, "air_density", rho, 1.2041);
+    halfRhoArea.push_back(0.5 * rho * area);
+
+    cp.push_back(GetVector(_sdf, "cp", ignition::math::Vector3d(0, 0, 0)));
+    forward.push_back(GetVector(_sdf, "forward", ignition::math::Vector3d(1, 0, 0)).Normalize());
+    upward.push_back(GetVector(_sdf, "upward", ignition::math::Vector3d(0, 0, 1)).Normalize());
+    radialSymmetry.push_back(_sdf->HasElement("radial_symmetry") && _sdf->Get<bool>("radial_symmetry"));
+    controlJoint.push_back(joint);
+    controlJointRadToCL.push_back(radToCL);
+    names.push_back(name);
+
+    // surfaces of the same link share its state
+    unsigned index = std::find(links.begin(), links.end(), surfaceLink) - links.begin();
+    if (index == links.size()) {
+        links.push_back(surfaceLink);
+        linkCoG.push_back(surfaceLink->GetInertial()->CoG());
+        pose_.push_back(ignition::math::Pose3d());
+        vel_.push_back(ignition::math::Vector3d());
+        angularVel_.push_back(ignition::math::Vector3d());
+    }
+    link.push_back(index);
+    return true;
+}
+
+bool LiftDragBank::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf, const std::string &_element) {
+    bool loaded = true;
+    if (_sdf->HasElement(_element)) {
+        for (sdf::ElementPtr surface = _sdf->GetElement(_element); surface;
+                surface = surface->GetNextElement(_element)) {
+            loaded = Add(_model, surface) && loaded;
+        }
+    }
+    return loaded;
+}
+
+unsigned LiftDragBank::Size() const {
+    return names.size();
+}
+
+void LiftDragBank::Clear() {
+    names.clear();
+    link.clear();
+    cp.clear();
+    forward.clear();
+    upward.clear();
+    radialSymmetry.clear();
+    alpha0.clear();
+    cla.clear();
+    cda.clear();
+    alphaStall.clear();
+    claStall.clear();
+    cdaStall.clear();
+    halfRhoArea.clear();
+    controlJoint.clear();
+    controlJointRadToCL.clear();
+    links.clear();
+    linkCoG.clear();
+    pose_.clear();
+    vel_.clear();
+    angularVel_.clear();
+}
+
+/// \brief force coefficient of LiftDragPlugin at _alpha, linear up to the
+/// stall angle and with the stall slope beyond it
+static inline double Coefficient(double _alpha, double _slope, double _alphaStall,
+        double _stallSlope) {
+    if (_alpha > _alphaStall) {
+        return _slope * _alphaStall + _stallSlope * (_alpha - _alphaStall);
+    } else if (_alpha < -_alphaStall) {
+        return -_slope * _alphaStall + _stallSlope * (_alpha + _alphaStall);
+    }
+    return _slope * _alpha;
+}
+
+void LiftDragBank::Update() {
+    const unsigned linkCount = links.size();
+    for (unsigned l = 0; l < linkCount; ++l) {
+        pose_[l] = links[l]->WorldPose();
+        vel_[l] = links[l]->WorldCoGLinearVel();
+        angularVel_[l] = links[l]->WorldAngularVel();
+    }
+
+    const unsigned n = names.size();
+    for (unsigned i = 0; i < n; ++i) {
+        const unsigned l = link[i];
+        const ignition::math::Quaterniond &rot = pose_[l].Rot();
+
+        // velocity at cp, what Link::WorldLinearVel(cp) gives
+        ignition::math::Vector3d vel = vel_[l] + angularVel_[l].Cross(rot.RotateVector(cp[i] - linkCoG[l]));
+        if (vel.Length() <= 0.01) {
+            continue;
+        }
+        ignition::math::Vector3d velI = vel;
+        velI.Normalize();
+
+        const ignition::math::Vector3d forwardI = rot.RotateVector(forward[i]);
+        ignition::math::Vector3d upwardI;
+        if (radialSymmetry[i]) {
+            // upward is the part of the inflow perpendicular to forward
+            upwardI = forwardI.Cross(forwardI.Cross(velI)).Normalize();
+        } else {
+            upwardI = rot.RotateVector(upward[i]);
+        }
+        const ignition::math::Vector3d spanwiseI = forwardI.Cross(upwardI).Normalize();
+
+        // sweep, the angle between the inflow and the lift drag plane;
+        // cos from 1 - sin^2 as LiftDragPlugin does
+        const double sinSweep = ignition::math::clamp(spanwiseI.Dot(velI), -1.0, 1.0);
+        const double cosSweep = 1.0 - sinSweep * sinSweep;
+
+        // the spanwise part of vel removed as LiftDragPlugin does
+        const ignition::math::Vector3d velInLDPlane = vel - velI * vel.Dot(spanwiseI);
+        ignition::math::Vector3d dragDirection = -velInLDPlane;
+        dragDirection.Normalize();
+        ignition::math::Vector3d liftI = spanwiseI.Cross(velInLDPlane);
+        liftI.Normalize();
+
+        // angle of attack, positive when lift points forward
+        const double cosAlpha = ignition::math::clamp(liftI.Dot(upwardI), -1.0, 1.0);
+        double alpha = liftI.Dot(forwardI) >= 0.0 ? alpha0[i] + std::acos(cosAlpha)
+                                                  : alpha0[i] - std::acos(cosAlpha);
+        while (std::fabs(alpha) > 0.5 * M_PI) {
+            alpha = alpha > 0 ? alpha - M_PI : alpha + M_PI;
+        }
+
+        const double speed = velInLDPlane.Length();
+        const double qArea = halfRhoArea[i] * speed * speed;
+
+        double cl = Coefficient(alpha, cla[i], alphaStall[i], claStall[i]) * cosSweep;
+        if (alpha > alphaStall[i]) {
+            cl = std::max(0.0, cl);
+        } else if (alpha < -alphaStall[i]) {
+            cl = std::min(0.0, cl);
+        }
+        if (controlJoint[i]) {
+            cl = cl + controlJointRadToCL[i] * controlJoint[i]->Position(0);
+        }
+        const double cd = std::fabs(Coefficient(alpha, cda[i], alphaStall[i], cdaStall[i]) * cosSweep);
+
+        // LiftDragPlugin applies no pitching moment, cm is always reset to 0
+        ignition::math::Vector3d force = liftI * (cl * qArea) + dragDirection * (cd * qArea);
+        force.Correct();
+        links[l]->AddForceAtRelativePosition(force, cp[i]);
+    }
+}
+
+}
@@ -0,0 +1,32 @@
+/*
+ * lift_drag_controller.cpp
+ */
+
+#include <suruiha_gazebo_plugins/lift_drag_controller.h>
+#include <boost/bind.hpp>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_MODEL_PLUGIN(LiftDragController);
+
+    LiftDragController::~LiftDragController() {
+        this->update_connection_.reset();
+    }
+
+    void LiftDragController::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf) {
+        surfaces_.Load(_parent, _sdf, "surface");
+        if (surfaces_.Size() == 0) {
+            gzerr << "LiftDragController of [" << _parent->GetName() << "] has no surface.\n";
+            return;
+        }
+
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&LiftDragController::UpdateStates, this));
+    }
+
+    void LiftDragController::UpdateStates() {
+        surfaces_.Update();
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * motor_temperature_sensor.cpp
+ */
+
+#include <suruiha_gazebo_plugins/motor_temperature_sensor.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <boost/bind.hpp>
+#include <sdf/sdf.hh>
+#include <algorithm>
+#include <cmath>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_MODEL_PLUGIN(MotorTemperatureSensor);
+
+    MotorTemperatureSensor::MotorTemperatureSensor() : rosnode_(nullptr), ambient_(25), heating_(1e-5),
+            cooling_(0.05), batch_(1), rowCount_(0), firstRowMs_(0), sequence_(0) {
+    }
+
+    MotorTemperatureSensor::~MotorTemperatureSensor() {
+        this->update_connection_.reset();
+        if (this->rosnode_ != nullptr) {
+            this->rosnode_->shutdown();
+            delete this->rosnode_;
+        }
+    }
+
+    void MotorTemperatureSensor::Load(physics::ModelPtr _parent, sdf::ElementPtr _sdf) {
+        this->world_ = _parent->GetWorld();
+
+        sdf::ElementPtr motor = _sdf->HasElement("motor") ? _sdf->GetElement("motor") : sdf::ElementPtr();
+        while (motor) {
+            const std::string name = motor->Get<std::string>();
+            physics::JointPtr joint = _parent->GetJoint(name);
+            if (joint == nullptr) {
+                gzerr << "MotorTemperatureSensor of [" << _parent->GetName() << "] has no joint [" << name << "].\n";
+                return;
+            }
+            motors_.push_back(joint);
+            motor = motor->GetNextElement("motor");
+        }
+        if (motors_.empty()) {
+            gzerr << "MotorTemperatureSensor of [" << _parent->GetName() << "] has no motor.\n";
+            return;
+        }
+
+        double sampleRate, batch;
+        Util::GetSdfParam(_sdf, "ambient", ambient_, 25.0);
+        Util::GetSdfParam(_sdf, "heating", heating_, 1e-5);
+        Util::GetSdfParam(_sdf, "cooling", cooling_, 0.05);
+        Util::GetSdfParam(_sdf, "sampleRate", sampleRate, 100);
+        Util::GetSdfParam(_sdf, "batch", batch, 10);
+        samplePeriod_ = common::Time(1.0 / std::max(sampleRate, 1.0));
+        const unsigned maxBatch = TELEMETRY_TEMPERATURE_MAX_VALUES / motors_.size();
+        batch_ = std::min(static_cast<unsigned>(std::max(batch, 1.0)), std::min(maxBatch, 255u));
+        if (batch_ != static_cast<unsigned>(batch)) {
+            gzwarn << "MotorTemperatureSensor of [" << _parent->GetName() << "] sends " << batch_
+                    << " rows per frame.\n";
+        }
+        temperatures_.assign(motors_.size(), ambient_);
+        rows_.assign(motors_.size() * batch_, 0);
+
+        std::string topic = _parent->GetName() + "_telemetry";
+        if (_sdf->HasElement("topic")) {
+            topic = _sdf->Get<std::string>("topic");
+        }
+
+        // Make sure the ROS node for Gazebo has already been initalized
+        if (!ros::isInitialized()) {
+            ROS_FATAL_STREAM_NAMED("template", "A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                    << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+            return;
+        }
+        this->rosnode_ = new ros::NodeHandle();
+        telemetryPub_ = this->rosnode_->advertise<std_msgs::UInt8MultiArray>(topic, 10);
+        msg_.data.reserve(TELEMETRY_MAX_FRAME);
+
+        lastUpdateTime_ = this->world_->SimTime();
+        nextSample_ = lastUpdateTime_;
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&MotorTemperatureSensor::UpdateStates, this));
+    }
+
+    void MotorTemperatureSensor::UpdateStates() {
+        const common::Time currTime = this->world_->SimTime();
+        const double dt = (currTime - lastUpdateTime_).Double();
+        lastUpdateTime_ = currTime;
+        for (unsigned i = 0; i < motors_.size(); i++) {
+            const double w = motors_[i]->GetVelocity(0);
+            temperatures_[i] += (heating_ * w * w - cooling_ * (temperatures_[i] - ambient_)) * dt;
+        }
+
+        if (currTime < nextSample_) {
+            return;
+        }
+        nextSample_ += samplePeriod_;
+        if (nextSample_ < currTime) {
+            // after a reset or a pause, do not catch up
+            nextSample_ = currTime + samplePeriod_;
+        }
+        if (rowCount_ == 0) {
+            firstRowMs_ = static_cast<uint32_t>(currTime.sec * 1000 + currTime.nsec / 1000000);
+        }
+        int16_t* row = &rows_[rowCount_ * motors_.size()];
+        for (unsigned i = 0; i < motors_.size(); i++) {
+            row[i] = static_cast<int16_t>(std::lround(temperatures_[i] * 16));
+        }
+        if (++rowCount_ == batch_) {
+            Publish();
+        }
+    }
+
+    void MotorTemperatureSensor::Publish() {
+        const uint16_t period = static_cast<uint16_t>(std::lround(samplePeriod_.Double() * 1000));
+        const uint16_t size = telemetry_encode_temperatures(frame_, sequence_++, firstRowMs_, period,
+                motors_.size(), rowCount_, rows_.data());
+        rowCount_ = 0;
+        if (telemetryPub_.getNumSubscribers() == 0) {
+            return;
+        }
+        msg_.data.assign(frame_, frame_ + size);
+        telemetryPub_.publish(msg_);
+    }
+}
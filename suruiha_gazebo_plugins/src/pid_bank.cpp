@@ -0,0 +1,231 @@
+/*
+ * pid_bank.cpp
+ */
+
+#include <suruiha_gazebo_plugins/pid_bank.h>
+#include <ignition/math/Helpers.hh>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// a fused multiply-add rounds once where common::PID rounds twice
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace gazebo {
+
+template <typename T>
+static void EraseRange(std::vector<T> &_v, unsigned _first, unsigned _count) {
+    _v.erase(_v.begin() + _first, _v.begin() + _first + _count);
+}
+
+unsigned PidBank::Add(const common::PID &_pid) {
+    const double inf = std::numeric_limits<double>::infinity();
+    pGain.push_back(_pid.GetPGain());
+    iGain.push_back(_pid.GetIGain());
+    dGain.push_back(_pid.GetDGain());
+    iMax.push_back(_pid.GetIMax());
+    iMin.push_back(_pid.GetIMin());
+    // common::PID skips a limit that equals 0, an infinite one never clamps
+    cmdMax.push_back(ignition::math::equal(_pid.GetCmdMax(), 0.0) ? inf : _pid.GetCmdMax());
+    cmdMin.push_back(ignition::math::equal(_pid.GetCmdMin(), 0.0) ? -inf : _pid.GetCmdMin());
+
+    // the last proportional error is set together with the proportional error
+    double pe, ie, de;
+    _pid.GetErrors(pe, ie, de);
+    iErr.push_back(ie);
+    pErrLast.push_back(pe);
+    dErr.push_back(de);
+    cmd.push_back(_pid.GetCmd());
+    return cmd.size() - 1;
+}
+
+void PidBank::Erase(unsigned _first, unsigned _count) {
+    EraseRange(pGain, _first, _count);
+    EraseRange(iGain, _first, _count);
+    EraseRange(dGain, _first, _count);
+    EraseRange(iMax, _first, _count);
+    EraseRange(iMin, _first, _count);
+    EraseRange(cmdMax, _first, _count);
+    EraseRange(cmdMin, _first, _count);
+    EraseRange(iErr, _first, _count);
+    EraseRange(pErrLast, _first, _count);
+    EraseRange(dErr, _first, _count);
+    EraseRange(cmd, _first, _count);
+}
+
+void PidBank::Clear() {
+    Erase(0, Size());
+}
+
+unsigned PidBank::Size() const {
+    return cmd.size();
+}
+
+/// \brief common::PID::Update of gazebo 9, one controller
+static inline double UpdateOne(PidBank &_bank, unsigned i, double _error, double _dt) {
+    if (_dt == 0.0 || !std::isfinite(_error)) {
+        return 0.0;
+    }
+
+    const double pTerm = _bank.pGain[i] * _error;
+    double iErr = _bank.iErr[i] + _dt * _error;
+    double iTerm = _bank.iGain[i] * iErr;
+    if (iTerm > _bank.iMax[i]) {
+        iTerm = _bank.iMax[i];
+        iErr = iTerm / _bank.iGain[i];
+    } else if (iTerm < _bank.iMin[i]) {
+        iTerm = _bank.iMin[i];
+        iErr = iTerm / _bank.iGain[i];
+    }
+    const double dErr = (_error - _bank.pErrLast[i]) / _dt;
+    const double dTerm = _bank.dGain[i] * dErr;
+
+    double cmd = -pTerm - iTerm - dTerm;
+    if (cmd > _bank.cmdMax[i]) {
+        cmd = _bank.cmdMax[i];
+    }
+    if (cmd < _bank.cmdMin[i]) {
+        cmd = _bank.cmdMin[i];
+    }
+
+    _bank.iErr[i] = iErr;
+    _bank.pErrLast[i] = _error;
+    _bank.dErr[i] = dErr;
+    _bank.cmd[i] = cmd;
+    return cmd;
+}
+
+#if defined(__AVX2__)
+
+const char* PidBank::Kernel() {
+    return "avx2";
+}
+
+void PidBank::Update(const double* _error, const double* _dt, double* _cmd) {
+    const unsigned n = Size();
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d e = _mm256_loadu_pd(_error + i);
+        const __m256d dt = _mm256_loadu_pd(_dt + i);
+        // dt != 0 and |e| < inf, false for a nan error as well
+        const __m256d valid = _mm256_and_pd(_mm256_cmp_pd(dt, zero, _CMP_NEQ_UQ),
+                _mm256_cmp_pd(_mm256_andnot_pd(sign, e), inf, _CMP_LT_OQ));
+
+        const __m256d pTerm = _mm256_mul_pd(_mm256_loadu_pd(&pGain[i]), e);
+        const __m256d ig = _mm256_loadu_pd(&iGain[i]);
+        const __m256d imax = _mm256_loadu_pd(&iMax[i]);
+        const __m256d imin = _mm256_loadu_pd(&iMin[i]);
+        const __m256d iErrOld = _mm256_loadu_pd(&iErr[i]);
+        __m256d ie = _mm256_add_pd(iErrOld, _mm256_mul_pd(dt, e));
+        __m256d iTerm = _mm256_mul_pd(ig, ie);
+        const __m256d aboveMax = _mm256_cmp_pd(iTerm, imax, _CMP_GT_OQ);
+        const __m256d belowMin = _mm256_andnot_pd(aboveMax, _mm256_cmp_pd(iTerm, imin, _CMP_LT_OQ));
+        iTerm = _mm256_blendv_pd(iTerm, imax, aboveMax);
+        iTerm = _mm256_blendv_pd(iTerm, imin, belowMin);
+        ie = _mm256_blendv_pd(ie, _mm256_div_pd(iTerm, ig), _mm256_or_pd(aboveMax, belowMin));
+
+        const __m256d pLast = _mm256_loadu_pd(&pErrLast[i]);
+        const __m256d de = _mm256_div_pd(_mm256_sub_pd(e, pLast), dt);
+        const __m256d dTerm = _mm256_mul_pd(_mm256_loadu_pd(&dGain[i]), de);
+
+        // -pTerm flips the sign, 0 - pTerm would turn -0 into +0
+        __m256d c = _mm256_sub_pd(_mm256_sub_pd(_mm256_xor_pd(pTerm, sign), iTerm), dTerm);
+        const __m256d cmax = _mm256_loadu_pd(&cmdMax[i]);
+        c = _mm256_blendv_pd(c, cmax, _mm256_cmp_pd(c, cmax, _CMP_GT_OQ));
+        const __m256d cmin = _mm256_loadu_pd(&cmdMin[i]);
+        c = _mm256_blendv_pd(c, cmin, _mm256_cmp_pd(c, cmin, _CMP_LT_OQ));
+
+        _mm256_storeu_pd(&iErr[i], _mm256_blendv_pd(iErrOld, ie, valid));
+        _mm256_storeu_pd(&pErrLast[i], _mm256_blendv_pd(pLast, e, valid));
+        _mm256_storeu_pd(&dErr[i], _mm256_blendv_pd(_mm256_loadu_pd(&dErr[i]), de, valid));
+        _mm256_storeu_pd(&cmd[i], _mm256_blendv_pd(_mm256_loadu_pd(&cmd[i]), c, valid));
+        _mm256_storeu_pd(_cmd + i, _mm256_and_pd(c, valid));
+    }
+    for (; i < n; ++i) {
+        _cmd[i] = UpdateOne(*this, i, _error[i], _dt[i]);
+    }
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+const char* PidBank::Kernel() {
+    return "neon";
+}
+
+void PidBank::Update(const double* _error, const double* _dt, double* _cmd) {
+    const unsigned n = Size();
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    const float64x2_t inf = vdupq_n_f64(std::numeric_limits<double>::infinity());
+
+    unsigned i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const float64x2_t e = vld1q_f64(_error + i);
+        const float64x2_t dt = vld1q_f64(_dt + i);
+        // dt != 0 and |e| < inf, false for a nan error as well
+        const uint64x2_t valid = vandq_u64(
+                vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(vceqq_f64(dt, zero)))),
+                vcltq_f64(vabsq_f64(e), inf));
+
+        const float64x2_t pTerm = vmulq_f64(vld1q_f64(&pGain[i]), e);
+        const float64x2_t ig = vld1q_f64(&iGain[i]);
+        const float64x2_t imax = vld1q_f64(&iMax[i]);
+        const float64x2_t imin = vld1q_f64(&iMin[i]);
+        const float64x2_t iErrOld = vld1q_f64(&iErr[i]);
+        float64x2_t ie = vaddq_f64(iErrOld, vmulq_f64(dt, e));
+        float64x2_t iTerm = vmulq_f64(ig, ie);
+        const uint64x2_t aboveMax = vcgtq_f64(iTerm, imax);
+        const uint64x2_t belowMin = vbicq_u64(vcltq_f64(iTerm, imin), aboveMax);
+        iTerm = vbslq_f64(aboveMax, imax, iTerm);
+        iTerm = vbslq_f64(belowMin, imin, iTerm);
+        ie = vbslq_f64(vorrq_u64(aboveMax, belowMin), vdivq_f64(iTerm, ig), ie);
+
+        const float64x2_t pLast = vld1q_f64(&pErrLast[i]);
+        const float64x2_t de = vdivq_f64(vsubq_f64(e, pLast), dt);
+        const float64x2_t dTerm = vmulq_f64(vld1q_f64(&dGain[i]), de);
+
+        float64x2_t c = vsubq_f64(vsubq_f64(vnegq_f64(pTerm), iTerm), dTerm);
+        const float64x2_t cmax = vld1q_f64(&cmdMax[i]);
+        c = vbslq_f64(vcgtq_f64(c, cmax), cmax, c);
+        const float64x2_t cmin = vld1q_f64(&cmdMin[i]);
+        c = vbslq_f64(vcltq_f64(c, cmin), cmin, c);
+
+        vst1q_f64(&iErr[i], vbslq_f64(valid, ie, iErrOld));
+        vst1q_f64(&pErrLast[i], vbslq_f64(valid, e, pLast));
+        vst1q_f64(&dErr[i], vbslq_f64(valid, de, vld1q_f64(&dErr[i])));
+        vst1q_f64(&cmd[i], vbslq_f64(valid, c, vld1q_f64(&cmd[i])));
+        vst1q_f64(_cmd + i, vbslq_f64(valid, c, zero));
+    }
+    for (; i < n; ++i) {
+        _cmd[i] = UpdateOne(*this, i, _error[i], _dt[i]);
+    }
+}
+
+#else
+
+const char* PidBank::Kernel() {
+    return "scalar";
+}
+
+void PidBank::Update(const double* _error, const double* _dt, double* _cmd) {
+    const unsigned n = Size();
+    for (unsigned i = 0; i < n; ++i) {
+        _cmd[i] = UpdateOne(*this, i, _error[i], _dt[i]);
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,111 @@
+/*
+ * position_hold.cpp
+ */
+
+#include <suruiha_gazebo_plugins/position_hold.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/common/Console.hh>
+#include <algorithm>
+#include <cmath>
+
+namespace gazebo {
+
+    // the scale of the laws of uav_ground_control/src/mission_executor.cpp,
+    // 430 hovers, 10 of throttle per meter and at most 0.01 of tilt
+    static const double HOVER_THROTTLE = 430;
+    static const double MAX_THROTTLE = 450;
+    static const double MIN_THROTTLE = 410;
+    static const double MAX_TILT = 0.01;
+
+    static double Clamp(double _value, double _max) {
+        return std::max(-_max, std::min(_max, _value));
+    }
+
+    PositionHold::PositionHold() {
+        positionGain = 0.5;
+        altitudeGain = 1;
+        maxSpeed = 3;
+        maxClimb = 2;
+        hoverThrottle = HOVER_THROTTLE;
+        SetLoops(common::PID(0.005, 0.001, 0, MAX_TILT / 2, -MAX_TILT / 2, MAX_TILT, -MAX_TILT),
+                common::PID(10, 2, 0, 10, -10, MAX_THROTTLE - HOVER_THROTTLE, MIN_THROTTLE - HOVER_THROTTLE));
+    }
+
+    void PositionHold::SetLoops(const common::PID &_tilt, const common::PID &_climb) {
+        pid.Clear();
+        pid.Add(_tilt);
+        pid.Add(_tilt);
+        pid.Add(_climb);
+    }
+
+    void PositionHold::Load(sdf::ElementPtr _sdf) {
+        Util::GetSdfParam(_sdf, "positionGain", positionGain, positionGain);
+        Util::GetSdfParam(_sdf, "altitudeGain", altitudeGain, altitudeGain);
+        Util::GetSdfParam(_sdf, "maxSpeed", maxSpeed, maxSpeed);
+        Util::GetSdfParam(_sdf, "maxClimb", maxClimb, maxClimb);
+        Util::GetSdfParam(_sdf, "hoverThrottle", hoverThrottle, hoverThrottle);
+
+        double maxThrottle, minThrottle, maxTilt, p, i, d;
+        Util::GetSdfParam(_sdf, "maxThrottle", maxThrottle, hoverThrottle + pid.cmdMax[CLIMB]);
+        Util::GetSdfParam(_sdf, "minThrottle", minThrottle, hoverThrottle + pid.cmdMin[CLIMB]);
+        Util::GetSdfParam(_sdf, "maxTilt", maxTilt, pid.cmdMax[FORWARD]);
+        if (maxThrottle <= hoverThrottle || minThrottle >= hoverThrottle || maxTilt <= 0) {
+            gzerr << "positionHold needs minThrottle < hoverThrottle < maxThrottle and a positive maxTilt,"
+                  << " using the defaults.\n";
+            maxThrottle = hoverThrottle + pid.cmdMax[CLIMB];
+            minThrottle = hoverThrottle + pid.cmdMin[CLIMB];
+            maxTilt = pid.cmdMax[FORWARD];
+        }
+
+        Util::GetSdfParam(_sdf, "velPGain", p, pid.pGain[FORWARD]);
+        Util::GetSdfParam(_sdf, "velIGain", i, pid.iGain[FORWARD]);
+        Util::GetSdfParam(_sdf, "velDGain", d, pid.dGain[FORWARD]);
+        const common::PID tilt(p, i, d, maxTilt / 2, -maxTilt / 2, maxTilt, -maxTilt);
+
+        Util::GetSdfParam(_sdf, "climbPGain", p, pid.pGain[CLIMB]);
+        Util::GetSdfParam(_sdf, "climbIGain", i, pid.iGain[CLIMB]);
+        Util::GetSdfParam(_sdf, "climbDGain", d, pid.dGain[CLIMB]);
+        SetLoops(tilt, common::PID(p, i, d, maxThrottle - hoverThrottle, minThrottle - hoverThrottle,
+                maxThrottle - hoverThrottle, minThrottle - hoverThrottle));
+    }
+
+    void PositionHold::Reset() {
+        for (unsigned i = 0; i < pid.Size(); ++i) {
+            pid.iErr[i] = pid.pErrLast[i] = pid.dErr[i] = pid.cmd[i] = 0;
+        }
+    }
+
+    void PositionHold::Update(const VehicleState &_state, const IrisSetpoint &_setpoint, double _dt,
+            double &_throttle, double &_pitch, double &_roll, double &_yaw) {
+        const ignition::math::Vector3d &pos = _state.pose.Pos();
+        const ignition::math::Vector3d &vel = _state.linearVel;
+
+        // position, velocity setpoint in the world frame
+        double speedX = positionGain * (_setpoint.x - pos.X());
+        double speedY = positionGain * (_setpoint.y - pos.Y());
+        const double speed = std::sqrt(speedX * speedX + speedY * speedY);
+        if (speed > maxSpeed) {
+            speedX *= maxSpeed / speed;
+            speedY *= maxSpeed / speed;
+        }
+        const double climbRate = Clamp(altitudeGain * (_setpoint.z - pos.Z()), maxClimb);
+
+        // velocity, tilt in the heading frame. The PIDs take measured minus
+        // wanted, a positive pitch flies forward and a positive roll to the right
+        const double heading = _state.euler.Z();
+        const double errX = vel.X() - speedX;
+        const double errY = vel.Y() - speedY;
+        const double error[LOOPS] = {
+            std::cos(heading) * errX + std::sin(heading) * errY,
+            -std::sin(heading) * errX + std::cos(heading) * errY,
+            vel.Z() - climbRate
+        };
+        const double dt[LOOPS] = { _dt, _dt, _dt };
+        double cmd[LOOPS];
+        pid.Update(error, dt, cmd);
+        _pitch = cmd[FORWARD];
+        _roll = -cmd[LEFT];
+        _throttle = hoverThrottle + cmd[CLIMB];
+        _yaw = _setpoint.yaw;
+    }
+}
@@ -0,0 +1,269 @@
+/*
+ * region_partition.cpp
+ */
+
+#include <suruiha_gazebo_plugins/region_partition.h>
+#include <suruiha_gazebo_plugins/swarm.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_WORLD_PLUGIN(RegionPartition);
+
+    /// \brief name of the top level model of _model, the one the world inserts and deletes
+    static std::string TopModelName(physics::ModelPtr _model) {
+        const std::string scoped = _model->GetScopedName();
+        return scoped.substr(0, scoped.find("::"));
+    }
+
+    RegionPartition::RegionPartition() : rosnode_(nullptr), self_(0), margin_(5), checkPeriod_(0.1),
+            lastCheck_(0), started_(false), handoffTimeout_(30) {
+    }
+
+    RegionPartition::~RegionPartition() {
+        this->update_connection_.reset();
+        this->handoffSub_.shutdown();
+        for (unsigned i = 0; i < handoffPubs_.size(); ++i) {
+            handoffPubs_[i].shutdown();
+        }
+        if (this->rosnode_ != nullptr) {
+            this->rosnode_->shutdown();
+            delete this->rosnode_;
+        }
+    }
+
+    void RegionPartition::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
+        this->world_ = _world;
+
+        // Make sure the ROS node for Gazebo has already been initalized
+        if (!ros::isInitialized()) {
+            ROS_FATAL_STREAM_NAMED("template", "A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                    << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+            return;
+        }
+        if (Swarm::Instance() == nullptr) {
+            gzerr << "region_partition needs a swarm_controller loaded before it.\n";
+            return;
+        }
+
+        sdf::ElementPtr regionSDF = _sdf->HasElement("region") ? _sdf->GetElement("region") : sdf::ElementPtr();
+        while (regionSDF) {
+            Region region;
+            region.min = regionSDF->Get<ignition::math::Vector2d>("min");
+            region.max = regionSDF->Get<ignition::math::Vector2d>("max");
+            if (region.min.X() >= region.max.X() || region.min.Y() >= region.max.Y()) {
+                gzerr << "region_partition region " << regions_.size() << " needs min below max.\n";
+                return;
+            }
+            regions_.push_back(region);
+            regionSDF = regionSDF->GetNextElement("region");
+        }
+
+        int self = _sdf->HasElement("self") ? _sdf->Get<int>("self") : 0;
+        // the same world serves every server, each one names its region by parameter
+        ros::NodeHandle("~").getParam("region", self);
+        if (regions_.size() < 2 || self < 0 || self >= static_cast<int>(regions_.size())) {
+            gzerr << "region_partition needs two regions or more and self one of them, it has "
+                  << regions_.size() << " and " << self << ".\n";
+            return;
+        }
+        self_ = self;
+
+        Util::GetSdfParam(_sdf, "margin", margin_, margin_);
+        double rate;
+        Util::GetSdfParam(_sdf, "checkRate", rate, 10);
+        checkPeriod_ = rate > 0 ? 1.0 / rate : 0.0;
+        Util::GetSdfParam(_sdf, "handoffTimeout", handoffTimeout_, handoffTimeout_);
+        std::string topic = "/region_handoff";
+        if (_sdf->HasElement("handoffTopic")) {
+            topic = _sdf->Get<std::string>("handoffTopic");
+        }
+
+        this->node_ = transport::NodePtr(new transport::Node());
+        this->node_->Init(this->world_->Name());
+
+        this->rosnode_ = new ros::NodeHandle();
+        handoffPubs_.resize(regions_.size());
+        for (unsigned i = 0; i < regions_.size(); ++i) {
+            if (i != self_) {
+                handoffPubs_[i] = this->rosnode_->advertise<suruiha_gazebo_plugins::VehicleHandoff>(
+                        topic + "/" + std::to_string(i), 10);
+            }
+        }
+        this->handoffSub_ = this->rosnode_->subscribe(topic + "/" + std::to_string(self_), 100,
+                &RegionPartition::HandoffCallback, this);
+
+        gzmsg << "region_partition: region " << self_ << " of " << regions_.size() << ", x "
+              << regions_[self_].min.X() << " to " << regions_[self_].max.X() << ", y "
+              << regions_[self_].min.Y() << " to " << regions_[self_].max.Y() << "\n";
+
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&RegionPartition::UpdateStates, this));
+    }
+
+    unsigned RegionPartition::Owner(const ignition::math::Vector3d &_position) const {
+        unsigned nearest = 0;
+        double nearestDistance = std::numeric_limits<double>::infinity();
+        for (unsigned i = 0; i < regions_.size(); ++i) {
+            const double distance = Distance(i, _position);
+            if (distance == 0) {
+                return i;
+            }
+            if (distance < nearestDistance) {
+                nearest = i;
+                nearestDistance = distance;
+            }
+        }
+        return nearest;
+    }
+
+    double RegionPartition::Distance(unsigned _region, const ignition::math::Vector3d &_position) const {
+        const Region &region = regions_[_region];
+        const double dx = std::max(0.0, std::max(region.min.X() - _position.X(), _position.X() - region.max.X()));
+        const double dy = std::max(0.0, std::max(region.min.Y() - _position.Y(), _position.Y() - region.max.Y()));
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    void RegionPartition::UpdateStates() {
+        ReceiveArrivals();
+
+        const common::Time now = this->world_->SimTime();
+        if (started_ && now - lastCheck_ < checkPeriod_) {
+            return;
+        }
+        lastCheck_ = now;
+        CheckVehicles();
+        started_ = true;
+    }
+
+    void RegionPartition::CheckVehicles() {
+        Swarm* swarm = Swarm::Instance();
+        if (swarm == nullptr) {
+            return;
+        }
+        std::vector<std::string> names;
+        std::vector<ignition::math::Vector3d> positions;
+        swarm->Positions(names, positions);
+
+        unsigned dropped = 0;
+        for (unsigned i = 0; i < names.size(); ++i) {
+            const unsigned owner = Owner(positions[i]);
+            if (owner == self_) {
+                continue;
+            }
+            if (!started_) {
+                // loaded from the world file by every server, flown by its owner only
+                RemoveModel(swarm->Release(names[i]));
+                dropped++;
+            } else if (Distance(self_, positions[i]) > margin_) {
+                HandOff(names[i], owner);
+            }
+        }
+        if (dropped > 0) {
+            gzmsg << "region_partition: " << dropped << " vehicles of other regions removed\n";
+        }
+    }
+
+    void RegionPartition::HandOff(const std::string &_name, unsigned _region) {
+        ros::Publisher &pub = handoffPubs_[_region];
+        if (pub.getNumSubscribers() == 0) {
+            if (waiting_.insert(_name).second) {
+                gzwarn << "region_partition: [" << _name << "] is in region " << _region
+                       << ", nobody listens on " << pub.getTopic() << ", it stays here.\n";
+            }
+            return;
+        }
+        waiting_.erase(_name);
+
+        suruiha_gazebo_plugins::VehicleHandoffPtr msg(new suruiha_gazebo_plugins::VehicleHandoff());
+        physics::ModelPtr model = Swarm::Instance()->Export(_name, *msg);
+        if (!model) {
+            return;
+        }
+        physics::ModelPtr top = this->world_->ModelByName(TopModelName(model));
+        if (!top) {
+            gzerr << "region_partition: no top level model of [" << _name << "], it is lost.\n";
+            return;
+        }
+
+        // spawned again where it is now, its plugins included
+        sdf::ElementPtr modelSDF = top->GetSDF()->Clone();
+        modelSDF->GetElement("pose")->Set(top->WorldPose());
+        msg->model_sdf = std::string("<sdf version='") + SDF_VERSION + "'>" + modelSDF->ToString("") + "</sdf>";
+        msg->from_region = self_;
+        msg->to_region = _region;
+        const common::Time now = this->world_->SimTime();
+        msg->header.stamp.sec = now.sec;
+        msg->header.stamp.nsec = now.nsec;
+        pub.publish(msg);
+
+        RemoveModel(model);
+        gzmsg << "region_partition: [" << _name << "] handed to region " << _region << "\n";
+    }
+
+    void RegionPartition::RemoveModel(physics::ModelPtr _model) {
+        if (_model) {
+            transport::requestNoReply(this->node_, "entity_delete", TopModelName(_model));
+        }
+    }
+
+    void RegionPartition::ReceiveArrivals() {
+        std::vector<suruiha_gazebo_plugins::VehicleHandoffConstPtr> received;
+        {
+            boost::mutex::scoped_lock lock(this->receiveMutex_);
+            received.swap(received_);
+        }
+        for (unsigned i = 0; i < received.size(); ++i) {
+            Spawn(received[i]);
+        }
+
+        // the models come in the next factory pass, their plugins register with the swarm
+        Swarm* swarm = Swarm::Instance();
+        for (std::vector<Arrival>::iterator it = arrivals_.begin(); it != arrivals_.end();) {
+            const suruiha_gazebo_plugins::VehicleHandoff &msg = *it->msg;
+            if (swarm->Import(msg)) {
+                gzmsg << "region_partition: [" << msg.name << "] arrived from region " << msg.from_region << "\n";
+                it = arrivals_.erase(it);
+            } else if ((common::Time::GetWallTime() - it->start).Double() > handoffTimeout_) {
+                gzerr << "region_partition: [" << msg.name << "] from region " << msg.from_region
+                      << " not loaded after " << handoffTimeout_ << " s, it is lost.\n";
+                swarm->CancelHandoff(msg.name);
+                it = arrivals_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void RegionPartition::Spawn(const suruiha_gazebo_plugins::VehicleHandoffConstPtr &_msg) {
+        sdf::SDFPtr modelSDF(new sdf::SDF());
+        sdf::init(modelSDF);
+        if (!sdf::readString(_msg->model_sdf, modelSDF) || !modelSDF->Root()->HasElement("model")) {
+            gzerr << "region_partition: cannot read the model of [" << _msg->name << "], it is lost.\n";
+            return;
+        }
+        const std::string top = modelSDF->Root()->GetElement("model")->GetAttribute("name")->GetAsString();
+        if (this->world_->ModelByName(top)) {
+            gzerr << "region_partition: [" << _msg->name << "] from region " << _msg->from_region
+                  << " is already in this world, not spawned.\n";
+            return;
+        }
+
+        Arrival arrival;
+        arrival.msg = _msg;
+        arrival.start = common::Time::GetWallTime();
+        arrivals_.push_back(arrival);
+        Swarm::Instance()->ExpectHandoff(_msg->name);
+        this->world_->InsertModelSDF(*modelSDF);
+    }
+
+    void RegionPartition::HandoffCallback(const suruiha_gazebo_plugins::VehicleHandoffConstPtr &_msg) {
+        boost::mutex::scoped_lock lock(this->receiveMutex_);
+        received_.push_back(_msg);
+    }
+}
@@ -0,0 +1,242 @@
+/*
+ * rotor_bank.cpp
+ */
+
+#include <suruiha_gazebo_plugins/rotor_bank.h>
+#include <cmath>
+
+namespace gazebo {
+
+template <typename T>
+static void EraseRange(std::vector<T> &_v, unsigned _first, unsigned _count) {
+    _v.erase(_v.begin() + _first, _v.begin() + _first + _count);
+}
+
+/// \brief coefficients of the velocity filter of a rotor, see RotorBank
+static void FilterCoefficients(const RotorControl &_rotor, double _b[3], double _a[3]) {
+    _b[0] = 1.0;
+    _b[1] = _b[2] = _a[1] = _a[2] = 0.0;
+    if (_rotor.filterOrder == 1) {
+        // same as ignition::math::OnePole
+        const double pole = std::exp(-2.0 * M_PI * _rotor.frequencyCutoff / _rotor.samplingRate);
+        _b[0] = 1.0 - pole;
+        _a[1] = -pole;
+    } else if (_rotor.filterOrder == 2) {
+        // butterworth low pass, bilinear transform
+        const double k = std::tan(M_PI * _rotor.frequencyCutoff / _rotor.samplingRate);
+        const double q = M_SQRT1_2;
+        const double norm = 1.0 / (k * k + k / q + 1.0);
+        _b[0] = k * k * norm;
+        _b[1] = 2.0 * _b[0];
+        _b[2] = _b[0];
+        _a[1] = 2.0 * (k * k - 1.0) * norm;
+        _a[2] = (k * k - k / q + 1.0) * norm;
+    }
+}
+
+int RotorBank::AddVehicle() {
+    int vehicle;
+    if (!freeVehicles_.empty()) {
+        vehicle = freeVehicles_.back();
+        freeVehicles_.pop_back();
+    } else {
+        vehicle = first_.size();
+        first_.push_back(0);
+        count_.push_back(0);
+    }
+    first_[vehicle] = cmd.size();
+    count_[vehicle] = 0;
+    return vehicle;
+}
+
+void RotorBank::AddRotor(int _vehicle, const RotorControl &_rotor) {
+    if (first_[_vehicle] + count_[_vehicle] != cmd.size()) {
+        gzerr << "rotors of a vehicle must be added one after another, rotor for joint ["
+              << _rotor.jointName << "] ignored.\n";
+        return;
+    }
+
+    throttle.push_back(0.0);
+    pitch.push_back(0.0);
+    roll.push_back(0.0);
+    yaw.push_back(0.0);
+
+    trim.push_back(_rotor.trim);
+    mixPitch.push_back(_rotor.mixPitch);
+    mixRoll.push_back(_rotor.mixRoll);
+    mixYaw.push_back(_rotor.mixYaw);
+
+    velocityScale.push_back(_rotor.multiplier / _rotor.rotorVelocitySlowdownSim);
+
+    cmd.push_back(0.0);
+    velTarget.push_back(0.0);
+
+    dt.push_back(0.0);
+    velocity.push_back(0.0);
+
+    double b[3], a[3];
+    FilterCoefficients(_rotor, b, a);
+    filterB0.push_back(b[0]);
+    filterB1.push_back(b[1]);
+    filterB2.push_back(b[2]);
+    filterA1.push_back(a[1]);
+    filterA2.push_back(a[2]);
+    velocityX1.push_back(0.0);
+    velocityX2.push_back(0.0);
+    filteredY1.push_back(0.0);
+    filteredY2.push_back(0.0);
+
+    error.push_back(0.0);
+    force.push_back(0.0);
+
+    pid.Add(_rotor.pid);
+    joints.push_back(_rotor.joint);
+
+    count_[_vehicle]++;
+}
+
+void RotorBank::RemoveVehicle(int _vehicle) {
+    const unsigned first = first_[_vehicle];
+    const unsigned count = count_[_vehicle];
+
+    EraseRange(throttle, first, count);
+    EraseRange(pitch, first, count);
+    EraseRange(roll, first, count);
+    EraseRange(yaw, first, count);
+    EraseRange(trim, first, count);
+    EraseRange(mixPitch, first, count);
+    EraseRange(mixRoll, first, count);
+    EraseRange(mixYaw, first, count);
+    EraseRange(velocityScale, first, count);
+    EraseRange(cmd, first, count);
+    EraseRange(velTarget, first, count);
+    EraseRange(dt, first, count);
+    EraseRange(velocity, first, count);
+    EraseRange(filterB0, first, count);
+    EraseRange(filterB1, first, count);
+    EraseRange(filterB2, first, count);
+    EraseRange(filterA1, first, count);
+    EraseRange(filterA2, first, count);
+    EraseRange(velocityX1, first, count);
+    EraseRange(velocityX2, first, count);
+    EraseRange(filteredY1, first, count);
+    EraseRange(filteredY2, first, count);
+    EraseRange(error, first, count);
+    EraseRange(force, first, count);
+    pid.Erase(first, count);
+    EraseRange(joints, first, count);
+
+    for (unsigned i = 0; i < first_.size(); ++i) {
+        if (first_[i] > first) {
+            first_[i] -= count;
+        }
+    }
+    first_[_vehicle] = 0;
+    count_[_vehicle] = 0;
+    freeVehicles_.push_back(_vehicle);
+}
+
+void RotorBank::SetInputs(int _vehicle, double _throttle, double _pitch, double _roll, double _yaw) {
+    const unsigned end = first_[_vehicle] + count_[_vehicle];
+    for (unsigned i = first_[_vehicle]; i < end; ++i) {
+        throttle[i] = _throttle;
+        pitch[i] = _pitch;
+        roll[i] = _roll;
+        yaw[i] = _yaw;
+    }
+}
+
+void RotorBank::SetFeedback(int _vehicle, common::Time _dt, const std::vector<double> &_velocities) {
+    const unsigned first = first_[_vehicle];
+    const unsigned end = first + count_[_vehicle];
+    const double step = _dt.Double();
+    for (unsigned i = first; i < end; ++i) {
+        dt[i] = step;
+        velocity[i] = _velocities[i - first];
+    }
+}
+
+void RotorBank::Idle(int _vehicle) {
+    const unsigned end = first_[_vehicle] + count_[_vehicle];
+    for (unsigned i = first_[_vehicle]; i < end; ++i) {
+        dt[i] = 0.0;
+    }
+}
+
+void RotorBank::Mix() {
+    const unsigned n = cmd.size();
+    const double* __restrict t = throttle.data();
+    const double* __restrict p = pitch.data();
+    const double* __restrict r = roll.data();
+    const double* __restrict y = yaw.data();
+    const double* __restrict k = trim.data();
+    const double* __restrict mp = mixPitch.data();
+    const double* __restrict mr = mixRoll.data();
+    const double* __restrict my = mixYaw.data();
+    const double* __restrict vs = velocityScale.data();
+    const double* __restrict v = velocity.data();
+    const double* __restrict h = dt.data();
+    const double* __restrict b0 = filterB0.data();
+    const double* __restrict b1 = filterB1.data();
+    const double* __restrict b2 = filterB2.data();
+    const double* __restrict a1 = filterA1.data();
+    const double* __restrict a2 = filterA2.data();
+    double* __restrict x1 = velocityX1.data();
+    double* __restrict x2 = velocityX2.data();
+    double* __restrict y1 = filteredY1.data();
+    double* __restrict y2 = filteredY2.data();
+    double* __restrict c = cmd.data();
+    double* __restrict vt = velTarget.data();
+    double* __restrict e = error.data();
+
+    // no branches and no aliasing so the compiler is free to vectorize
+    for (unsigned i = 0; i < n; ++i) {
+        // a product of the axes as CalculateRotors had it, the yaw error is
+        // not normalized so it must not be summed with the other two
+        c[i] = k[i] * t[i] * (1.0 + mp[i] * p[i]) * (1.0 + mr[i] * r[i]) * (1.0 + my[i] * y[i]);
+        vt[i] = vs[i] * c[i];
+
+        const double filtered = b0[i] * v[i] + b1[i] * x1[i] + b2[i] * x2[i]
+                - a1[i] * y1[i] - a2[i] * y2[i];
+        e[i] = filtered - vt[i];
+
+        // the filters of idle vehicles keep their history
+        const bool active = h[i] != 0.0;
+        x2[i] = active ? x1[i] : x2[i];
+        x1[i] = active ? v[i] : x1[i];
+        y2[i] = active ? y1[i] : y2[i];
+        y1[i] = active ? filtered : y1[i];
+    }
+
+    // idle vehicles have a zero step, their PIDs are left as they are
+    pid.Update(e, dt.data(), force.data());
+}
+
+void RotorBank::Apply(int _vehicle) {
+    const unsigned end = first_[_vehicle] + count_[_vehicle];
+    for (unsigned i = first_[_vehicle]; i < end; ++i) {
+        joints[i]->SetForce(0, force[i]);
+    }
+}
+
+void RotorBank::Hold(int _vehicle) {
+    // the last command of a PID is left as is by idle steps
+    const unsigned end = first_[_vehicle] + count_[_vehicle];
+    for (unsigned i = first_[_vehicle]; i < end; ++i) {
+        joints[i]->SetForce(0, pid.cmd[i]);
+    }
+}
+
+unsigned RotorBank::RotorCount() const {
+    return cmd.size();
+}
+
+unsigned RotorBank::RotorCount(int _vehicle) const {
+    return count_[_vehicle];
+}
+
+unsigned RotorBank::FirstRotor(int _vehicle) const {
+    return first_[_vehicle];
+}
+
+}
@@ -10,7 +10,6 @@
 using namespace gazebo;
 
 RotorControl::RotorControl() {
-    // most of these coefficients are not used yet.
     this->rotorVelocitySlowdownSim = 10;
     this->frequencyCutoff = 5.0;
     this->samplingRate = 0.2;
@@ -0,0 +1,146 @@
+/*
+ * scenery_tiles.cpp
+ */
+
+#include <suruiha_gazebo_plugins/scenery_tiles.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/msgs/msgs.hh>
+#include <boost/bind.hpp>
+#include <sdf/sdf.hh>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_WORLD_PLUGIN(SceneryTiles);
+
+    SceneryTiles::SceneryTiles() : load_radius_(150.0), unload_radius_(200.0),
+            update_period_(1.0), updated_(false) {
+    }
+
+    SceneryTiles::~SceneryTiles() {
+        this->update_connection_.reset();
+        if (node_) {
+            node_->Fini();
+        }
+    }
+
+    void SceneryTiles::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
+        this->world_ = _world;
+
+        Util::GetSdfParam(_sdf, "loadRadius", load_radius_, 150.0);
+        Util::GetSdfParam(_sdf, "unloadRadius", unload_radius_, load_radius_ + 50.0);
+        if (unload_radius_ < load_radius_) {
+            gzwarn << "unloadRadius [" << unload_radius_ << "] is below loadRadius ["
+                   << load_radius_ << "], tiles unload at loadRadius\n";
+            unload_radius_ = load_radius_;
+        }
+        double period;
+        Util::GetSdfParam(_sdf, "updatePeriod", period, 1.0);
+        update_period_ = common::Time(period);
+
+        if (_sdf->HasElement("trackModels")) {
+            std::istringstream names(_sdf->Get<std::string>("trackModels"));
+            std::string name;
+            while (names >> name) {
+                track_.push_back(name);
+            }
+        }
+
+        if (_sdf->HasElement("tile")) {
+            for (sdf::ElementPtr tile = _sdf->GetElement("tile"); tile; tile = tile->GetNextElement("tile")) {
+                LoadTile(tile);
+            }
+        }
+        if (tiles_.empty()) {
+            gzwarn << "SceneryTiles has no tiles\n";
+            return;
+        }
+        gzmsg << "SceneryTiles: " << tiles_.size() << " tiles, loaded within "
+              << load_radius_ << " m of a vehicle\n";
+
+        node_ = transport::NodePtr(new transport::Node());
+        node_->Init(world_->Name());
+        request_pub_ = node_->Advertise<msgs::Request>("~/request");
+
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&SceneryTiles::Update, this));
+    }
+
+    bool SceneryTiles::LoadTile(sdf::ElementPtr _tile) {
+        if (!_tile->HasElement("model") || !_tile->HasElement("center")) {
+            gzerr << "Tile without <model> or <center> is skipped\n";
+            return false;
+        }
+        sdf::ElementPtr model = _tile->GetElement("model");
+
+        Tile tile;
+        tile.name = model->GetAttribute("name")->GetAsString();
+        tile.center = _tile->Get<ignition::math::Vector2d>("center");
+        tile.size = _tile->HasElement("size") ? _tile->Get<double>("size") : 0.0;
+        tile.sdf = "<sdf version='" SDF_VERSION "'>" + model->ToString("") + "</sdf>";
+        tile.loaded = false;
+        tiles_.push_back(tile);
+        return true;
+    }
+
+    bool SceneryTiles::Tracked(const physics::ModelPtr &_model) const {
+        if (track_.empty()) {
+            return !_model->IsStatic();
+        }
+        const std::string name = _model->GetName();
+        for (unsigned i = 0; i < track_.size(); ++i) {
+            if (name.compare(0, track_[i].size(), track_[i]) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    double SceneryTiles::Distance(const Tile &_tile, const ignition::math::Vector3d &_pos) {
+        const double half = 0.5 * _tile.size;
+        const double dx = std::max(std::fabs(_pos.X() - _tile.center.X()) - half, 0.0);
+        const double dy = std::max(std::fabs(_pos.Y() - _tile.center.Y()) - half, 0.0);
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    void SceneryTiles::Update() {
+        const common::Time now = world_->SimTime();
+        // a reset moves the time back, check again right away
+        if (updated_ && now >= last_update_ && now - last_update_ < update_period_) {
+            return;
+        }
+        updated_ = true;
+        last_update_ = now;
+
+        positions_.clear();
+        const physics::Model_V models = world_->Models();
+        for (unsigned i = 0; i < models.size(); ++i) {
+            if (Tracked(models[i])) {
+                positions_.push_back(models[i]->WorldPose().Pos());
+            }
+        }
+
+        for (unsigned t = 0; t < tiles_.size(); ++t) {
+            Tile &tile = tiles_[t];
+            double nearest = std::numeric_limits<double>::infinity();
+            for (unsigned i = 0; i < positions_.size(); ++i) {
+                nearest = std::min(nearest, Distance(tile, positions_[i]));
+            }
+
+            if (!tile.loaded && nearest <= load_radius_) {
+                world_->InsertModelString(tile.sdf);
+                tile.loaded = true;
+            } else if (tile.loaded && nearest > unload_radius_) {
+                // removed by the world between two steps, not inside this update
+                msgs::Request* request = msgs::CreateRequest("entity_delete", tile.name);
+                request_pub_->Publish(*request);
+                delete request;
+                tile.loaded = false;
+            }
+        }
+    }
+}
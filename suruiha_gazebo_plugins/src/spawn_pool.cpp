@@ -0,0 +1,262 @@
+/*
+ * spawn_pool.cpp
+ */
+
+#include <suruiha_gazebo_plugins/spawn_pool.h>
+#include <suruiha_gazebo_plugins/swarm.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/common/CommonIface.hh>
+#include <gazebo/common/ModelDatabase.hh>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_WORLD_PLUGIN(SpawnPool);
+
+    SpawnPool::SpawnPool() : rosnode_(nullptr), inserted_(0), present_(0), spawnPerStep_(0),
+            activatePerStep_(0), autoActivate_(true), spawnTimeout_(120), deferred_(false), phase_(SPAWN) {
+    }
+
+    SpawnPool::~SpawnPool() {
+        this->update_connection_.reset();
+        this->activateSub_.shutdown();
+        if (this->rosnode_ != nullptr) {
+            this->rosnode_->shutdown();
+            delete this->rosnode_;
+        }
+    }
+
+    void SpawnPool::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
+        this->world_ = _world;
+        loadStart_ = common::Time::GetWallTime();
+
+        sdf::ElementPtr templateSDF = _sdf->HasElement("template") ? _sdf->GetElement("template") : sdf::ElementPtr();
+        while (templateSDF) {
+            if (!templateSDF->HasAttribute("name")) {
+                gzerr << "spawn_pool template without a name attribute.\n";
+                return;
+            }
+            if (!LoadTemplate(templateSDF->GetAttribute("name")->GetAsString(), templateSDF->Get<std::string>())) {
+                return;
+            }
+            templateSDF = templateSDF->GetNextElement("template");
+        }
+
+        sdf::ElementPtr spawnSDF = _sdf->HasElement("spawn") ? _sdf->GetElement("spawn") : sdf::ElementPtr();
+        while (spawnSDF) {
+            if (!LoadSpawn(spawnSDF)) {
+                return;
+            }
+            spawnSDF = spawnSDF->GetNextElement("spawn");
+        }
+        if (instances_.empty()) {
+            gzerr << "spawn_pool has nothing to spawn.\n";
+            return;
+        }
+
+        double value;
+        Util::GetSdfParam(_sdf, "spawnPerStep", value, 0);
+        spawnPerStep_ = static_cast<unsigned>(std::max(value, 0.0));
+        Util::GetSdfParam(_sdf, "activatePerStep", value, 0);
+        activatePerStep_ = static_cast<unsigned>(std::max(value, 0.0));
+        Util::GetSdfParam(_sdf, "spawnTimeout", spawnTimeout_, spawnTimeout_);
+        if (_sdf->HasElement("autoActivate")) {
+            autoActivate_ = _sdf->Get<bool>("autoActivate");
+        }
+        Report("templates", loadStart_, templates_.size());
+
+        if (!autoActivate_) {
+            // Make sure the ROS node for Gazebo has already been initalized
+            if (!ros::isInitialized()) {
+                ROS_FATAL_STREAM_NAMED("template", "A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                        << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+                return;
+            }
+            std::string topic = "spawn_pool/activate";
+            if (_sdf->HasElement("activateTopic")) {
+                topic = _sdf->Get<std::string>("activateTopic");
+            }
+            this->rosnode_ = new ros::NodeHandle();
+            this->activateSub_ = this->rosnode_->subscribe(topic, 100, &SpawnPool::ActivateCallback, this);
+        }
+
+        // the models of the world file load their plugins before the first
+        // step, only the instances of the pool are parked
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&SpawnPool::UpdateStates, this));
+    }
+
+    bool SpawnPool::LoadTemplate(const std::string &_name, const std::string &_uri) {
+        const std::string file = _uri.find("model://") == 0 ?
+                common::ModelDatabase::Instance()->GetModelFile(_uri) : common::find_file(_uri);
+        if (file.empty()) {
+            gzerr << "spawn_pool cannot find template [" << _name << "] " << _uri << ".\n";
+            return false;
+        }
+
+        Template model;
+        model.name = _name;
+        model.sdf.reset(new sdf::SDF());
+        sdf::init(model.sdf);
+        if (!sdf::readFile(file, model.sdf) || !model.sdf->Root()->HasElement("model")) {
+            gzerr << "spawn_pool cannot read a model from [" << file << "].\n";
+            return false;
+        }
+        model.model = model.sdf->Root()->GetElement("model");
+        gzmsg << "spawn_pool: template [" << _name << "] " << file << "\n";
+        templates_.push_back(model);
+        return true;
+    }
+
+    bool SpawnPool::LoadSpawn(sdf::ElementPtr _sdf) {
+        const std::string templateName = _sdf->HasElement("template") ? _sdf->Get<std::string>("template") : "";
+        unsigned templateIndex = 0;
+        while (templateIndex < templates_.size() && templates_[templateIndex].name != templateName) {
+            templateIndex++;
+        }
+        if (templateIndex == templates_.size()) {
+            gzerr << "spawn_pool spawn of unknown template [" << templateName << "].\n";
+            return false;
+        }
+
+        const int count = _sdf->HasElement("count") ? _sdf->Get<int>("count") : 1;
+        const int first = _sdf->HasElement("first") ? _sdf->Get<int>("first") : 0;
+        const std::string prefix = _sdf->HasElement("prefix") ? _sdf->Get<std::string>("prefix") : templateName;
+        const ignition::math::Vector3d origin = _sdf->HasElement("origin") ?
+                _sdf->Get<ignition::math::Vector3d>("origin") : ignition::math::Vector3d::Zero;
+        double spacing;
+        Util::GetSdfParam(_sdf, "spacing", spacing, 3);
+        int columns = _sdf->HasElement("columns") ? _sdf->Get<int>("columns") :
+                static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+        columns = std::max(columns, 1);
+
+        for (int i = 0; i < count; ++i) {
+            Instance instance;
+            instance.templateIndex = templateIndex;
+            instance.name = prefix + std::to_string(first + i);
+            instance.pose = ignition::math::Pose3d(origin.X() + (i % columns) * spacing,
+                    origin.Y() + (i / columns) * spacing, origin.Z(), 0, 0, 0);
+            if (this->world_->ModelByName(instance.name)) {
+                gzerr << "spawn_pool: model [" << instance.name << "] is already in the world, not spawned.\n";
+                continue;
+            }
+            instances_.push_back(instance);
+        }
+        return true;
+    }
+
+    void SpawnPool::UpdateStates() {
+        switch (phase_) {
+        case SPAWN: {
+            if (inserted_ == 0) {
+                spawnStart_ = common::Time::GetWallTime();
+                Swarm* swarm = Swarm::Instance();
+                deferred_ = swarm != nullptr;
+                if (deferred_) {
+                    swarm->DeferActivation(true);
+                } else {
+                    gzwarn << "spawn_pool: no swarm_controller, every controller advertises as it loads.\n";
+                }
+            }
+            // the world reads every instance queued here in its next factory pass
+            const unsigned end = spawnPerStep_ == 0 ? instances_.size() :
+                    std::min<unsigned>(instances_.size(), inserted_ + spawnPerStep_);
+            for (; inserted_ < end; ++inserted_) {
+                const Instance &instance = instances_[inserted_];
+                Template &model = templates_[instance.templateIndex];
+                model.model->GetAttribute("name")->Set(instance.name);
+                model.model->GetElement("pose")->Set(instance.pose);
+                this->world_->InsertModelSDF(*model.sdf);
+            }
+            if (inserted_ == instances_.size()) {
+                phase_ = WAIT;
+            }
+            break;
+        }
+        case WAIT:
+            if (!Spawned()) {
+                break;
+            }
+            Report("spawn", spawnStart_, present_);
+            templates_.clear();
+            activateStart_ = common::Time::GetWallTime();
+            if (deferred_ && Swarm::Instance() != nullptr) {
+                // vehicles spawned later are no longer parked, the pool's stay until activated
+                Swarm::Instance()->DeferActivation(false);
+            }
+            phase_ = ACTIVATE;
+            break;
+        case ACTIVATE:
+            Activate();
+            break;
+        case DONE:
+            break;
+        }
+    }
+
+    bool SpawnPool::Spawned() {
+        while (present_ < instances_.size() && this->world_->ModelByName(instances_[present_].name)) {
+            present_++;
+        }
+        if (present_ == instances_.size()) {
+            return true;
+        }
+        if ((common::Time::GetWallTime() - spawnStart_).Double() > spawnTimeout_) {
+            gzerr << "spawn_pool: " << present_ << " of " << instances_.size() << " instances loaded after "
+                  << spawnTimeout_ << " s, [" << instances_[present_].name << "] is missing.\n";
+            return true;
+        }
+        return false;
+    }
+
+    void SpawnPool::Activate() {
+        Swarm* swarm = Swarm::Instance();
+        if (!deferred_ || swarm == nullptr) {
+            Report("bring-up", loadStart_, present_);
+            phase_ = DONE;
+            return;
+        }
+
+        if (autoActivate_) {
+            swarm->Activate(activatePerStep_);
+        } else {
+            std::vector<std::string> names;
+            {
+                boost::mutex::scoped_lock lock(this->activateMutex_);
+                names.swap(activateNames_);
+            }
+            for (unsigned i = 0; i < names.size(); ++i) {
+                if (names[i] == "all") {
+                    swarm->Activate(0);
+                } else if (!swarm->Activate(names[i])) {
+                    gzwarn << "spawn_pool: no parked vehicle [" << names[i] << "].\n";
+                }
+            }
+        }
+
+        if (swarm->ParkedCount() == 0) {
+            Report("activation", activateStart_, present_);
+            Report("bring-up", loadStart_, present_);
+            phase_ = DONE;
+        }
+    }
+
+    void SpawnPool::ActivateCallback(const std_msgs::String::ConstPtr &_name) {
+        boost::mutex::scoped_lock lock(this->activateMutex_);
+        activateNames_.push_back(_name->data);
+    }
+
+    void SpawnPool::Report(const std::string &_phase, common::Time _start, unsigned _count) {
+        const double seconds = (common::Time::GetWallTime() - _start).Double();
+        std::ostringstream line;
+        line << "spawn_pool: " << _phase << " of " << _count << " in " << seconds << " s";
+        if (_count > 0) {
+            line << ", " << seconds * 1000 / _count << " ms each";
+        }
+        gzmsg << line.str() << "\n";
+    }
+}
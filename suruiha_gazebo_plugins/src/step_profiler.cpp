@@ -0,0 +1,83 @@
+/*
+ * step_profiler.cpp
+ */
+
+#include <suruiha_gazebo_plugins/step_profiler.h>
+
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/common/Console.hh>
+
+namespace gazebo {
+
+    uint64_t StepHistogram::Quantile(double _q) const {
+        uint64_t rank = static_cast<uint64_t>(_q * count);
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                return i == 0 ? 0 : (uint64_t(1) << i);
+            }
+        }
+        return max;
+    }
+
+    void StepHistogram::Reset() {
+        for (unsigned i = 0; i < BUCKETS; ++i) {
+            buckets[i] = 0;
+        }
+        count = 0;
+        sum = 0;
+        max = 0;
+    }
+
+    StepProfiler::StepProfiler() {
+        interval = 10;
+        lastReportTime = 0;
+    }
+
+    void StepProfiler::Load(sdf::ElementPtr _sdf) {
+        double seconds;
+        Util::GetSdfParam(_sdf, "profileInterval", seconds, interval.Double());
+        interval = seconds;
+    }
+
+    const char* StepProfiler::SectionName(Section _section) {
+        switch (_section) {
+            case STEP: return "step";
+            case DISPATCH: return "dispatch";
+            case LOCK_WAIT: return "lock wait";
+            case STATE: return "state";
+            case MIXER: return "mixer";
+            case PID: return "pid";
+            case PUBLISH: return "publish";
+            case RECORD: return "record";
+            default: return "unknown";
+        }
+    }
+
+    void StepProfiler::Report(const std::string &_name, const common::Time &_time) {
+        if (interval.Double() <= 0.0 || _time - lastReportTime < interval) {
+            return;
+        }
+        lastReportTime = _time;
+
+        gzdbg << _name << " step profile, ns (p50 and p99 are bucket upper bounds):\n";
+        for (unsigned i = 0; i < SECTION_COUNT; ++i) {
+            StepHistogram &h = histograms[i];
+            if (h.count == 0) {
+                continue;
+            }
+            gzdbg << "  " << SectionName(static_cast<Section>(i))
+                  << " count:" << h.count
+                  << " mean:" << h.sum / h.count
+                  << " p50:<" << h.Quantile(0.5)
+                  << " p99:<" << h.Quantile(0.99)
+                  << " max:" << h.max << "\n";
+            h.Reset();
+        }
+    }
+}
+
+#endif
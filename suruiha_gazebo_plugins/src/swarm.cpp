@@ -0,0 +1,567 @@
+/*
+ * swarm.cpp
+ */
+
+#include <suruiha_gazebo_plugins/swarm.h>
+#include <geometry_msgs/Pose.h>
+#include <algorithm>
+
+namespace gazebo {
+
+    Swarm* Swarm::instance_ = nullptr;
+
+    Swarm::Swarm(physics::WorldPtr _world, const std::string &_robotNamespace,
+            CallbackDispatcher::Mode _dispatchMode, bool _lockstep) {
+        this->world_ = _world;
+        this->lockstep_ = _lockstep;
+        this->rosnode_ = new ros::NodeHandle(_robotNamespace);
+        this->statesLayoutChanged_ = true;
+        this->statesUpdateRate_ = 0;
+        this->lastStatesPublishTime_ = 0;
+        this->spreadIndex_ = 0;
+        this->deferActivation_ = false;
+
+        // one queue serves the control topics of every vehicle
+        this->dispatcher_.Start(this->rosnode_, _dispatchMode);
+
+        if (instance_ != nullptr) {
+            gzerr << "more than one swarm controller loaded, the last one is used\n";
+        }
+        instance_ = this;
+    }
+
+    Swarm::~Swarm() {
+        if (instance_ == this) {
+            instance_ = nullptr;
+        }
+        this->statesPub_.shutdown();
+        this->rosnode_->shutdown();
+        this->dispatcher_.Stop();
+
+        for (unsigned i = 0; i < irisVehicles_.size(); i++) {
+            irisVehicles_[i].Unload();
+        }
+        irisVehicles_.clear();
+        for (unsigned i = 0; i < zephyrVehicles_.size(); i++) {
+            zephyrVehicles_[i].Unload();
+        }
+        zephyrVehicles_.clear();
+        delete this->rosnode_;
+    }
+
+    Swarm* Swarm::Instance() {
+        return instance_;
+    }
+
+    int Swarm::AddIris(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        IrisVehicle vehicle;
+        if (!vehicle.Load(_model, _sdf, &this->irisRotors_)) {
+            vehicle.Unload();
+            return -1;
+        }
+        vehicle.lockstep = vehicle.lockstep || this->lockstep_;
+        if (!CheckLockstep(vehicle.lockstep, vehicle.name)) {
+            vehicle.Unload();
+            return -1;
+        }
+
+        int slot;
+        if (!freeIrisSlots_.empty()) {
+            slot = freeIrisSlots_.back();
+            freeIrisSlots_.pop_back();
+        } else {
+            slot = irisVehicles_.size();
+            irisVehicles_.push_back(IrisVehicle());
+        }
+
+        // store the vehicle before subscribing, callbacks write to its slot
+        IrisVehicle &stored = irisVehicles_[slot];
+        stored = vehicle;
+        stored.lastUpdateTime = this->world_->SimTime();
+        SpreadControl(stored.controlClock);
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+        stored.profiler = &this->profiler_;
+#endif
+        if (recorder_.IsOpen()) {
+            stored.recorder = &this->recorder_;
+            stored.recordId = recorder_.AddVehicle(stored.name);
+        }
+
+        if (deferActivation_ || expected_.count(stored.name) > 0) {
+            parkedIris_.push_back(slot);
+        } else {
+            ConnectIris(slot);
+        }
+        statesLayoutChanged_ = true;
+        return slot;
+    }
+
+    void Swarm::RemoveIris(int _slot) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        // shutting the subscriber down waits for a running SetIrisControl
+        irisVehicles_[_slot].Unload();
+        released_.erase(irisVehicles_[_slot].name);
+        irisVehicles_[_slot] = IrisVehicle();
+        parkedIris_.erase(std::remove(parkedIris_.begin(), parkedIris_.end(), _slot), parkedIris_.end());
+        freeIrisSlots_.push_back(_slot);
+        statesLayoutChanged_ = true;
+    }
+
+    int Swarm::AddZephyr(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
+        ZephyrVehicle vehicle;
+        if (!vehicle.Load(_model, _sdf)) {
+            vehicle.Unload();
+            return -1;
+        }
+        vehicle.lockstep = vehicle.lockstep || this->lockstep_;
+        if (!CheckLockstep(vehicle.lockstep, vehicle.name)) {
+            vehicle.Unload();
+            return -1;
+        }
+
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        int slot;
+        if (!freeZephyrSlots_.empty()) {
+            slot = freeZephyrSlots_.back();
+            freeZephyrSlots_.pop_back();
+        } else {
+            slot = zephyrVehicles_.size();
+            zephyrVehicles_.push_back(ZephyrVehicle());
+        }
+
+        ZephyrVehicle &stored = zephyrVehicles_[slot];
+        stored = vehicle;
+        SpreadControl(stored.controlClock);
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+        stored.profiler = &this->profiler_;
+#endif
+        if (recorder_.IsOpen()) {
+            stored.recorder = &this->recorder_;
+            stored.recordId = recorder_.AddVehicle(stored.name);
+        }
+
+        if (deferActivation_ || expected_.count(stored.name) > 0) {
+            parkedZephyr_.push_back(slot);
+        } else {
+            ConnectZephyr(slot);
+        }
+        statesLayoutChanged_ = true;
+        return slot;
+    }
+
+    void Swarm::RemoveZephyr(int _slot) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        // shutting the subscriber down waits for a running SetZephyrControl
+        zephyrVehicles_[_slot].Unload();
+        released_.erase(zephyrVehicles_[_slot].name);
+        zephyrVehicles_[_slot] = ZephyrVehicle();
+        parkedZephyr_.erase(std::remove(parkedZephyr_.begin(), parkedZephyr_.end(), _slot), parkedZephyr_.end());
+        freeZephyrSlots_.push_back(_slot);
+        statesLayoutChanged_ = true;
+    }
+
+    void Swarm::ConnectIris(int _slot) {
+        IrisVehicle &vehicle = irisVehicles_[_slot];
+        ros::SubscribeOptions control_so;
+        if (vehicle.lockstep) {
+            control_so = ros::SubscribeOptions::create<geometry_msgs::TwistStamped>(
+                        vehicle.ControlTopic(), 100, boost::bind(
+                                &Swarm::SetIrisControlStamped, this, &vehicle, _1),
+                        ros::VoidPtr(), this->dispatcher_.Queue());
+        } else {
+            control_so = ros::SubscribeOptions::create<geometry_msgs::Twist>(
+                        vehicle.ControlTopic(), 100, boost::bind(
+                                &Swarm::SetIrisControl, this, &vehicle, _1),
+                        ros::VoidPtr(), this->dispatcher_.Queue());
+        }
+        vehicle.controlSub = this->rosnode_->subscribe(control_so);
+        vehicle.posePub = this->rosnode_->advertise<geometry_msgs::Pose>(vehicle.name + "_pose", 1);
+    }
+
+    void Swarm::ConnectZephyr(int _slot) {
+        ZephyrVehicle &vehicle = zephyrVehicles_[_slot];
+        ros::SubscribeOptions control_so;
+        if (vehicle.lockstep) {
+            control_so = ros::SubscribeOptions::create<geometry_msgs::TwistStamped>(
+                        vehicle.ControlTopic(), 100, boost::bind(
+                                &Swarm::SetZephyrControlStamped, this, &vehicle, _1),
+                        ros::VoidPtr(), this->dispatcher_.Queue());
+        } else {
+            control_so = ros::SubscribeOptions::create<geometry_msgs::Twist>(
+                        vehicle.ControlTopic(), 100, boost::bind(
+                                &Swarm::SetZephyrControl, this, &vehicle, _1),
+                        ros::VoidPtr(), this->dispatcher_.Queue());
+        }
+        vehicle.controlSub = this->rosnode_->subscribe(control_so);
+        vehicle.posePub = this->rosnode_->advertise<geometry_msgs::Pose>(vehicle.name + "_pose", 1);
+    }
+
+    void Swarm::DeferActivation(bool _defer) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        this->deferActivation_ = _defer;
+    }
+
+    unsigned Swarm::Activate(unsigned _max) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        unsigned activated = 0;
+        // vehicles handed over from another region wait for Import instead
+        for (std::deque<int>::iterator it = parkedIris_.begin();
+                it != parkedIris_.end() && (_max == 0 || activated < _max);) {
+            if (expected_.count(irisVehicles_[*it].name) > 0) {
+                ++it;
+                continue;
+            }
+            ConnectIris(*it);
+            it = parkedIris_.erase(it);
+            activated++;
+        }
+        for (std::deque<int>::iterator it = parkedZephyr_.begin();
+                it != parkedZephyr_.end() && (_max == 0 || activated < _max);) {
+            if (expected_.count(zephyrVehicles_[*it].name) > 0) {
+                ++it;
+                continue;
+            }
+            ConnectZephyr(*it);
+            it = parkedZephyr_.erase(it);
+            activated++;
+        }
+        return activated;
+    }
+
+    bool Swarm::Activate(const std::string &_name) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        for (std::deque<int>::iterator it = parkedIris_.begin(); it != parkedIris_.end(); ++it) {
+            if (irisVehicles_[*it].name == _name) {
+                ConnectIris(*it);
+                parkedIris_.erase(it);
+                return true;
+            }
+        }
+        for (std::deque<int>::iterator it = parkedZephyr_.begin(); it != parkedZephyr_.end(); ++it) {
+            if (zephyrVehicles_[*it].name == _name) {
+                ConnectZephyr(*it);
+                parkedZephyr_.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned Swarm::ParkedCount() {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        return parkedIris_.size() + parkedZephyr_.size();
+    }
+
+    void Swarm::ExpectHandoff(const std::string &_name) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        expected_.insert(_name);
+    }
+
+    void Swarm::CancelHandoff(const std::string &_name) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        expected_.erase(_name);
+    }
+
+    bool Swarm::Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        const bool iris = _msg.type == "iris";
+        std::deque<int> &parked = iris ? parkedIris_ : parkedZephyr_;
+        for (std::deque<int>::iterator it = parked.begin(); it != parked.end(); ++it) {
+            if (iris && irisVehicles_[*it].name == _msg.name) {
+                // a vehicle that cannot be restored still flies, from rest
+                irisVehicles_[*it].Import(_msg);
+                ConnectIris(*it);
+            } else if (!iris && zephyrVehicles_[*it].name == _msg.name) {
+                zephyrVehicles_[*it].Import(_msg);
+                ConnectZephyr(*it);
+            } else {
+                continue;
+            }
+            parked.erase(it);
+            expected_.erase(_msg.name);
+            return true;
+        }
+        return false;
+    }
+
+    physics::ModelPtr Swarm::Export(const std::string &_name,
+            suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        {
+            boost::mutex::scoped_lock lock(this->update_mutex_);
+            const int iris = FindIris(_name);
+            const int zephyr = iris < 0 ? FindZephyr(_name) : -1;
+            if (iris >= 0) {
+                irisVehicles_[iris].Export(_msg);
+            } else if (zephyr >= 0) {
+                zephyrVehicles_[zephyr].Export(_msg);
+            } else {
+                return physics::ModelPtr();
+            }
+        }
+        return Release(_name);
+    }
+
+    physics::ModelPtr Swarm::Release(const std::string &_name) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        physics::ModelPtr model;
+        const int iris = FindIris(_name);
+        const int zephyr = iris < 0 ? FindZephyr(_name) : -1;
+        if (iris >= 0) {
+            // shutting the subscriber down waits for a running SetIrisControl
+            IrisVehicle &vehicle = irisVehicles_[iris];
+            vehicle.controlSub.shutdown();
+            vehicle.posePub.shutdown();
+            parkedIris_.erase(std::remove(parkedIris_.begin(), parkedIris_.end(), iris), parkedIris_.end());
+            model = vehicle.model;
+        } else if (zephyr >= 0) {
+            ZephyrVehicle &vehicle = zephyrVehicles_[zephyr];
+            vehicle.controlSub.shutdown();
+            vehicle.posePub.shutdown();
+            parkedZephyr_.erase(std::remove(parkedZephyr_.begin(), parkedZephyr_.end(), zephyr), parkedZephyr_.end());
+            model = vehicle.model;
+        } else {
+            return model;
+        }
+        released_.insert(_name);
+        return model;
+    }
+
+    /// \brief position of the last step, from the model before the first one
+    static ignition::math::Vector3d StepPosition(const physics::ModelPtr &_model,
+            const VehicleState &_state, ControllerStats &_stats) {
+        if (_stats.steps > 0) {
+            return _state.pose.Pos();
+        }
+        _stats.poseReads++;
+        return _model->WorldPose().Pos();
+    }
+
+    void Swarm::Positions(std::vector<std::string> &_names,
+            std::vector<ignition::math::Vector3d> &_positions) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        _names.clear();
+        _positions.clear();
+        // the pose read in the last step, only a vehicle added since has to
+        // ask its model
+        for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+            IrisVehicle &vehicle = irisVehicles_[i];
+            if (vehicle.model && released_.count(vehicle.name) == 0 && expected_.count(vehicle.name) == 0) {
+                _names.push_back(vehicle.name);
+                _positions.push_back(StepPosition(vehicle.model, vehicle.state, vehicle.stats));
+            }
+        }
+        for (unsigned i = 0; i < zephyrVehicles_.size(); ++i) {
+            ZephyrVehicle &vehicle = zephyrVehicles_[i];
+            if (vehicle.model && released_.count(vehicle.name) == 0 && expected_.count(vehicle.name) == 0) {
+                _names.push_back(vehicle.name);
+                _positions.push_back(StepPosition(vehicle.model, vehicle.state, vehicle.stats));
+            }
+        }
+    }
+
+    int Swarm::FindIris(const std::string &_name) const {
+        for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+            if (irisVehicles_[i].model && irisVehicles_[i].name == _name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int Swarm::FindZephyr(const std::string &_name) const {
+        for (unsigned i = 0; i < zephyrVehicles_.size(); ++i) {
+            if (zephyrVehicles_[i].model && zephyrVehicles_[i].name == _name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool Swarm::CheckLockstep(bool _lockstep, const std::string &_name) {
+        if (_lockstep && this->dispatcher_.GetMode() != CallbackDispatcher::UPDATE) {
+            gzerr << "vehicle [" << _name << "] is in lockstep mode, set <lockstep>"
+                  << " or <callbackDispatch>update</callbackDispatch> on the swarm_controller.\n";
+            return false;
+        }
+        return true;
+    }
+
+    void Swarm::SpreadControl(ControlClock &_clock) {
+        if (_clock.EveryStep() || _clock.phaseSet) {
+            return;
+        }
+        const double step = this->world_->Physics()->GetMaxStepSize();
+        if (step <= 0.0) {
+            return;
+        }
+        const unsigned steps = static_cast<unsigned>(_clock.period.Double() / step + 0.5);
+        if (steps <= 1) {
+            return;
+        }
+        _clock.phase = step * (spreadIndex_++ % steps);
+    }
+
+    void Swarm::AdvertiseStates(const std::string &_topic) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        this->statesPub_ = this->rosnode_->advertise<suruiha_gazebo_plugins::VehicleStates>(_topic, 1);
+    }
+
+    bool Swarm::OpenRecorder(sdf::ElementPtr _sdf) {
+        boost::mutex::scoped_lock lock(this->update_mutex_);
+        return this->recorder_.Load(_sdf);
+    }
+
+    void Swarm::Update() {
+        common::Time currTime = this->world_->SimTime();
+        {
+            SURUIHA_PROFILE_SCOPE(&this->profiler_, STEP);
+            UpdateVehicles(currTime);
+        }
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+        this->profiler_.Report("swarm", currTime);
+#endif
+    }
+
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+    StepProfiler& Swarm::Profiler() {
+        return this->profiler_;
+    }
+#endif
+
+    void Swarm::UpdateVehicles(const common::Time &_currTime) {
+        {
+            SURUIHA_PROFILE_SCOPE(&this->profiler_, DISPATCH);
+            this->dispatcher_.Dispatch();
+        }
+
+        boost::mutex::scoped_lock lock(this->update_mutex_, boost::defer_lock);
+        {
+            SURUIHA_PROFILE_SCOPE(&this->profiler_, LOCK_WAIT);
+            lock.lock();
+        }
+
+        for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+            if (irisVehicles_[i].model) {
+                irisVehicles_[i].Prepare(_currTime);
+            }
+        }
+        {
+            SURUIHA_PROFILE_SCOPE(&this->profiler_, MIXER);
+            irisRotors_.Mix();
+        }
+        for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+            if (irisVehicles_[i].model) {
+                irisVehicles_[i].Actuate();
+            }
+        }
+        for (unsigned i = 0; i < zephyrVehicles_.size(); ++i) {
+            if (zephyrVehicles_[i].model) {
+                zephyrVehicles_[i].Update(_currTime);
+            }
+        }
+
+        SURUIHA_PROFILE_SCOPE(&this->profiler_, PUBLISH);
+        PublishStates(_currTime);
+    }
+
+    void Swarm::PublishStates(const common::Time &_currTime) {
+        if (!this->statesPub_ || this->statesPub_.getNumSubscribers() == 0) {
+            return;
+        }
+
+        const bool layoutChanged = statesLayoutChanged_;
+        if (layoutChanged) {
+            unsigned count = 0;
+            statesUpdateRate_ = -1;
+            for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+                if (irisVehicles_[i].model) {
+                    count++;
+                    if (statesUpdateRate_ < 0 || irisVehicles_[i].poseUpdateRate < statesUpdateRate_) {
+                        statesUpdateRate_ = irisVehicles_[i].poseUpdateRate;
+                    }
+                }
+            }
+            for (unsigned i = 0; i < zephyrVehicles_.size(); ++i) {
+                if (zephyrVehicles_[i].model) {
+                    count++;
+                    if (statesUpdateRate_ < 0 || zephyrVehicles_[i].poseUpdateRate < statesUpdateRate_) {
+                        statesUpdateRate_ = zephyrVehicles_[i].poseUpdateRate;
+                    }
+                }
+            }
+            statesMsg_.name.resize(count);
+            statesMsg_.pose.resize(count);
+            statesMsg_.twist.resize(count);
+            statesLayoutChanged_ = false;
+        }
+
+        if (statesMsg_.name.empty()) {
+            return;
+        }
+        double dt_ = (_currTime - lastStatesPublishTime_).Double()*1000; // miliseconds
+        if (!layoutChanged && dt_ <= statesUpdateRate_) {
+            return;
+        }
+
+        unsigned index = 0;
+        for (unsigned i = 0; i < irisVehicles_.size(); ++i) {
+            if (irisVehicles_[i].model) {
+                FillState(index++, irisVehicles_[i].name, irisVehicles_[i].state, layoutChanged);
+            }
+        }
+        for (unsigned i = 0; i < zephyrVehicles_.size(); ++i) {
+            if (zephyrVehicles_[i].model) {
+                FillState(index++, zephyrVehicles_[i].name, zephyrVehicles_[i].state, layoutChanged);
+            }
+        }
+
+        statesMsg_.header.stamp.sec = _currTime.sec;
+        statesMsg_.header.stamp.nsec = _currTime.nsec;
+        this->statesPub_.publish(statesMsg_);
+        lastStatesPublishTime_ = _currTime;
+    }
+
+    void Swarm::FillState(unsigned _index, const std::string &_name,
+            const VehicleState &_state, bool _withName) {
+        if (_withName) {
+            statesMsg_.name[_index] = _name;
+        }
+        geometry_msgs::Pose &pose = statesMsg_.pose[_index];
+        pose.position.x = _state.pose.Pos().X();
+        pose.position.y = _state.pose.Pos().Y();
+        pose.position.z = _state.pose.Pos().Z();
+        pose.orientation.x = _state.pose.Rot().X();
+        pose.orientation.y = _state.pose.Rot().Y();
+        pose.orientation.z = _state.pose.Rot().Z();
+        pose.orientation.w = _state.pose.Rot().W();
+
+        geometry_msgs::Twist &twist = statesMsg_.twist[_index];
+        twist.linear.x = _state.linearVel.X();
+        twist.linear.y = _state.linearVel.Y();
+        twist.linear.z = _state.linearVel.Z();
+        twist.angular.x = _state.bodyRates.X();
+        twist.angular.y = _state.bodyRates.Y();
+        twist.angular.z = _state.bodyRates.Z();
+    }
+
+    // no lock here, the physics thread must not wait for ros callbacks.
+    // push_back on a deque never moves its elements, so the pointer stays
+    // valid until the subscriber is shut down, and the mailbox is wait free.
+    void Swarm::SetIrisControl(IrisVehicle* _vehicle, const geometry_msgs::Twist::ConstPtr& _control) {
+        _vehicle->SetControl(*_control);
+    }
+
+    void Swarm::SetZephyrControl(ZephyrVehicle* _vehicle, const geometry_msgs::Twist::ConstPtr& _control) {
+        _vehicle->SetControl(*_control);
+    }
+
+    // lockstep commands, called on the update thread by Dispatch()
+    void Swarm::SetIrisControlStamped(IrisVehicle* _vehicle, const geometry_msgs::TwistStamped::ConstPtr& _control) {
+        _vehicle->SetControlStamped(*_control, this->world_->SimTime());
+    }
+
+    void Swarm::SetZephyrControlStamped(ZephyrVehicle* _vehicle, const geometry_msgs::TwistStamped::ConstPtr& _control) {
+        _vehicle->SetControlStamped(*_control, this->world_->SimTime());
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ *  \desc   Gazebo World Plugin to control every uav of the world at once
+ */
+
+#include <ros/ros.h>
+#include <suruiha_gazebo_plugins/swarm_controller.h>
+#include <gazebo/common/Plugin.hh>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_WORLD_PLUGIN(SwarmController);
+
+    SwarmController::SwarmController() {
+        swarm_ = nullptr;
+    }
+
+    SwarmController::~SwarmController() {
+        this->update_connection_.reset();
+        delete swarm_;
+    }
+
+    void SwarmController::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
+        this->world_ = _world;
+
+        // Make sure the ROS node for Gazebo has already been initalized
+        if (!ros::isInitialized()) {
+            ROS_FATAL_STREAM_NAMED("template", "A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                    << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+            return;
+        }
+
+        if (_sdf->HasElement("robotNamespace")) {
+            this->robot_namespace_ = _sdf->Get<std::string>("robotNamespace");
+        }
+
+        bool lockstep = _sdf->HasElement("lockstep") && _sdf->Get<bool>("lockstep");
+        swarm_ = new Swarm(this->world_, this->robot_namespace_,
+                CallbackDispatcher::ModeFromSdf(_sdf), lockstep);
+        if (_sdf->HasElement("statesTopic")) {
+            swarm_->AdvertiseStates(_sdf->Get<std::string>("statesTopic"));
+        }
+        swarm_->OpenRecorder(_sdf);
+#ifdef SURUIHA_ENABLE_INSTRUMENTATION
+        swarm_->Profiler().Load(_sdf);
+#endif
+
+        // New Mechanism for Updating every World Cycle
+        // Listen to the update event. This event is broadcast every
+        // simulation iteration.
+        this->update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&SwarmController::UpdateStates, this));
+    }
+
+    void SwarmController::UpdateStates() {
+        swarm_->Update();
+    }
+}
@@ -0,0 +1,295 @@
+/*
+ * vehicle_config.cpp
+ */
+
+#include <suruiha_gazebo_plugins/vehicle_config.h>
+#include <suruiha_gazebo_plugins/util.h>
+#include <gazebo/common/Console.hh>
+#include <ignition/math.hh>
+#include <boost/thread/mutex.hpp>
+#include <map>
+
+namespace gazebo {
+
+    /// \brief Names and values of _sdf and its children, without the
+    /// indentation and markup ToString builds for every element. The sdf of
+    /// a spawned model does not keep the file it came from, so this is what
+    /// tells two plugin sdfs apart.
+    static void AppendKey(const sdf::ElementPtr &_sdf, std::string &_key) {
+        _key += _sdf->GetName();
+        _key += '(';
+        for (size_t i = 0; i < _sdf->GetAttributeCount(); ++i) {
+            const sdf::ParamPtr attribute = _sdf->GetAttribute(i);
+            if (attribute->GetSet()) {
+                _key += attribute->GetKey();
+                _key += '=';
+                _key += attribute->GetAsString();
+                _key += ';';
+            }
+        }
+        const sdf::ParamPtr value = _sdf->GetValue();
+        if (value) {
+            _key += value->GetAsString();
+        }
+        for (sdf::ElementPtr child = _sdf->GetFirstElement(); child; child = child->GetNextElement()) {
+            AppendKey(child, _key);
+        }
+        _key += ')';
+    }
+
+    /// \brief Configs by the names and values of their plugin sdf. Invalid
+    /// ones are kept as null so that their errors are printed once.
+    template <typename T>
+    static std::shared_ptr<const T> Cached(sdf::ElementPtr _sdf, const char *_kind) {
+        static boost::mutex mutex;
+        static std::map<std::string, std::shared_ptr<const T> > cache;
+
+        std::string key;
+        AppendKey(_sdf, key);
+        boost::mutex::scoped_lock lock(mutex);
+        typename std::map<std::string, std::shared_ptr<const T> >::const_iterator it = cache.find(key);
+        if (it != cache.end()) {
+            if (!it->second) {
+                gzerr << _kind << " plugin sdf is not valid, see the errors of its first model.\n";
+            }
+            return it->second;
+        }
+
+        std::shared_ptr<T> config(new T());
+        if (!config->Load(_sdf)) {
+            config.reset();
+        }
+        cache[key] = config;
+        gzdbg << _kind << " config parsed, " << cache.size() << " configs cached.\n";
+        return config;
+    }
+
+    IrisConfig::IrisConfig() {
+        poseUpdateRate = 100;
+        pitchOffset = 0.041;
+        statsInterval = 0;
+        lockstep = false;
+        recordRate = 0;
+        onboardHold = false;
+    }
+
+    std::shared_ptr<const IrisConfig> IrisConfig::Get(sdf::ElementPtr _sdf) {
+        return Cached<IrisConfig>(_sdf, "iris");
+    }
+
+    bool IrisConfig::Load(sdf::ElementPtr _sdf) {
+        if (!_sdf->HasElement("poseUpdateRate")) {
+            gzerr << "iris plugin needs a poseUpdateRate.\n";
+            return false;
+        }
+        poseUpdateRate = _sdf->Get<int>("poseUpdateRate");
+        Util::GetSdfParam(_sdf, "pitchOffset", pitchOffset, pitchOffset);
+        double interval;
+        Util::GetSdfParam(_sdf, "statsInterval", interval, 0);
+        statsInterval = interval;
+        if (_sdf->HasElement("lockstep")) {
+            lockstep = _sdf->Get<bool>("lockstep");
+        }
+        controlClock.Load(_sdf);
+        Util::GetSdfParam(_sdf, "recordRate", recordRate, 0);
+        if (_sdf->HasElement("positionHold")) {
+            onboardHold = true;
+            hold.Load(_sdf->GetElement("positionHold"));
+        }
+
+        sdf::ElementPtr rotorSDF = _sdf->HasElement("rotor") ? _sdf->GetElement("rotor") : sdf::ElementPtr();
+        while (rotorSDF)
+        {
+          RotorControl rotor;
+
+          if (rotorSDF->HasAttribute("id"))
+          {
+            rotor.id = rotorSDF->GetAttribute("id")->Get(rotor.id);
+          }
+          else
+          {
+            rotor.id = rotors.size();
+            gzwarn << "id attribute not specified, use order parsed ["
+                   << rotor.id << "].\n";
+          }
+
+          if (!rotorSDF->HasElement("jointName"))
+          {
+            gzerr << "Please specify a jointName,"
+              << " where the rotor is attached.\n";
+            return false;
+          }
+          rotor.jointName = rotorSDF->Get<std::string>("jointName");
+
+          if (rotorSDF->HasElement("turningDirection"))
+          {
+            std::string turningDirection = rotorSDF->Get<std::string>(
+                "turningDirection");
+            // special cases mimic from rotors_gazebo_plugins
+            if (turningDirection == "cw")
+              rotor.multiplier = -1;
+            else if (turningDirection == "ccw")
+              rotor.multiplier = 1;
+            else
+            {
+              gzdbg << "not string, check turningDirection as float\n";
+              rotor.multiplier = rotorSDF->Get<double>("turningDirection");
+            }
+          }
+          else
+          {
+            rotor.multiplier = 1;
+            gzerr << "Please specify a turning"
+              << " direction multiplier ('cw' or 'ccw'). Default 'ccw'.\n";
+          }
+
+          // mixer matrix row of the rotor
+          bool hasMix = Util::GetSdfParam(rotorSDF, "mixPitch", rotor.mixPitch, 0);
+          hasMix = Util::GetSdfParam(rotorSDF, "mixRoll", rotor.mixRoll, 0) || hasMix;
+          hasMix = Util::GetSdfParam(rotorSDF, "mixYaw", rotor.mixYaw, 0) || hasMix;
+          if (!hasMix)
+          {
+            gzwarn << "rotor for joint [" << rotor.jointName
+                   << "] has no mixPitch, mixRoll or mixYaw,"
+                   << " it only follows the throttle.\n";
+          }
+          Util::GetSdfParam(rotorSDF, "trim", rotor.trim, 1);
+
+          Util::GetSdfParam(rotorSDF, "rotorVelocitySlowdownSim",
+              rotor.rotorVelocitySlowdownSim, 1);
+
+          if (ignition::math::equal(rotor.rotorVelocitySlowdownSim, 0.0))
+          {
+            gzerr << "rotor for joint [" << rotor.jointName
+                  << "] rotorVelocitySlowdownSim is zero,"
+                  << " aborting plugin.\n";
+            return false;
+          }
+
+          // the velocity is filtered only if a cutoff is given, sampled once
+          // per control tick unless samplingRate says otherwise. Without a
+          // controlRate that is the physics rate, only known once the vehicle
+          // is in a world, see IrisVehicle::Load
+          if (Util::GetSdfParam(rotorSDF, "frequencyCutoff",
+              rotor.frequencyCutoff, rotor.frequencyCutoff))
+          {
+            double order;
+            Util::GetSdfParam(rotorSDF, "filterOrder", order, 1);
+            rotor.filterOrder = static_cast<int>(order);
+            Util::GetSdfParam(rotorSDF, "samplingRate", rotor.samplingRate, 0);
+
+            if (rotor.filterOrder < 1 || rotor.filterOrder > 2 ||
+                rotor.frequencyCutoff <= 0 || rotor.samplingRate < 0 ||
+                (rotor.samplingRate > 0 && rotor.frequencyCutoff >= rotor.samplingRate / 2))
+            {
+              gzerr << "rotor for joint [" << rotor.jointName
+                    << "] needs filterOrder 1 or 2 and a frequencyCutoff"
+                    << " below half the samplingRate, velocity not filtered.\n";
+              rotor.filterOrder = 0;
+            }
+          }
+
+          // Overload the PID parameters if they are available.
+          double param;
+          Util::GetSdfParam(rotorSDF, "vel_p_gain", param, rotor.pid.GetPGain());
+          rotor.pid.SetPGain(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_i_gain", param, rotor.pid.GetIGain());
+          rotor.pid.SetIGain(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_d_gain", param,  rotor.pid.GetDGain());
+          rotor.pid.SetDGain(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_i_max", param, rotor.pid.GetIMax());
+          rotor.pid.SetIMax(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_i_min", param, rotor.pid.GetIMin());
+          rotor.pid.SetIMin(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_cmd_max", param,
+              rotor.pid.GetCmdMax());
+          rotor.pid.SetCmdMax(param);
+
+          Util::GetSdfParam(rotorSDF, "vel_cmd_min", param,
+              rotor.pid.GetCmdMin());
+          rotor.pid.SetCmdMin(param);
+
+          // set pid initial command
+          rotor.pid.SetCmd(0.0);
+
+          rotors.push_back(rotor);
+          rotorSDF = rotorSDF->GetNextElement("rotor");
+        }
+
+        if (rotors.empty()) {
+            gzerr << "iris plugin has no rotor.\n";
+            return false;
+        }
+        return true;
+    }
+
+    ZephyrConfig::ZephyrConfig() {
+        poseUpdateRate = 100;
+        statsInterval = 0;
+        lockstep = false;
+        recordRate = 0;
+    }
+
+    std::shared_ptr<const ZephyrConfig> ZephyrConfig::Get(sdf::ElementPtr _sdf) {
+        return Cached<ZephyrConfig>(_sdf, "zephyr");
+    }
+
+    bool ZephyrConfig::Load(sdf::ElementPtr _sdf) {
+        if (!_sdf->HasElement("poseUpdateRate")) {
+            gzerr << "zephyr plugin needs a poseUpdateRate.\n";
+            return false;
+        }
+        poseUpdateRate = _sdf->Get<int>("poseUpdateRate");
+        double interval;
+        Util::GetSdfParam(_sdf, "statsInterval", interval, 0);
+        statsInterval = interval;
+        if (_sdf->HasElement("lockstep")) {
+            lockstep = _sdf->Get<bool>("lockstep");
+        }
+        controlClock.Load(_sdf);
+        Util::GetSdfParam(_sdf, "recordRate", recordRate, 0);
+
+        sdf::ElementPtr jointControlSDF = _sdf->HasElement("joint_control") ?
+                _sdf->GetElement("joint_control") : sdf::ElementPtr();
+        while (jointControlSDF) {
+            ZephyrJointConfig joint;
+            if (!jointControlSDF->HasElement("name") || !jointControlSDF->HasElement("type")) {
+                gzerr << "joint_control " << joints.size() << " needs a name and a type.\n";
+                return false;
+            }
+            joint.name = jointControlSDF->Get<std::string>("name");
+            const std::string type = jointControlSDF->Get<std::string>("type");
+            if (!JointTypeFromString(type, joint.type)) {
+                gzerr << "Unknown joint type [" << type << "] of joint [" << joint.name << "].\n";
+                return false;
+            }
+
+            joint.pid = DefaultJointPid();
+            if (jointControlSDF->HasElement("p")) {
+                double p = jointControlSDF->Get<double>("p");
+                double i = jointControlSDF->Get<double>("i");
+                double d = jointControlSDF->Get<double>("d");
+                double imax = jointControlSDF->Get<double>("imax");
+                double imin = jointControlSDF->Get<double>("imin");
+                double cmdmax = jointControlSDF->Get<double>("cmdmax");
+                double cmdmin = jointControlSDF->Get<double>("cmdmin");
+                joint.pid.Init(p, i, d, imax, imin, cmdmax, cmdmin);
+            }
+            joints.push_back(joint);
+            jointControlSDF = jointControlSDF->GetNextElement("joint_control");
+        }
+
+        // CalculateJoints commands the propeller and the left and right flap
+        if (joints.size() < 3) {
+            gzerr << "zephyr plugin needs the propeller and two flap joint_control elements, it has "
+                  << joints.size() << ".\n";
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * vehicle_handoff.cpp
+ */
+
+#include <suruiha_gazebo_plugins/vehicle_handoff.h>
+#include <ignition/math.hh>
+
+namespace gazebo {
+
+    void Handoff::SavePid(const PidBank &_pid, unsigned _first, unsigned _count,
+            suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        for (unsigned i = _first; i < _first + _count; ++i) {
+            _msg.i_err.push_back(_pid.iErr[i]);
+            _msg.p_err_last.push_back(_pid.pErrLast[i]);
+            _msg.d_err.push_back(_pid.dErr[i]);
+            _msg.cmd.push_back(_pid.cmd[i]);
+        }
+    }
+
+    bool Handoff::RestorePid(PidBank &_pid, unsigned _first, unsigned _count,
+            const suruiha_gazebo_plugins::VehicleHandoff &_msg, unsigned &_offset) {
+        if (_msg.i_err.size() < _offset + _count || _msg.p_err_last.size() < _offset + _count ||
+                _msg.d_err.size() < _offset + _count || _msg.cmd.size() < _offset + _count) {
+            return false;
+        }
+        for (unsigned i = 0; i < _count; ++i) {
+            _pid.iErr[_first + i] = _msg.i_err[_offset + i];
+            _pid.pErrLast[_first + i] = _msg.p_err_last[_offset + i];
+            _pid.dErr[_first + i] = _msg.d_err[_offset + i];
+            _pid.cmd[_first + i] = _msg.cmd[_offset + i];
+        }
+        _offset += _count;
+        return true;
+    }
+
+    void Handoff::SaveModel(physics::ModelPtr _model, const std::vector<physics::JointPtr> &_joints,
+            suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        const ignition::math::Pose3d pose = _model->WorldPose();
+        _msg.pose.position.x = pose.Pos().X();
+        _msg.pose.position.y = pose.Pos().Y();
+        _msg.pose.position.z = pose.Pos().Z();
+        _msg.pose.orientation.x = pose.Rot().X();
+        _msg.pose.orientation.y = pose.Rot().Y();
+        _msg.pose.orientation.z = pose.Rot().Z();
+        _msg.pose.orientation.w = pose.Rot().W();
+
+        const ignition::math::Vector3d linear = _model->WorldLinearVel();
+        const ignition::math::Vector3d angular = _model->WorldAngularVel();
+        _msg.twist.linear.x = linear.X();
+        _msg.twist.linear.y = linear.Y();
+        _msg.twist.linear.z = linear.Z();
+        _msg.twist.angular.x = angular.X();
+        _msg.twist.angular.y = angular.Y();
+        _msg.twist.angular.z = angular.Z();
+
+        for (unsigned i = 0; i < _joints.size(); ++i) {
+            _msg.joint_positions.push_back(_joints[i]->Position(0));
+            _msg.joint_velocities.push_back(_joints[i]->GetVelocity(0));
+        }
+    }
+
+    bool Handoff::RestoreModel(physics::ModelPtr _model, const std::vector<physics::JointPtr> &_joints,
+            const suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        if (_msg.joint_positions.size() != _joints.size() || _msg.joint_velocities.size() != _joints.size()) {
+            return false;
+        }
+        _model->SetWorldPose(ignition::math::Pose3d(
+                ignition::math::Vector3d(_msg.pose.position.x, _msg.pose.position.y, _msg.pose.position.z),
+                ignition::math::Quaterniond(_msg.pose.orientation.w, _msg.pose.orientation.x,
+                        _msg.pose.orientation.y, _msg.pose.orientation.z)));
+        _model->SetLinearVel(ignition::math::Vector3d(
+                _msg.twist.linear.x, _msg.twist.linear.y, _msg.twist.linear.z));
+        _model->SetAngularVel(ignition::math::Vector3d(
+                _msg.twist.angular.x, _msg.twist.angular.y, _msg.twist.angular.z));
+
+        // the flaps of a zephyr are position controlled, the rotors spin on
+        for (unsigned i = 0; i < _joints.size(); ++i) {
+            _joints[i]->SetPosition(0, _msg.joint_positions[i]);
+            _joints[i]->SetVelocity(0, _msg.joint_velocities[i]);
+        }
+        return true;
+    }
+}
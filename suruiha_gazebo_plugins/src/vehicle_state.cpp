@@ -0,0 +1,52 @@
+/*
+ * vehicle_state.cpp
+ */
+
+#include <suruiha_gazebo_plugins/vehicle_state.h>
+#include <gazebo/common/Console.hh>
+
+namespace gazebo {
+
+    ControllerStats::ControllerStats() {
+        steps = 0;
+        poseReads = 0;
+        jointReads = 0;
+        lateCommands = 0;
+        lastReportTime = 0;
+    }
+
+    void ControllerStats::Report(const std::string &_name, const common::Time &_time,
+            const common::Time &_interval) {
+        if (_interval.Double() <= 0.0 || _time - lastReportTime < _interval) {
+            return;
+        }
+        lastReportTime = _time;
+
+        double perStep = steps > 0 ? 1.0 / steps : 0.0;
+        gzdbg << _name << " steps:" << steps
+              << " extra pose reads/step:" << poseReads * perStep
+              << " extra joint reads/step:" << jointReads * perStep
+              << " late commands:" << lateCommands << "\n";
+    }
+
+    VehicleState::VehicleState() {
+        time = 0;
+    }
+
+    void VehicleState::Read(const physics::ModelPtr &_model,
+            const std::vector<physics::JointPtr> &_joints,
+            const common::Time &_time) {
+        time = _time;
+        pose = _model->WorldPose();
+        euler = pose.Rot().Euler();
+        linearVel = _model->WorldLinearVel();
+        bodyRates = _model->RelativeAngularVel();
+
+        jointPositions.resize(_joints.size());
+        jointVelocities.resize(_joints.size());
+        for (unsigned i = 0; i < _joints.size(); ++i) {
+            jointPositions[i] = _joints[i]->Position(0);
+            jointVelocities[i] = _joints[i]->GetVelocity(0);
+        }
+    }
+}
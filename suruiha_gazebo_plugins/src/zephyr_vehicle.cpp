@@ -0,0 +1,241 @@
+/*
+ * zephyr_vehicle.cpp
+ */
+
+#include <suruiha_gazebo_plugins/zephyr_vehicle.h>
+#include <suruiha_gazebo_plugins/vehicle_config.h>
+#include <suruiha_gazebo_plugins/vehicle_handoff.h>
+#include <geometry_msgs/Pose.h>
+#include <ignition/math.hh>
+#include <sdf/sdf.hh>
+#include <algorithm>
+
+namespace gazebo {
+
+    ZephyrVehicle::ZephyrVehicle() {
+        lastUpdateTime = 0;
+        lastPosePublishTime = 0;
+        targetThrottle = 0.0;
+        targetPitch = 0.0;
+        targetRoll = 0.0;
+        poseUpdateRate = 100;
+        statsInterval = 0;
+        profiler = nullptr;
+        recorder = nullptr;
+        recordId = 0;
+        lockstep = false;
+    }
+
+    bool ZephyrVehicle::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf) {
+        this->model = _model;
+        this->name = _sdf->GetParent()->GetAttribute("name")->GetAsString();
+
+        // parsed once for every model spawned from the same sdf
+        std::shared_ptr<const ZephyrConfig> config = ZephyrConfig::Get(_sdf);
+        if (!config) {
+            gzerr << "zephyr [" << this->name << "] is not controlled.\n";
+            return false;
+        }
+        poseUpdateRate = config->poseUpdateRate;
+        statsInterval = config->statsInterval;
+        lockstep = config->lockstep;
+        controlClock = config->controlClock;
+        recordClock.SetRate(config->recordRate);
+
+        // every joint is found before any is controlled
+        std::vector<physics::JointPtr> found;
+        for (unsigned i = 0; i < config->joints.size(); ++i) {
+            physics::JointPtr joint = this->model->GetJoint(config->joints[i].name);
+            if (joint == nullptr) {
+            	gzerr << "cannot get joint with name:" << config->joints[i].name << "\n";
+            	return false;
+            }
+            found.push_back(joint);
+        }
+        for (unsigned i = 0; i < config->joints.size(); ++i) {
+            const ZephyrJointConfig &joint = config->joints[i];
+            joints.Add(joint.name, joint.type, found[i], joint.pid);
+            jointPtrs.push_back(found[i]);
+        }
+
+        return true;
+    }
+
+    void ZephyrVehicle::Unload() {
+        controlSub.shutdown();
+        posePub.shutdown();
+        joints.Clear();
+        jointPtrs.clear();
+        schedule.Clear();
+        model.reset();
+    }
+
+    static ZephyrTargets TargetsFromTwist(const geometry_msgs::Twist &_twist) {
+        ZephyrTargets targets;
+        targets.throttle = _twist.linear.x;
+        targets.pitch = _twist.angular.y;
+        targets.roll = _twist.angular.x;
+        return targets;
+    }
+
+    void ZephyrVehicle::SetControl(const geometry_msgs::Twist &_twist) {
+        command.Write(TargetsFromTwist(_twist));
+    }
+
+    void ZephyrVehicle::SetControlStamped(const geometry_msgs::TwistStamped &_control,
+            const common::Time &_now) {
+        common::Time stamp(_control.header.stamp.sec, _control.header.stamp.nsec);
+        if (!schedule.Push(stamp, TargetsFromTwist(_control.twist), _now)) {
+            stats.lateCommands++;
+        }
+    }
+
+    std::string ZephyrVehicle::ControlTopic() const {
+        return name + (lockstep ? "_control_stamped" : "_control");
+    }
+
+    void ZephyrVehicle::Export(suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        _msg.name = name;
+        _msg.type = "zephyr";
+        Handoff::SaveModel(model, jointPtrs, _msg);
+        stats.poseReads++;
+        stats.jointReads += jointPtrs.size();
+
+        const ZephyrTargets &last = command.Read();
+        _msg.targets.assign({last.throttle, last.pitch, last.roll});
+        Handoff::SavePid(joints.position.pid, 0, joints.position.pid.Size(), _msg);
+        Handoff::SavePid(joints.velocity.pid, 0, joints.velocity.pid.Size(), _msg);
+        _msg.joint_commands = joints.commands;
+    }
+
+    bool ZephyrVehicle::Import(const suruiha_gazebo_plugins::VehicleHandoff &_msg) {
+        const unsigned pids = joints.position.pid.Size() + joints.velocity.pid.Size();
+        if (_msg.targets.size() != 3 || _msg.i_err.size() != pids ||
+                _msg.joint_commands.size() != joints.commands.size()) {
+            gzerr << "zephyr [" << name << "] handoff does not match its joints, not restored.\n";
+            return false;
+        }
+        if (!Handoff::RestoreModel(model, jointPtrs, _msg)) {
+            gzerr << "zephyr [" << name << "] handoff does not match its joints, not restored.\n";
+            return false;
+        }
+
+        unsigned offset = 0;
+        Handoff::RestorePid(joints.position.pid, 0, joints.position.pid.Size(), _msg, offset);
+        Handoff::RestorePid(joints.velocity.pid, 0, joints.velocity.pid.Size(), _msg, offset);
+        joints.commands = _msg.joint_commands;
+
+        ZephyrTargets last;
+        last.throttle = targetThrottle = _msg.targets[0];
+        last.pitch = targetPitch = _msg.targets[1];
+        last.roll = targetRoll = _msg.targets[2];
+        command.Write(last);
+        return true;
+    }
+
+    void ZephyrVehicle::Update(const common::Time &_currTime) {
+    	stats.steps++;
+    	{
+    		SURUIHA_PROFILE_SCOPE(profiler, STATE);
+    		state.Read(this->model, this->jointPtrs, _currTime);
+    	}
+    	{
+    		SURUIHA_PROFILE_SCOPE(profiler, PUBLISH);
+    		PublishPose(_currTime);
+    	}
+
+    	// in lockstep mode this thread is also the only writer of the mailbox
+    	ZephyrTargets due;
+    	if (lockstep && schedule.PopDue(_currTime, due)) {
+    		command.Write(due);
+    	}
+
+        const bool controlActive = controlSub.getNumPublishers() > 0;
+        const bool controlTick = controlActive && controlClock.Due(_currTime);
+        if (controlTick) {
+            const ZephyrTargets &targets = command.Read();
+            targetThrottle = targets.throttle;
+            targetPitch = targets.pitch;
+            targetRoll = targets.roll;
+
+            double dt_ = (_currTime - lastUpdateTime).Double();
+            if (lastUpdateTime.Double() == 0.0) {
+            	dt_ = 0.0;
+            }
+            SURUIHA_PROFILE_SCOPE(profiler, PID);
+        	CalculateJoints(targetThrottle, targetPitch, targetRoll, dt_);
+        } else if (controlActive) {
+            // forces are cleared every step, apply the last ones again
+            SURUIHA_PROFILE_SCOPE(profiler, PID);
+            joints.Hold();
+        }
+
+        if (controlTick || !controlActive) {
+            this->lastUpdateTime = _currTime;
+        }
+        Record(controlTick);
+        stats.Report(this->name, _currTime, statsInterval);
+    }
+
+    void ZephyrVehicle::PublishPose(const common::Time &_currTime) {
+    	if (this->posePub.getNumSubscribers() > 0) {
+    		double dt_ = (_currTime - lastPosePublishTime).Double()*1000; // miliseconds
+    		if (dt_ > poseUpdateRate) {
+    			const ignition::math::Pose3d &pose = state.pose;
+    			geometry_msgs::Pose poseMsg;
+    			poseMsg.position.x = pose.Pos().X();
+    			poseMsg.position.y = pose.Pos().Y();
+    			poseMsg.position.z = pose.Pos().Z();
+    			poseMsg.orientation.x = pose.Rot().X();
+    			poseMsg.orientation.y = pose.Rot().Y();
+    			poseMsg.orientation.z = pose.Rot().Z();
+    			poseMsg.orientation.w = pose.Rot().W();
+    			this->posePub.publish(poseMsg);
+    			lastPosePublishTime = _currTime;
+    		}
+    	}
+    }
+
+    /// \brief PID errors of the joints of one type, by joint index
+    template <JointType TYPE>
+    static void RecordPid(const JointArray<TYPE> &_joints, FlightSample &_sample) {
+        for (unsigned i = 0; i < _joints.pid.Size(); ++i) {
+            const unsigned j = _joints.index[i];
+            if (j < FlightSample::ACTUATORS) {
+                _sample.values[FlightSample::P_ERR + j] = _joints.pid.pErrLast[i];
+                _sample.values[FlightSample::I_ERR + j] = _joints.pid.iErr[i];
+                _sample.values[FlightSample::D_ERR + j] = _joints.pid.dErr[i];
+            }
+        }
+    }
+
+    void ZephyrVehicle::Record(bool _tick) {
+        if (recorder == nullptr || !recordClock.Due(state.time)) {
+            return;
+        }
+        SURUIHA_PROFILE_SCOPE(profiler, RECORD);
+        FlightSample sample;
+        sample.SetState(recordId, state, _tick);
+        const unsigned count = std::min(joints.Size(), FlightSample::ACTUATORS);
+        for (unsigned j = 0; j < count; ++j) {
+            sample.values[FlightSample::CMD + j] = joints.commands[j];
+        }
+        // effort joints have no PID, their errors stay NaN
+        RecordPid(joints.position, sample);
+        RecordPid(joints.velocity, sample);
+        recorder->Record(sample);
+    }
+
+    void ZephyrVehicle::CalculateJoints(double targetThrottle, double targetPitch, double targetRoll, common::Time dt) {
+		double pitch = state.euler.X();
+		double roll = state.euler.Y();
+
+		pitch = pitch - targetPitch;
+		roll = roll - targetRoll;
+
+		joints.SetCommand(0, targetThrottle);
+		joints.SetCommand(1, pitch - roll);
+		joints.SetCommand(2, pitch + roll);
+		joints.Update(dt, state.jointPositions, state.jointVelocities);
+    }
+}
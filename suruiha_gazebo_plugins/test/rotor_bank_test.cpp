@@ -0,0 +1,99 @@
+#include <suruiha_gazebo_plugins/rotor_bank.h>
+#include <gtest/gtest.h>
+
+using namespace gazebo;
+
+namespace {
+
+/// \brief mixer rows of iris_quadrotor_with_plugin, rotor i speeds up by
+/// the error of each axis times these
+const double MIX_PITCH[4] = {1, -1, 1, -1};
+const double MIX_ROLL[4] = {1, -1, -1, 1};
+const double MIX_YAW[4] = {1, 1, -1, -1};
+
+/// \brief the rotor commands of IrisController::CalculateRotors before the
+/// RotorBank, for the pitch, roll and yaw errors
+void calculateRotors(double _throttle, double _pitch, double _roll, double _yaw, double _cmd[4]) {
+    const double frontPitchRotors = 1.0 - _pitch;
+    const double rearPitchRotors = 1.0 + _pitch;
+    const double frontRollRotors = 1.0 - _roll;
+    const double rearRollRotors = 1.0 + _roll;
+    const double frontYawRotors = 1.0 - _yaw;
+    const double rearYawRotors = 1.0 + _yaw;
+
+    for (unsigned i = 0; i < 4; ++i) {
+        _cmd[i] = _throttle;
+    }
+    _cmd[3] *= frontPitchRotors;
+    _cmd[1] *= frontPitchRotors;
+    _cmd[0] *= rearPitchRotors;
+    _cmd[2] *= rearPitchRotors;
+
+    _cmd[3] *= rearRollRotors;
+    _cmd[0] *= rearRollRotors;
+    _cmd[1] *= frontRollRotors;
+    _cmd[2] *= frontRollRotors;
+
+    _cmd[3] *= frontYawRotors;
+    _cmd[2] *= frontYawRotors;
+    _cmd[1] *= rearYawRotors;
+    _cmd[0] *= rearYawRotors;
+}
+
+int addIris(RotorBank& _bank) {
+    const int vehicle = _bank.AddVehicle();
+    for (unsigned i = 0; i < 4; ++i) {
+        RotorControl rotor;
+        rotor.id = i;
+        rotor.mixPitch = MIX_PITCH[i];
+        rotor.mixRoll = MIX_ROLL[i];
+        rotor.mixYaw = MIX_YAW[i];
+        _bank.AddRotor(vehicle, rotor);
+    }
+    return vehicle;
+}
+
+}
+
+TEST(RotorBank, MixMatchesCalculateRotorsForLargeYawErrors) {
+    // yaw is not normalized, a vehicle turned around has an error of pi and more
+    const double yaws[] = {0.0, 0.5, -1.0, M_PI, -M_PI, 1.5 * M_PI, -2.0 * M_PI + 0.1};
+    for (unsigned y = 0; y < sizeof(yaws) / sizeof(yaws[0]); ++y) {
+        RotorBank bank;
+        const int vehicle = addIris(bank);
+        bank.SetInputs(vehicle, 430, 0.05, -0.02, yaws[y]);
+        bank.SetFeedback(vehicle, common::Time(0.0025), std::vector<double>(4, 0.0));
+        bank.Mix();
+
+        double expected[4];
+        calculateRotors(430, 0.05, -0.02, yaws[y], expected);
+        for (unsigned i = 0; i < 4; ++i) {
+            EXPECT_NEAR(expected[i], bank.cmd[bank.FirstRotor(vehicle) + i], 1e-9)
+                    << "rotor " << i << " yaw " << yaws[y];
+        }
+    }
+}
+
+TEST(RotorBank, MixScalesEveryVehicleByItsTrim) {
+    RotorBank bank;
+    const int first = addIris(bank);
+    const int second = bank.AddVehicle();
+    for (unsigned i = 0; i < 4; ++i) {
+        RotorControl rotor;
+        rotor.mixPitch = MIX_PITCH[i];
+        rotor.mixRoll = MIX_ROLL[i];
+        rotor.mixYaw = MIX_YAW[i];
+        rotor.trim = 0.5;
+        bank.AddRotor(second, rotor);
+    }
+    bank.SetInputs(first, 430, -0.1, 0.3, 2.0 * M_PI);
+    bank.SetInputs(second, 430, -0.1, 0.3, 2.0 * M_PI);
+    bank.Mix();
+
+    double expected[4];
+    calculateRotors(430, -0.1, 0.3, 2.0 * M_PI, expected);
+    for (unsigned i = 0; i < 4; ++i) {
+        EXPECT_NEAR(expected[i], bank.cmd[bank.FirstRotor(first) + i], 1e-9);
+        EXPECT_NEAR(0.5 * expected[i], bank.cmd[bank.FirstRotor(second) + i], 1e-9);
+    }
+}
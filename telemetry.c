@@ -0,0 +1,89 @@
+#include "stm32f10x.h"
+#include "telemetry_protocol.h"
+#include "telemetry.h"
+
+// Telemetry frames of uav_ground_control/include/uav_ground_control/
+// telemetry_protocol.h, add that directory to the include path.
+// USART1 transmits on PA9, its DMA channel sends a frame while the control
+// loop keeps running.
+#ifndef TM_USART
+#define TM_USART            USART1
+#define TM_USART_RCC        RCC_APB2Periph_USART1
+#define TM_GPIO             GPIOA
+#define TM_GPIO_RCC         RCC_APB2Periph_GPIOA
+#define TM_TX_PIN           GPIO_Pin_9
+#define TM_DMA_CHANNEL      DMA1_Channel4
+#endif
+
+static u8 tm_frame[TELEMETRY_MAX_FRAME];
+static u8 tm_sequence = 0;
+
+void telemetry_init(u32 _baud)
+{
+    GPIO_InitTypeDef gpio;
+    USART_InitTypeDef usart;
+    DMA_InitTypeDef dma;
+
+    RCC_APB2PeriphClockCmd(TM_GPIO_RCC | TM_USART_RCC, ENABLE);
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    gpio.GPIO_Pin = TM_TX_PIN;
+    gpio.GPIO_Speed = GPIO_Speed_50MHz;
+    gpio.GPIO_Mode = GPIO_Mode_AF_PP;
+    GPIO_Init(TM_GPIO, &gpio);
+
+    USART_StructInit(&usart);
+    usart.USART_BaudRate = _baud;
+    usart.USART_Mode = USART_Mode_Tx;
+    USART_Init(TM_USART, &usart);
+
+    DMA_DeInit(TM_DMA_CHANNEL);
+    DMA_StructInit(&dma);
+    dma.DMA_PeripheralBaseAddr = (u32)&TM_USART->DR;
+    dma.DMA_MemoryBaseAddr = (u32)tm_frame;
+    dma.DMA_DIR = DMA_DIR_PeripheralDST;
+    dma.DMA_BufferSize = 0;
+    dma.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    dma.DMA_Priority = DMA_Priority_Low;
+    DMA_Init(TM_DMA_CHANNEL, &dma);
+
+    USART_DMACmd(TM_USART, USART_DMAReq_Tx, ENABLE);
+    USART_Cmd(TM_USART, ENABLE);
+}
+
+// 1 while the last frame is still going out
+int telemetry_busy(void)
+{
+    return (TM_DMA_CHANNEL->CCR & DMA_CCR1_EN) && DMA_GetCurrDataCounter(TM_DMA_CHANNEL) != 0;
+}
+
+static void telemetry_send(u16 _size)
+{
+    DMA_Cmd(TM_DMA_CHANNEL, DISABLE);
+    DMA_SetCurrDataCounter(TM_DMA_CHANNEL, _size);
+    DMA_Cmd(TM_DMA_CHANNEL, ENABLE);
+}
+
+// Send one row of temperatures, e.g. what ds18b20_fetch read, -127 for a
+// sensor that failed. Returns 0 if the last frame is not out yet.
+int telemetry_send_temperatures(u32 _time_ms, u16 _period_ms, const float *_celsius, u8 _count)
+{
+    s16 values[TELEMETRY_TEMPERATURE_MAX_VALUES];
+    u16 size;
+    u8 i;
+    if (telemetry_busy())
+        return 0;
+    for (i = 0; i < _count && i < TELEMETRY_TEMPERATURE_MAX_VALUES; i++)
+    {
+        if (_celsius[i] <= -127.0f)
+            values[i] = TELEMETRY_TEMPERATURE_INVALID;
+        else
+            values[i] = (s16)(_celsius[i] * 16.0f + (_celsius[i] < 0 ? -0.5f : 0.5f));
+    }
+    size = telemetry_encode_temperatures(tm_frame, tm_sequence, _time_ms, _period_ms, i, 1, values);
+    if (!size)
+        return 0;
+    tm_sequence++;
+    telemetry_send(size);
+    return 1;
+}
@@ -0,0 +1,23 @@
+/*
+ * telemetry.h
+ *
+ *  Telemetry frames of uav_ground_control/include/uav_ground_control/
+ *  telemetry_protocol.h out of USART1 by DMA, see telemetry.c. Nothing
+ *  here waits for the UART, so the control loop keeps its period.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "stm32f10x.h"
+
+// UART and DMA channel at _baud, before any other call
+void telemetry_init(u32 _baud);
+// Returns 1 while the last frame is still going out
+int telemetry_busy(void);
+// One row of _count temperatures in degC, -127 for a sensor that failed,
+// taken _period_ms apart at _time_ms. Returns 0 if the last frame is not
+// out yet, 1 once the frame is sent.
+int telemetry_send_temperatures(u32 _time_ms, u16 _period_ms, const float *_celsius, u8 _count);
+
+#endif
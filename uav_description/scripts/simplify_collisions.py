@@ -0,0 +1,311 @@
+#!/usr/bin/env python
+"""Replace the mesh collisions of the gazebo_models with boxes.
+
+Every <collision> of a model sdf whose geometry is a COLLADA <mesh> is
+replaced by boxes that bound the mesh, so that ODE checks contacts against
+primitives instead of triangles. The mesh is cut into slabs along its
+longest axis and every slab gets the bounding box of its part of the mesh.
+The fewest slabs are used whose total volume is within --gain of the volume
+of --max-boxes slabs.
+
+  rosrun uav_description simplify_collisions.py $(rospack find uav_description)/gazebo_models
+  rosrun uav_description simplify_collisions.py --check $(rospack find uav_description)/gazebo_models
+
+--check changes nothing and fails if a mesh collision is left, the build of
+uav_description runs it. Visual meshes are left as they are, gazebo 9 has no
+level of detail for visuals in sdf.
+"""
+from __future__ import print_function
+
+import argparse
+import math
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+COLLADA = '{http://www.collada.org/2005/11/COLLADASchema}'
+COLLISION = re.compile(r'([ \t]*)<collision\s+name=([\'"])(.*?)\2\s*>(.*?)</collision>', re.DOTALL)
+COMMENT = re.compile(r'<!--.*?-->', re.DOTALL)
+GENERATED = 'generated by simplify_collisions.py'
+
+
+def identity():
+    return [[1.0 if i == j else 0.0 for j in range(4)] for i in range(4)]
+
+
+def multiply(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(4)) for j in range(4)] for i in range(4)]
+
+
+def node_transform(node):
+    """transform of a COLLADA node, its elements applied in order"""
+    m = identity()
+    for element in node:
+        tag = element.tag.replace(COLLADA, '')
+        values = [float(v) for v in (element.text or '').split()]
+        t = identity()
+        if tag == 'matrix':
+            t = [values[i * 4:i * 4 + 4] for i in range(4)]
+        elif tag == 'translate':
+            for i in range(3):
+                t[i][3] = values[i]
+        elif tag == 'scale':
+            for i in range(3):
+                t[i][i] = values[i]
+        elif tag == 'rotate':
+            x, y, z, angle = values
+            n = math.sqrt(x * x + y * y + z * z)
+            x, y, z = x / n, y / n, z / n
+            c, s = math.cos(math.radians(angle)), math.sin(math.radians(angle))
+            t = [[c + x * x * (1 - c), x * y * (1 - c) - z * s, x * z * (1 - c) + y * s, 0.0],
+                 [y * x * (1 - c) + z * s, c + y * y * (1 - c), y * z * (1 - c) - x * s, 0.0],
+                 [z * x * (1 - c) - y * s, z * y * (1 - c) + x * s, c + z * z * (1 - c), 0.0],
+                 [0.0, 0.0, 0.0, 1.0]]
+        else:
+            continue
+        m = multiply(m, t)
+    return m
+
+
+def apply(m, p):
+    return [m[i][0] * p[0] + m[i][1] * p[1] + m[i][2] * p[2] + m[i][3] for i in range(3)]
+
+
+def geometry_polygons(geometry):
+    """polygons of a COLLADA geometry as lists of positions"""
+    mesh = geometry.find(COLLADA + 'mesh')
+    sources = {}
+    for source in mesh.findall(COLLADA + 'source'):
+        values = [float(v) for v in source.find(COLLADA + 'float_array').text.split()]
+        stride = int(source.find('.//' + COLLADA + 'accessor').get('stride', '3'))
+        sources[source.get('id')] = [values[i:i + stride] for i in range(0, len(values), stride)]
+    vertices = {}
+    for element in mesh.findall(COLLADA + 'vertices'):
+        for i in element.findall(COLLADA + 'input'):
+            if i.get('semantic') == 'POSITION':
+                vertices[element.get('id')] = sources[i.get('source')[1:]]
+
+    polygons = []
+    for primitive in mesh:
+        tag = primitive.tag.replace(COLLADA, '')
+        if tag not in ('triangles', 'polylist', 'polygons'):
+            continue
+        inputs = primitive.findall(COLLADA + 'input')
+        stride = max(int(i.get('offset')) for i in inputs) + 1
+        offset = [int(i.get('offset')) for i in inputs if i.get('semantic') == 'VERTEX'][0]
+        positions = vertices[[i.get('source')[1:] for i in inputs if i.get('semantic') == 'VERTEX'][0]]
+        lists = [p.text for p in primitive.findall(COLLADA + 'p')]
+        if tag == 'polygons':
+            counts = [None] * len(lists)
+        else:
+            indices = [int(v) for v in ' '.join(lists).split()]
+            lists = [indices]
+            if tag == 'triangles':
+                counts = [3] * (len(indices) // (3 * stride))
+            else:
+                counts = [int(v) for v in primitive.find(COLLADA + 'vcount').text.split()]
+        if tag == 'polygons':
+            for text in lists:
+                indices = [int(v) for v in text.split()]
+                polygons.append([positions[indices[k + offset]] for k in range(0, len(indices), stride)])
+        else:
+            indices = lists[0]
+            k = 0
+            for count in counts:
+                polygons.append([positions[indices[(k + n) * stride + offset]] for n in range(count)])
+                k += count
+    return polygons
+
+
+def load_submesh(dae_file, submesh, scale):
+    """polygons of the mesh, of the node named submesh only if given, in metres"""
+    root = ET.parse(dae_file).getroot()
+    asset = root.find(COLLADA + 'asset')
+    unit = 1.0
+    if asset is not None:
+        if asset.find(COLLADA + 'unit') is not None:
+            unit = float(asset.find(COLLADA + 'unit').get('meter', '1'))
+        up = asset.findtext(COLLADA + 'up_axis')
+        if up and up.strip() != 'Z_UP':
+            raise ValueError('%s: only Z_UP meshes are supported' % dae_file)
+    geometries = dict((g.get('id'), g) for g in root.iter(COLLADA + 'geometry'))
+
+    polygons = []
+
+    def visit(node, transform, inside):
+        transform = multiply(transform, node_transform(node))
+        inside = inside or submesh is None or node.get('name') == submesh
+        if inside:
+            for instance in node.findall(COLLADA + 'instance_geometry'):
+                for polygon in geometry_polygons(geometries[instance.get('url')[1:]]):
+                    polygons.append([[v * unit * s for v, s in zip(apply(transform, p), scale)]
+                                     for p in polygon])
+        for child in node.findall(COLLADA + 'node'):
+            visit(child, transform, inside)
+
+    for scene in root.iter(COLLADA + 'visual_scene'):
+        for node in scene.findall(COLLADA + 'node'):
+            visit(node, identity(), False)
+    if not polygons:
+        raise ValueError('%s has no submesh %s' % (dae_file, submesh))
+    return polygons
+
+
+def bounds(points):
+    return ([min(p[i] for p in points) for i in range(3)], [max(p[i] for p in points) for i in range(3)])
+
+
+def slab_boxes(polygons, count):
+    """bounding boxes of count slabs along the longest axis of the mesh"""
+    low, high = bounds([p for polygon in polygons for p in polygon])
+    axis = max(range(3), key=lambda i: high[i] - low[i])
+    edges = [low[axis] + (high[axis] - low[axis]) * k / count for k in range(count + 1)]
+    slabs = [[] for _ in range(count)]
+
+    def slab(value):
+        return min(count - 1, max(0, int((value - low[axis]) / (high[axis] - low[axis]) * count)))
+
+    for polygon in polygons:
+        for a, b in zip(polygon, polygon[1:] + polygon[:1]):
+            slabs[slab(a[axis])].append(a)
+            # the points where the edge crosses a slab border belong to both slabs
+            first, last = sorted((slab(a[axis]), slab(b[axis])))
+            for k in range(first + 1, last + 1):
+                t = (edges[k] - a[axis]) / (b[axis] - a[axis])
+                point = [a[i] + (b[i] - a[i]) * t for i in range(3)]
+                slabs[k - 1].append(point)
+                slabs[k].append(point)
+    return [bounds(points) for points in slabs if points]
+
+
+def volume(boxes):
+    return sum((h[0] - l[0]) * (h[1] - l[1]) * (h[2] - l[2]) for l, h in boxes)
+
+
+def fit_boxes(polygons, max_boxes, gain):
+    """fewest slabs whose volume is within gain of the volume of max_boxes slabs"""
+    fits = [slab_boxes(polygons, count) for count in range(1, max_boxes + 1)]
+    tightest = volume(fits[-1])
+    return [boxes for boxes in fits if volume(boxes) <= tightest * (1.0 + gain)][0]
+
+
+def parse_pose(text):
+    values = [float(v) for v in (text or '').split()]
+    return (values + [0.0] * 6)[:6]
+
+
+def rotate(rpy, p):
+    roll, pitch, yaw = rpy
+    cr, sr = math.cos(roll), math.sin(roll)
+    cp, sp = math.cos(pitch), math.sin(pitch)
+    cy, sy = math.cos(yaw), math.sin(yaw)
+    r = [[cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+         [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+         [-sp, cp * sr, cp * cr]]
+    return [sum(r[i][j] * p[j] for j in range(3)) for i in range(3)]
+
+
+def model_file(uri, models_dir):
+    if not uri.startswith('model://'):
+        raise ValueError('mesh %s is not a model:// uri' % uri)
+    return os.path.join(models_dir, uri[len('model://'):])
+
+
+def simplified(indent, name, body, models_dir, max_boxes, gain):
+    """text of the box collisions that replace the mesh collision name"""
+    collision = ET.fromstring('<collision name="%s">%s</collision>' % (name, body))
+    mesh = collision.find('geometry/mesh')
+    uri = mesh.findtext('uri').strip()
+    submesh = mesh.findtext('submesh/name')
+    center = (mesh.findtext('submesh/center') or 'false').strip() in ('true', '1')
+    scale = [float(v) for v in (mesh.findtext('scale') or '1 1 1').split()]
+    polygons = load_submesh(model_file(uri, models_dir), submesh.strip() if submesh else None, scale)
+    boxes = fit_boxes(polygons, max_boxes, gain)
+
+    pose = parse_pose(collision.findtext('pose'))
+    offset = [0.0, 0.0, 0.0]
+    if center:
+        # gazebo moves the centre of a centred submesh to the origin
+        low, high = bounds([p for polygon in polygons for p in polygon])
+        offset = [-(low[i] + high[i]) / 2.0 for i in range(3)]
+    rest = [e for e in collision if e.tag not in ('pose', 'geometry')]
+
+    step = re.match(r'\s*', body).group(0).replace('\n', '')[len(indent):] or '  '
+    lines = ['%s<!-- boxes of %s%s, %s -->' % (indent, uri, ' ' + submesh if submesh else '', GENERATED)]
+    for k, (low, high) in enumerate(boxes):
+        mid = [(low[i] + high[i]) / 2.0 + offset[i] for i in range(3)]
+        mid = [pose[i] + v for i, v in enumerate(rotate(pose[3:], mid))]
+        size = [high[i] - low[i] for i in range(3)]
+        lines.append('%s<collision name="%s">' % (indent, name if k == 0 else '%s_%d' % (name, k)))
+        lines.append('%s%s<pose>%s</pose>' % (indent, step, ' '.join('%.5g' % v for v in mid + pose[3:])))
+        lines.append('%s%s<geometry>' % (indent, step))
+        lines.append('%s%s%s<box>' % (indent, step, step))
+        lines.append('%s%s%s%s<size>%s</size>' % (indent, step, step, step, ' '.join('%.5g' % v for v in size)))
+        lines.append('%s%s%s</box>' % (indent, step, step))
+        lines.append('%s%s</geometry>' % (indent, step))
+        for element in rest:
+            text = ET.tostring(element).decode() if sys.version_info[0] > 2 else ET.tostring(element)
+            lines.append('%s%s%s' % (indent, step, text.strip()))
+        lines.append('%s</collision>' % indent)
+    return '\n'.join(lines), len(boxes)
+
+
+def model_sdfs(models_dir):
+    for model in sorted(os.listdir(models_dir)):
+        directory = os.path.join(models_dir, model)
+        if not os.path.isdir(directory):
+            continue
+        for name in sorted(os.listdir(directory)):
+            if name.endswith('.sdf'):
+                yield os.path.join(directory, name)
+
+
+def process(sdf_file, models_dir, check, max_boxes, gain):
+    with open(sdf_file) as f:
+        text = f.read()
+    comments = [m.span() for m in COMMENT.finditer(text)]
+    left = []
+    out = []
+    end = 0
+    for match in COLLISION.finditer(text):
+        if any(a <= match.start() < b for a, b in comments) or '<mesh>' not in match.group(4):
+            continue
+        name = match.group(3)
+        if check:
+            left.append(name)
+            continue
+        replacement, count = simplified(match.group(1), name, match.group(4), models_dir, max_boxes, gain)
+        out.append(text[end:match.start()])
+        out.append(replacement)
+        end = match.end()
+        print('%s: %s, %d boxes' % (sdf_file, name, count))
+    if out:
+        out.append(text[end:])
+        with open(sdf_file, 'w') as f:
+            f.write(''.join(out))
+    return left
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('models', help='gazebo_models directory')
+    parser.add_argument('--check', action='store_true', help='only fail if a mesh collision is left')
+    parser.add_argument('--max-boxes', type=int, default=8, help='boxes per mesh collision at most')
+    parser.add_argument('--gain', type=float, default=0.25,
+                        help='volume above the tightest fit that is accepted for fewer boxes, '
+                             'default %(default)s')
+    args = parser.parse_args()
+
+    left = []
+    for sdf_file in model_sdfs(args.models):
+        left += ['%s: %s' % (sdf_file, name) for name in
+                 process(sdf_file, args.models, args.check, args.max_boxes, args.gain)]
+    if left:
+        print('mesh collisions left, run simplify_collisions.py %s:\n  %s'
+              % (args.models, '\n  '.join(left)), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+"""Flies one batch scenario and writes its trajectory metrics as json.
+
+Started by launch/batch_instance.launch with gazebo paused. batch_runner.py
+runs the iris in lockstep with its onboard position hold, so the flight is
+one setpoint over ~start_x ~start_y at ~target_height, stamped at the start
+of the sim on <vehicle>_control_stamped before gazebo is unpaused. Nothing
+of the flight then depends on when this node gets to run. It samples
+<vehicle>_pose for ~duration seconds of sim time and writes the metrics to
+~out, then exits which ends the launch.
+"""
+import json
+import math
+import time
+
+import rospy
+import tf
+
+from geometry_msgs.msg import TwistStamped
+from geometry_msgs.msg import Pose
+from std_srvs.srv import Empty
+
+# altitude error counted as settled, meters
+SETTLED_ERROR = 1.0
+# tilt in radians or height in meters after take off counted as a crash
+CRASH_TILT = 1.2
+CRASH_HEIGHT = 0.3
+AIRBORNE_HEIGHT = 2.0
+
+
+class BatchMetrics(object):
+
+    def __init__(self, vehicle, duration, start_x, start_y, start_yaw, target_height):
+        self.duration = duration
+        self.start_x = start_x
+        self.start_y = start_y
+        self.start_yaw = start_yaw
+        self.target_height = target_height
+        self.start_time = None
+        self.done = False
+
+        self.samples = 0
+        self.last_pose = None
+        self.settle_time = float('nan')
+        self.settled_sq_error = 0.0
+        self.settled_samples = 0
+        self.max_z = -float('inf')
+        self.max_tilt = 0.0
+        self.max_drift = 0.0
+        self.airborne = False
+        self.crashed = False
+
+        self.control_pub = rospy.Publisher(vehicle + '_control_stamped', TwistStamped,
+                                           queue_size=1, latch=True)
+        self.pose_sub = rospy.Subscriber(vehicle + '_pose', Pose, self.pose_callback)
+
+    def pose_callback(self, pose):
+        if self.done:
+            return
+        now = rospy.get_rostime().to_sec()
+        if self.start_time is None:
+            self.start_time = now
+        elapsed = now - self.start_time
+        if elapsed >= self.duration:
+            self.done = True
+            return
+
+        self.record(pose, elapsed)
+
+    def start(self):
+        """Send the setpoint of the whole flight, then unpause gazebo"""
+        while self.control_pub.get_num_connections() == 0 and not rospy.is_shutdown():
+            # wall time, the sim clock does not run while paused
+            time.sleep(0.01)
+        setpoint = TwistStamped()
+        # sim time 0, gazebo is paused there, the hold applies it on the first step
+        setpoint.header.stamp = rospy.Time(0)
+        setpoint.twist.linear.x = self.start_x
+        setpoint.twist.linear.y = self.start_y
+        setpoint.twist.linear.z = self.target_height
+        setpoint.twist.angular.z = self.start_yaw
+        self.control_pub.publish(setpoint)
+        rospy.wait_for_service('gazebo/unpause_physics')
+        rospy.ServiceProxy('gazebo/unpause_physics', Empty)()
+
+    def record(self, pose, elapsed):
+        self.samples += 1
+        self.last_pose = pose
+
+        quaternion_list = [pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w]
+        roll, pitch, _ = tf.transformations.euler_from_quaternion(quaternion_list)
+        tilt = math.sqrt(roll * roll + pitch * pitch)
+        drift = math.hypot(pose.position.x - self.start_x, pose.position.y - self.start_y)
+        err = self.target_height - pose.position.z
+
+        self.max_z = max(self.max_z, pose.position.z)
+        self.max_tilt = max(self.max_tilt, tilt)
+        self.max_drift = max(self.max_drift, drift)
+
+        if pose.position.z > AIRBORNE_HEIGHT:
+            self.airborne = True
+        if tilt > CRASH_TILT or (self.airborne and pose.position.z < CRASH_HEIGHT):
+            self.crashed = True
+
+        if math.isnan(self.settle_time) and abs(err) < SETTLED_ERROR:
+            self.settle_time = elapsed
+        if not math.isnan(self.settle_time):
+            self.settled_sq_error += err * err
+            self.settled_samples += 1
+
+    def metrics(self):
+        nan = float('nan')
+        pose = self.last_pose
+        alt_rms = nan
+        if self.settled_samples > 0:
+            alt_rms = math.sqrt(self.settled_sq_error / self.settled_samples)
+        return {
+            'samples': self.samples,
+            'final_x': pose.position.x if pose else nan,
+            'final_y': pose.position.y if pose else nan,
+            'final_z': pose.position.z if pose else nan,
+            'settle_time': self.settle_time,
+            'alt_rms': alt_rms,
+            'max_z': self.max_z if pose else nan,
+            'max_tilt': self.max_tilt,
+            'max_drift': self.max_drift,
+            'crashed': 1 if self.crashed else 0,
+        }
+
+
+if __name__ == "__main__":
+    rospy.init_node('batch_metrics')
+    vehicle = rospy.get_param('~vehicle', 'iris0')
+    duration = float(rospy.get_param('~duration', 30.0))
+    start_x = float(rospy.get_param('~start_x', 0.0))
+    start_y = float(rospy.get_param('~start_y', 0.0))
+    start_yaw = float(rospy.get_param('~start_yaw', 0.0))
+    target_height = float(rospy.get_param('~target_height', 20.0))
+    out = rospy.get_param('~out')
+
+    batch = BatchMetrics(vehicle, duration, start_x, start_y, start_yaw, target_height)
+    batch.start()
+    rate = rospy.Rate(10)
+    while not rospy.is_shutdown() and not batch.done:
+        rate.sleep()
+
+    with open(out, 'w') as f:
+        json.dump(batch.metrics(), f)
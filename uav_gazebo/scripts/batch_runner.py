@@ -0,0 +1,354 @@
+#!/usr/bin/env python
+"""Headless batch runner for parallel monte carlo flights.
+
+Runs every scenario of a json spec in its own headless gzserver, --jobs at
+a time. Each job slot has its own ROS master port, GAZEBO_MASTER_URI and
+ROS namespace, so the slots never see each other. The metrics written by
+batch_metrics.py are collected into one columnar result file.
+
+The iris controller of every run is switched to lockstep with its onboard
+position hold, so the flight is set by the scenario alone and not by how
+fast the ROS side keeps up with a gzserver running unthrottled.
+
+  rosrun uav_gazebo batch_runner.py $(rospack find uav_gazebo)/config/iris_hover_batch.json \\
+      --jobs 8 --out hover.col
+  rosrun uav_gazebo batch_runner.py --read hover.col
+
+Spec, see config/iris_hover_batch.json:
+  world          world file, relative to the uav_gazebo package
+  model          model of the vehicle, copied for every run
+  vehicle        name of the vehicle in the world, prefix of its topics
+  runs, seed     number of scenarios and seed of their parameters
+  duration       sim seconds of each run
+  physics_profile  <physics> profile of the world to run, its default if not
+                 given, --profile overrides it
+  parameters     name: value, or name: [min, max] drawn uniformly per run.
+                 Names of <rotor> elements (vel_p_gain, ...) set every rotor,
+                 wind_x/y/z the world wind, x/y/z/yaw the initial pose.
+
+Result file, all little endian:
+  8 bytes magic 'SRHCOL1\\0', uint32 column count, uint64 row count,
+  per column uint16 name length, name, 1 byte type 'd' float64 or 'q' int64,
+  then the values of each column one after another.
+"""
+from __future__ import print_function
+
+import argparse
+import json
+import multiprocessing
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import xml.etree.ElementTree as ET
+
+MAGIC = b'SRHCOL1\0'
+POSE_PARAMS = ('x', 'y', 'z', 'yaw')
+WIND_PARAMS = ('wind_x', 'wind_y', 'wind_z')
+METRICS = ('samples', 'final_x', 'final_y', 'final_z', 'settle_time', 'alt_rms',
+           'max_z', 'max_tilt', 'max_drift', 'crashed')
+INT_METRICS = ('samples', 'crashed')
+# run status column
+STATUS_OK = 0
+STATUS_FAILED = 1
+STATUS_TIMEOUT = 2
+
+
+def package_path(package):
+    import rospkg
+    return rospkg.RosPack().get_path(package)
+
+
+def make_scenarios(spec):
+    rng = random.Random(spec.get('seed', 0))
+    names = sorted(spec.get('parameters', {}))
+    scenarios = []
+    for run in range(int(spec.get('runs', 1))):
+        scenario = {'run': run}
+        for name in names:
+            value = spec['parameters'][name]
+            if isinstance(value, list):
+                value = rng.uniform(value[0], value[1])
+            scenario[name] = float(value)
+        scenarios.append(scenario)
+    return names, scenarios
+
+
+def set_lockstep_hold(model):
+    """Run the iris controller in lockstep with its onboard position hold,
+    batch_metrics.py then flies it with one stamped setpoint"""
+    for plugin in model.iter('plugin'):
+        if plugin.get('filename') != 'libiris_controller.so':
+            continue
+        lockstep = plugin.find('lockstep')
+        if lockstep is None:
+            lockstep = ET.SubElement(plugin, 'lockstep')
+        lockstep.text = 'true'
+        if plugin.find('positionHold') is None:
+            ET.SubElement(plugin, 'positionHold')
+        return
+    raise RuntimeError('model has no iris_controller plugin')
+
+
+def write_model(src_dir, dst_dir, scenario):
+    """Copy the model, set rotor parameters and let the wind act on it"""
+    shutil.copytree(src_dir, dst_dir)
+    sdf_path = os.path.join(dst_dir, 'model.sdf')
+    tree = ET.parse(sdf_path)
+    model = tree.getroot().find('model')
+    set_lockstep_hold(model)
+    for rotor in model.iter('rotor'):
+        for child in rotor:
+            if child.tag in scenario:
+                child.text = repr(scenario[child.tag])
+    if any(name in scenario for name in WIND_PARAMS):
+        wind = model.find('enable_wind')
+        if wind is None:
+            wind = ET.SubElement(model, 'enable_wind')
+        wind.text = 'true'
+    tree.write(sdf_path)
+
+
+def find_physics(world, profile):
+    """The <physics> named profile, the default one if profile is None"""
+    elements = world.findall('physics')
+    if profile is None:
+        for physics in elements:
+            if physics.get('default', '0') in ('1', 'true'):
+                return physics
+        return elements[0]
+    for physics in elements:
+        if physics.get('name') == profile:
+            return physics
+    raise RuntimeError('world has no physics profile %s' % profile)
+
+
+def write_world(src_world, dst_world, model, model_uri, scenario, spec):
+    """Returns the start pose of the vehicle, x y z roll pitch yaw"""
+    tree = ET.parse(src_world)
+    world = tree.getroot().find('world')
+
+    physics = find_physics(world, spec.get('physics_profile'))
+    rtur = physics.find('real_time_update_rate')
+    if rtur is None:
+        rtur = ET.SubElement(physics, 'real_time_update_rate')
+    # 0 runs as fast as possible
+    rtur.text = str(spec.get('real_time_update_rate', 0))
+
+    if any(name in scenario for name in WIND_PARAMS):
+        wind = world.find('wind')
+        if wind is None:
+            wind = ET.SubElement(world, 'wind')
+        velocity = wind.find('linear_velocity')
+        if velocity is None:
+            velocity = ET.SubElement(wind, 'linear_velocity')
+        velocity.text = '%r %r %r' % tuple(scenario.get(name, 0.0) for name in WIND_PARAMS)
+
+    start = None
+    for include in world.iter('include'):
+        uri = include.find('uri')
+        if uri is None or uri.text.strip() != 'model://' + model:
+            continue
+        uri.text = model_uri
+        pose = include.find('pose')
+        if pose is None:
+            pose = ET.SubElement(include, 'pose')
+        values = [float(v) for v in pose.text.split()] if pose.text else [0.0] * 6
+        values[0] = scenario.get('x', values[0])
+        values[1] = scenario.get('y', values[1])
+        values[2] = scenario.get('z', values[2])
+        values[5] = scenario.get('yaw', values[5])
+        pose.text = ' '.join(repr(v) for v in values)
+        start = values
+    if start is None:
+        raise RuntimeError('world %s does not include model://%s' % (src_world, model))
+    tree.write(dst_world)
+    return start
+
+
+def run_scenario(slot, scenario, spec, args):
+    run = scenario['run']
+    run_dir = os.path.join(args.work_dir, 'run%05d' % run)
+    models_dir = os.path.join(run_dir, 'models')
+    os.makedirs(models_dir)
+
+    model = spec['model']
+    run_model = '%s_run%05d' % (model, run)
+    src_model = os.path.join(package_path(spec.get('model_package', 'uav_description')),
+                             'gazebo_models', model)
+    write_model(src_model, os.path.join(models_dir, run_model), scenario)
+    world = os.path.join(run_dir, 'scenario.world')
+    start = write_world(os.path.join(package_path('uav_gazebo'), spec['world']), world,
+                        model, 'model://' + run_model, scenario, spec)
+
+    ros_port = args.ros_port_base + slot
+    env = dict(os.environ)
+    env['ROS_MASTER_URI'] = 'http://localhost:%d' % ros_port
+    env['GAZEBO_MASTER_URI'] = 'http://localhost:%d' % (args.gazebo_port_base + slot)
+    env['GAZEBO_MODEL_PATH'] = models_dir + os.pathsep + env.get('GAZEBO_MODEL_PATH', '')
+    env['ROS_LOG_DIR'] = os.path.join(run_dir, 'log')
+
+    out = os.path.join(run_dir, 'metrics.json')
+    duration = float(spec.get('duration', 30))
+    cmd = ['roslaunch', '-p', str(ros_port), 'uav_gazebo', 'batch_instance.launch',
+           'world_name:=' + world,
+           'ns:=run%d' % slot,
+           'vehicle:=' + spec.get('vehicle', 'iris0'),
+           'duration:=%r' % duration,
+           'target_height:=%r' % float(spec.get('target_height', 20)),
+           'start_x:=%r' % start[0],
+           'start_y:=%r' % start[1],
+           'start_yaw:=%r' % start[5],
+           'out:=' + out]
+    profile = find_physics(ET.parse(world).getroot().find('world'), spec.get('physics_profile'))
+    if profile.get('name'):
+        cmd.append('physics_profile:=' + profile.get('name'))
+    timeout = float(spec.get('timeout', max(120.0, duration * 10)))
+
+    status = STATUS_OK
+    with open(os.path.join(run_dir, 'launch.log'), 'w') as log:
+        proc = subprocess.Popen(cmd, env=env, stdout=log, stderr=subprocess.STDOUT)
+        start = time.time()
+        while proc.poll() is None:
+            if time.time() - start > timeout:
+                status = STATUS_TIMEOUT
+                proc.terminate()
+                proc.wait()
+                break
+            time.sleep(0.5)
+
+    metrics = {}
+    if os.path.exists(out):
+        with open(out) as f:
+            metrics = json.load(f)
+    elif status == STATUS_OK:
+        status = STATUS_FAILED
+    if not args.keep and status == STATUS_OK:
+        shutil.rmtree(run_dir, ignore_errors=True)
+    return status, metrics
+
+
+def write_results(path, columns):
+    """columns is a list of (name, type, values), type 'd' or 'q'"""
+    rows = len(columns[0][2]) if columns else 0
+    with open(path, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('<IQ', len(columns), rows))
+        for name, kind, values in columns:
+            encoded = name.encode('utf-8')
+            f.write(struct.pack('<H', len(encoded)))
+            f.write(encoded)
+            f.write(kind.encode('ascii'))
+        for name, kind, values in columns:
+            f.write(struct.pack('<%d%s' % (rows, kind), *values))
+
+
+def read_results(path):
+    """Returns a list of (name, values) in file order"""
+    with open(path, 'rb') as f:
+        if f.read(8) != MAGIC:
+            raise ValueError('%s is not a batch result file' % path)
+        count, rows = struct.unpack('<IQ', f.read(12))
+        header = []
+        for _ in range(count):
+            length, = struct.unpack('<H', f.read(2))
+            name = f.read(length).decode('utf-8')
+            kind = f.read(1).decode('ascii')
+            header.append((name, kind))
+        columns = []
+        for name, kind in header:
+            values = struct.unpack('<%d%s' % (rows, kind), f.read(8 * rows))
+            columns.append((name, list(values)))
+    return columns
+
+
+def print_results(path):
+    columns = read_results(path)
+    print(','.join(name for name, _ in columns))
+    rows = len(columns[0][1]) if columns else 0
+    for i in range(rows):
+        print(','.join(str(values[i]) for _, values in columns))
+
+
+def run_batch(spec, args):
+    names, scenarios = make_scenarios(spec)
+    results = [None] * len(scenarios)
+    pending = list(reversed(scenarios))
+    lock = threading.Lock()
+
+    def worker(slot):
+        while True:
+            with lock:
+                if not pending:
+                    return
+                scenario = pending.pop()
+            try:
+                result = run_scenario(slot, scenario, spec, args)
+            except Exception as e:
+                print('run %d failed: %s' % (scenario['run'], e), file=sys.stderr)
+                result = (STATUS_FAILED, {})
+            with lock:
+                results[scenario['run']] = result
+                done = sum(1 for r in results if r is not None)
+            print('run %d/%d done, status %d' % (done, len(scenarios), result[0]))
+
+    threads = [threading.Thread(target=worker, args=(slot,)) for slot in range(args.jobs)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    nan = float('nan')
+    columns = [('run', 'q', [s['run'] for s in scenarios]),
+               ('status', 'q', [r[0] for r in results])]
+    for name in names:
+        columns.append((name, 'd', [s[name] for s in scenarios]))
+    for name in METRICS:
+        if name in INT_METRICS:
+            columns.append((name, 'q', [int(r[1].get(name, -1)) for r in results]))
+        else:
+            columns.append((name, 'd', [float(r[1].get(name, nan)) for r in results]))
+    write_results(args.out, columns)
+    failed = sum(1 for r in results if r[0] != STATUS_OK)
+    print('%d runs, %d failed, results in %s' % (len(results), failed, args.out))
+    return 0 if failed == 0 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description='run batch flight scenarios in headless gzservers')
+    parser.add_argument('spec', nargs='?', help='json scenario spec')
+    parser.add_argument('--jobs', type=int, default=max(1, multiprocessing.cpu_count() // 2),
+                        help='gzserver instances at a time')
+    parser.add_argument('--out', default='batch.col', help='columnar result file')
+    parser.add_argument('--work-dir', help='directory of the generated worlds and logs')
+    parser.add_argument('--keep', action='store_true', help='keep the files of successful runs')
+    parser.add_argument('--ros-port-base', type=int, default=11411)
+    parser.add_argument('--gazebo-port-base', type=int, default=11445)
+    parser.add_argument('--profile', help='physics profile of the world, overrides the spec')
+    parser.add_argument('--read', metavar='FILE', help='print a result file as csv and exit')
+    args = parser.parse_args()
+
+    if args.read:
+        print_results(args.read)
+        return 0
+    if not args.spec:
+        parser.error('a spec is needed')
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+    if args.profile:
+        spec['physics_profile'] = args.profile
+    if args.work_dir is None:
+        args.work_dir = tempfile.mkdtemp(prefix='suruiha_batch_')
+    elif not os.path.isdir(args.work_dir):
+        os.makedirs(args.work_dir)
+    return run_batch(spec, args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
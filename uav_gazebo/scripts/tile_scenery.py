@@ -0,0 +1,197 @@
+#!/usr/bin/env python
+"""Merge the repeated static props of a world into grid tiles.
+
+Every <include> of one of the --models of the world is removed, the props
+are grouped into --tile metre square tiles and every tile becomes one static
+model with a single link that holds the collisions and visuals of all of its
+props. The tile models are put into the sdf of a SceneryTiles world plugin,
+which inserts a tile when a vehicle comes within --load-radius of it and
+removes it again beyond --unload-radius.
+
+  rosrun uav_gazebo tile_scenery.py $(rospack find uav_gazebo)/worlds/simple_city.world \\
+      $(rospack find uav_gazebo)/worlds/simple_city_tiled.world
+  roslaunch uav_gazebo zephyr_city.launch \\
+      world_name:=$(rospack find uav_gazebo)/worlds/simple_city_tiled.world
+
+The props are read from their model.sdf, looked up in GAZEBO_MODEL_PATH and
+~/.gazebo/models; gazebo downloads the ones of simple_city.world the first
+time it loads that world. A prop whose model is not found is kept as a nested
+<include> of its tile, a tile still, but without merged collisions.
+"""
+from __future__ import print_function
+
+import argparse
+import math
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+DEFAULT_MODELS = ('pine_tree', 'oak_tree', 'telephone_pole')
+PLUGIN_NAME = 'scenery_tiles'
+PLUGIN_FILE = 'libscenery_tiles.so'
+
+
+def parse_pose(text):
+    values = [float(v) for v in (text or '').split()]
+    return (values + [0.0] * 6)[:6]
+
+
+def format_pose(pose):
+    return ' '.join('%.6g' % v for v in pose)
+
+
+def rotation(roll, pitch, yaw):
+    cr, sr = math.cos(roll), math.sin(roll)
+    cp, sp = math.cos(pitch), math.sin(pitch)
+    cy, sy = math.cos(yaw), math.sin(yaw)
+    return [[cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+            [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+            [-sp, cp * sr, cp * cr]]
+
+
+def compose(parent, child):
+    """Pose of child, given relative to parent, in the frame parent is given in"""
+    r = rotation(*parent[3:])
+    c = rotation(*child[3:])
+    pos = [parent[i] + sum(r[i][j] * child[j] for j in range(3)) for i in range(3)]
+    m = [[sum(r[i][k] * c[k][j] for k in range(3)) for j in range(3)] for i in range(3)]
+    pitch = math.asin(max(-1.0, min(1.0, -m[2][0])))
+    if abs(m[2][0]) < 1.0 - 1e-9:
+        roll = math.atan2(m[2][1], m[2][2])
+        yaw = math.atan2(m[1][0], m[0][0])
+    else:
+        roll = 0.0
+        yaw = math.atan2(-m[0][1], m[1][1])
+    return pos + [roll, pitch, yaw]
+
+
+def model_paths():
+    paths = [p for p in os.environ.get('GAZEBO_MODEL_PATH', '').split(os.pathsep) if p]
+    paths.append(os.path.join(os.path.expanduser('~'), '.gazebo', 'models'))
+    return paths
+
+
+def find_model_sdf(name):
+    for path in model_paths():
+        directory = os.path.join(path, name)
+        config = os.path.join(directory, 'model.config')
+        if not os.path.isfile(config):
+            continue
+        # model.config names the sdf file, newest sdf version last
+        sdf = None
+        for element in ET.parse(config).getroot().findall('sdf'):
+            sdf = element.text.strip()
+        sdf = os.path.join(directory, sdf or 'model.sdf')
+        if os.path.isfile(sdf):
+            return sdf
+    return None
+
+
+class Prop(object):
+    """collisions and visuals of one model, relative to the model frame"""
+
+    def __init__(self, sdf_file):
+        model = ET.parse(sdf_file).getroot().find('model')
+        self.elements = []
+        for link in model.findall('link'):
+            link_pose = parse_pose(link.findtext('pose'))
+            for element in link:
+                if element.tag not in ('collision', 'visual'):
+                    continue
+                self.elements.append((element, compose(link_pose, parse_pose(element.findtext('pose')))))
+
+
+class Tile(object):
+
+    def __init__(self, ix, iy, size):
+        self.name = 'scenery_tile_%d_%d' % (ix, iy)
+        self.center = ((ix + 0.5) * size, (iy + 0.5) * size)
+        self.model = ET.Element('model', name=self.name)
+        ET.SubElement(self.model, 'static').text = 'true'
+        ET.SubElement(self.model, 'pose').text = format_pose([0.0] * 6)
+        self.link = ET.SubElement(self.model, 'link', name='link')
+        self.props = 0
+
+    def add(self, name, uri, pose, prop):
+        self.props += 1
+        if prop is None:
+            include = ET.SubElement(self.model, 'include')
+            ET.SubElement(include, 'name').text = name
+            ET.SubElement(include, 'uri').text = uri
+            ET.SubElement(include, 'pose').text = format_pose(pose)
+            return
+        for element, element_pose in prop.elements:
+            merged = ET.fromstring(ET.tostring(element))
+            merged.set('name', '%s_%s' % (name, element.get('name')))
+            pose_element = merged.find('pose')
+            if pose_element is None:
+                pose_element = ET.SubElement(merged, 'pose')
+            pose_element.text = format_pose(compose(pose, element_pose))
+            self.link.append(merged)
+
+
+def tile_world(world_file, out_file, models, size, load_radius, unload_radius):
+    tree = ET.parse(world_file)
+    world = tree.getroot().find('world')
+    props = {}
+    tiles = {}
+    removed = []
+    for include in world.findall('include'):
+        uri = (include.findtext('uri') or '').strip()
+        if not uri.startswith('model://'):
+            continue
+        model = uri[len('model://'):].strip('/')
+        if model not in models:
+            continue
+        if model not in props:
+            sdf = find_model_sdf(model)
+            if sdf is None:
+                print('model %s not found, its props are included as they are' % model,
+                      file=sys.stderr)
+            props[model] = Prop(sdf) if sdf else None
+
+        pose = parse_pose(include.findtext('pose'))
+        key = (int(math.floor(pose[0] / size)), int(math.floor(pose[1] / size)))
+        if key not in tiles:
+            tiles[key] = Tile(key[0], key[1], size)
+        name = (include.findtext('name') or '%s_%d' % (model, len(removed))).strip()
+        tiles[key].add(name, uri, pose, props[model])
+        world.remove(include)
+        removed.append(name)
+
+    plugin = ET.SubElement(world, 'plugin', name=PLUGIN_NAME, filename=PLUGIN_FILE)
+    ET.SubElement(plugin, 'loadRadius').text = str(load_radius)
+    ET.SubElement(plugin, 'unloadRadius').text = str(unload_radius)
+    for key in sorted(tiles):
+        tile = tiles[key]
+        element = ET.SubElement(plugin, 'tile')
+        ET.SubElement(element, 'center').text = '%g %g' % tile.center
+        ET.SubElement(element, 'size').text = '%g' % size
+        if not len(tile.link):
+            tile.model.remove(tile.link)
+        element.append(tile.model)
+
+    tree.write(out_file)
+    print('%d props of %s merged into %d tiles' % (len(removed), ', '.join(sorted(models)), len(tiles)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('world', help='world file to read')
+    parser.add_argument('out', help='tiled world file to write')
+    parser.add_argument('--models', default=','.join(DEFAULT_MODELS),
+                        help='comma separated models to merge, default %(default)s')
+    parser.add_argument('--tile', type=float, default=50.0, help='tile edge in metres')
+    parser.add_argument('--load-radius', type=float, default=150.0,
+                        help='distance of a vehicle to a tile that loads it')
+    parser.add_argument('--unload-radius', type=float, default=200.0,
+                        help='distance of every vehicle to a tile that unloads it')
+    args = parser.parse_args()
+    if args.tile <= 0.0 or args.unload_radius < args.load_radius:
+        parser.error('the tile edge must be positive and --unload-radius at least --load-radius')
+    tile_world(args.world, args.out, set(m for m in args.models.split(',') if m),
+               args.tile, args.load_radius, args.unload_radius)
+
+
+if __name__ == '__main__':
+    main()
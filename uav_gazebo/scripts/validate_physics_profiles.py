@@ -0,0 +1,126 @@
+#!/usr/bin/env python
+"""Check that the controllers stay stable under every physics profile.
+
+Runs the scenarios of a batch_runner.py spec once per <physics> profile of
+its world and compares the flights of each profile with those of the
+reference profile, fidelity unless --reference names another. A profile
+passes when none of its runs fails or crashes, its hovers stay within
+--max-alt-rms and --max-tilt, and every run ends within --max-final-error
+of the same run under the reference profile. batch_runner.py flies the
+runs in lockstep, so that error is down to the physics of the profiles and
+not to how fast each gzserver happened to run.
+
+  rosrun uav_gazebo validate_physics_profiles.py \\
+      $(rospack find uav_gazebo)/config/iris_hover_batch.json --runs 8 --jobs 8
+
+The simulated seconds per wall second of every profile are printed with
+the result, the speed up of a profile over real time.
+"""
+from __future__ import print_function
+
+import argparse
+import copy
+import json
+import math
+import os
+import sys
+import tempfile
+import time
+import xml.etree.ElementTree as ET
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import batch_runner  # noqa: E402
+
+
+def profiles(world_file):
+    world = ET.parse(world_file).getroot().find('world')
+    return [p.get('name') for p in world.findall('physics') if p.get('name')]
+
+
+def run_profile(spec, profile, args):
+    spec = copy.deepcopy(spec)
+    spec['physics_profile'] = profile
+    if args.runs:
+        spec['runs'] = args.runs
+    run_args = copy.copy(args)
+    run_args.out = os.path.join(args.work_dir, '%s.col' % profile)
+    run_args.work_dir = os.path.join(args.work_dir, profile)
+    run_args.keep = False
+    start = time.time()
+    batch_runner.run_batch(spec, run_args)
+    wall = time.time() - start
+    columns = dict(batch_runner.read_results(run_args.out))
+    sim = float(spec.get('duration', 30)) * len(columns['run'])
+    return columns, sim / wall if wall > 0 else float('inf')
+
+
+def check(columns, reference, args):
+    """Reasons the profile fails, empty if it passes"""
+    problems = []
+    for i, run in enumerate(columns['run']):
+        if columns['status'][i] != batch_runner.STATUS_OK:
+            problems.append('run %d did not finish, status %d' % (run, columns['status'][i]))
+            continue
+        if columns['crashed'][i]:
+            problems.append('run %d crashed' % run)
+        if not columns['alt_rms'][i] <= args.max_alt_rms:
+            problems.append('run %d altitude rms %.3f m' % (run, columns['alt_rms'][i]))
+        if not columns['max_tilt'][i] <= args.max_tilt:
+            problems.append('run %d tilt %.3f rad' % (run, columns['max_tilt'][i]))
+        if reference is None or reference['status'][i] != batch_runner.STATUS_OK:
+            continue
+        error = math.sqrt(sum((columns[name][i] - reference[name][i]) ** 2
+                              for name in ('final_x', 'final_y', 'final_z')))
+        if not error <= args.max_final_error:
+            problems.append('run %d ends %.3f m from the reference' % (run, error))
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('spec', help='json scenario spec of batch_runner.py')
+    parser.add_argument('--profiles', help='comma separated profiles, every profile of the world by default')
+    parser.add_argument('--reference', default='fidelity', help='profile the others are compared with')
+    parser.add_argument('--runs', type=int, help='scenarios per profile, the runs of the spec by default')
+    parser.add_argument('--max-alt-rms', type=float, default=1.0, help='settled altitude rms, metres')
+    parser.add_argument('--max-tilt', type=float, default=0.6, help='tilt, radians')
+    parser.add_argument('--max-final-error', type=float, default=1.0,
+                        help='distance of the final position to the reference run, metres')
+    parser.add_argument('--jobs', type=int, default=1, help='gzserver instances at a time')
+    parser.add_argument('--work-dir', help='directory of the generated worlds and results')
+    parser.add_argument('--ros-port-base', type=int, default=11411)
+    parser.add_argument('--gazebo-port-base', type=int, default=11445)
+    args = parser.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+    if args.work_dir is None:
+        args.work_dir = tempfile.mkdtemp(prefix='suruiha_profiles_')
+    elif not os.path.isdir(args.work_dir):
+        os.makedirs(args.work_dir)
+
+    names = args.profiles.split(',') if args.profiles else \
+        profiles(os.path.join(batch_runner.package_path('uav_gazebo'), spec['world']))
+    if args.reference in names:
+        names.remove(args.reference)
+        names.insert(0, args.reference)
+    else:
+        print('reference profile %s is not validated, final positions are not compared'
+              % args.reference, file=sys.stderr)
+
+    reference = None
+    failed = 0
+    for name in names:
+        columns, speed = run_profile(spec, name, args)
+        if name == args.reference:
+            reference = columns
+        problems = check(columns, None if name == args.reference else reference, args)
+        print('%-12s %s, %.1fx real time' % (name, 'failed' if problems else 'passed', speed))
+        for problem in problems:
+            print('  ' + problem)
+        failed += 1 if problems else 0
+    return 0 if failed == 0 else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,133 @@
+/**
+ *  \desc   Latency of a control message from publish to callback.
+ *
+ *  ~mode intra    publisher and subscriber in one process, the message is
+ *                 handed over as a shared pointer like GroundControlPlugin does
+ *  ~mode send     publisher only, run a ~mode receive node next to it to
+ *                 measure the TCPROS loopback path the scripts and the
+ *                 uav_ground_control node use
+ *  ~mode receive  subscriber only
+ *
+ *  ~rate (400) messages per second, ~count (4000) messages to measure,
+ *  ~tcp_nodelay (false) subscribe with TCP_NODELAY
+ *  launch/control_latency_bench.launch starts both setups.
+ */
+
+#include <ros/ros.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* TOPIC = "latency_bench_control";
+
+class LatencyReceiver {
+public: LatencyReceiver(ros::NodeHandle& _node, int _count, bool _tcpNoDelay) : count(_count) {
+	latencies.reserve(count);
+	ros::TransportHints hints;
+	if (_tcpNoDelay) {
+		hints = hints.tcpNoDelay();
+	}
+	sub = _node.subscribe(TOPIC, 100, &LatencyReceiver::callback, this, hints);
+}
+
+public: bool done() const {
+	return latencies.size() >= static_cast<size_t>(count);
+}
+
+public: void report(const std::string& _name) {
+	if (latencies.empty()) {
+		ROS_WARN("%s: no message received", _name.c_str());
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0;
+	for (size_t i = 0; i < latencies.size(); i++) {
+		sum += latencies[i];
+	}
+	ROS_INFO("%s: %zu messages, latency us mean:%.1f p50:%.1f p99:%.1f max:%.1f",
+			_name.c_str(), latencies.size(), sum / latencies.size(),
+			latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+			latencies.back());
+}
+
+private: void callback(const geometry_msgs::TwistStamped::ConstPtr& _msg) {
+	if (done()) {
+		return;
+	}
+	// the stamp carries the wall time of the publish
+	ros::WallTime now = ros::WallTime::now();
+	double sent = _msg->header.stamp.sec + _msg->header.stamp.nsec * 1e-9;
+	latencies.push_back((now.toSec() - sent) * 1e6);
+}
+
+private: int count;
+private: std::vector<double> latencies;
+private: ros::Subscriber sub;
+};
+
+void send(ros::NodeHandle& _node, int _rate, const LatencyReceiver* _receiver) {
+	ros::Publisher pub = _node.advertise<geometry_msgs::TwistStamped>(TOPIC, 100);
+
+	// wait for the subscriber so that no message is lost at start
+	while (ros::ok() && pub.getNumSubscribers() == 0) {
+		ros::WallDuration(0.01).sleep();
+	}
+
+	ros::WallRate rate(_rate);
+	while (ros::ok() && (_receiver == nullptr || !_receiver->done())) {
+		// a new message each time, subscribers in this process keep the pointer
+		geometry_msgs::TwistStampedPtr msg(new geometry_msgs::TwistStamped());
+		msg->twist.linear.z = 0.5;
+		ros::WallTime now = ros::WallTime::now();
+		msg->header.stamp.sec = now.sec;
+		msg->header.stamp.nsec = now.nsec;
+		pub.publish(msg);
+		rate.sleep();
+	}
+}
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "control_latency_bench");
+  ros::NodeHandle n;
+
+  std::string mode;
+  int rate;
+  int count;
+  bool tcpNoDelay;
+  ros::NodeHandle private_node_handle_("~");
+  private_node_handle_.param("mode", mode, std::string("intra"));
+  private_node_handle_.param("rate", rate, int(400));
+  private_node_handle_.param("count", count, int(4000));
+  private_node_handle_.param("tcp_nodelay", tcpNoDelay, false);
+
+  if (mode == "send") {
+	  send(n, rate, nullptr);
+	  return 0;
+  }
+
+  if (mode != "intra" && mode != "receive") {
+	  ROS_FATAL("unknown mode %s, use intra, send or receive", mode.c_str());
+	  return 1;
+  }
+
+  LatencyReceiver receiver(n, count, tcpNoDelay);
+  // callbacks run on their own thread as they arrive, like the controller queues
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  if (mode == "intra") {
+	  send(n, rate, &receiver);
+  } else {
+	  while (ros::ok() && !receiver.done()) {
+		  ros::WallDuration(0.1).sleep();
+	  }
+  }
+  spinner.stop();
+  receiver.report(mode == "intra" ? "intra process" : "tcpros loopback");
+  return 0;
+}
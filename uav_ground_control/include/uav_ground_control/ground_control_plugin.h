@@ -0,0 +1,48 @@
+#ifndef GROUND_CONTROL_PLUGIN_H
+#define GROUND_CONTROL_PLUGIN_H
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/physics/physics.hh>
+#include <uav_ground_control/uav_ground_control.h>
+#include <boost/thread.hpp>
+#include <string>
+
+namespace gazebo
+{
+	/// \brief Runs UavGroundControl inside gzserver.
+	/// The controller plugins live in the same process, so roscpp hands the
+	/// control messages to them as shared pointers, with no serialization
+	/// and no loopback socket. Topics are the same as the uav_ground_control node:
+	///   <controlTopic>zephyr_control</controlTopic>
+	///   <poseTopic>zephyr_pose</poseTopic>
+	/// or a fleet, each vehicle on <name>_control and <name>_pose, its poses
+	/// answered on <spinnerThreads> threads (0 for one per vehicle):
+	///   <vehicle>zephyr0</vehicle> <vehicle>iris0</vehicle>
+	///   <spinnerThreads>4</spinnerThreads>
+	/// Motor temperature telemetry for the thermal throttle limit, optional:
+	///   <telemetryTopic>zephyr_telemetry</telemetryTopic>
+	///   <telemetryPort>/dev/ttyUSB0</telemetryPort> <telemetryBaud>115200</telemetryBaud>
+	///   <motorTempSoft>80</motorTempSoft> <motorTempHard>100</motorTempHard>
+	///   <motorMinThrottle>0.5</motorMinThrottle>
+	class GroundControlPlugin : public WorldPlugin
+	{
+		public: GroundControlPlugin();
+		public: virtual ~GroundControlPlugin();
+
+		public: void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+
+		private: void QueueThread();
+
+		private: std::string robot_namespace_;
+		private: ros::NodeHandle* rosnode_;
+		private: UavGroundControl* groundControl_;
+
+		private: ros::CallbackQueue queue_;
+		private: boost::thread callback_queue_thread_;
+	};
+}
+
+#endif
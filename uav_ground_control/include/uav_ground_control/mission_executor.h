@@ -0,0 +1,120 @@
+#ifndef MISSION_EXECUTOR_H
+#define MISSION_EXECUTOR_H
+
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <uav_ground_control/vehicle_type.h>
+#include <uav_ground_control/thermal_limiter.h>
+#include <uav_ground_control/telemetry_link.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <vector>
+
+/// \brief one step of a mission, see MissionExecutor::load
+struct MissionStep {
+	enum Action {
+		/// \brief climb to z, an iris over x y or where it took off
+		TAKEOFF,
+		/// \brief fly to x y z, done within radius of it, iris only
+		WAYPOINT,
+		/// \brief an iris holds x y z, a zephyr circles, for duration
+		/// seconds or to the end of the mission if it is 0
+		LOITER
+	};
+
+	Action action;
+	double x, y, z;
+	/// \brief false to use the position the vehicle took off from
+	bool hasXY;
+	double radius;
+	double duration;
+};
+
+/// \brief Takeoff, waypoint and loiter missions of a fleet, what
+/// scripts/takeoff.py did for iris0 and zephyr0. Every vehicle runs its
+/// steps one after the other. Poses only update the vehicle they belong
+/// to, step computes and publishes the controls of every vehicle at a
+/// fixed rate, each into a message of its own allocated once and published
+/// by reference.
+class MissionExecutor {
+
+public: MissionExecutor(ros::NodeHandle& _node);
+public: virtual ~MissionExecutor();
+
+/// \brief Vehicles and their missions from a parameter list, each entry
+///   {name: iris0, type: iris, steps: [{action: takeoff, z: 20},
+///    {action: waypoint, x: 50, y: 50, z: 20, radius: 2},
+///    {action: loiter, duration: 0}]}
+/// An optional telemetry: iris0_telemetry limits the throttle of the vehicle
+/// by the motor temperatures on that topic, see setThermalLimits.
+/// lockstep: true sends the controls stamped, for a vehicle whose plugin
+/// runs in lockstep mode, see setCommandLead.
+/// \return false if an entry is not valid, nothing is added then
+public: bool load(XmlRpc::XmlRpcValue& _vehicles);
+/// \brief a vehicle on <name>_pose and <name>_control, or
+/// <name>_control_stamped with _lockstep, and its motor temperatures on
+/// _telemetryTopic unless it is empty
+public: void addVehicle(const std::string& _name, VehicleType _type, const std::vector<MissionStep>& _steps,
+		bool _onboardHold = false, const std::string& _telemetryTopic = "", bool _lockstep = false);
+/// \brief Stamp of the lockstep controls, the sim time of the step plus
+/// _lead seconds. A plugin in lockstep mode applies a control on the
+/// physics step of its stamp, so the same mission lands on the same steps
+/// in every run as long as the controls arrive within _lead.
+public: void setCommandLead(double _lead);
+/// \brief limits of the vehicles added afterwards, see ThermalLimiter::configure
+public: void setThermalLimits(double _softLimit, double _hardLimit, double _minScale);
+/// \brief controls of every vehicle with a pose at time _now
+public: void step(const ros::Time& _now);
+public: size_t vehicleCount() const;
+/// \brief vehicles past their last step, a loiter without duration never ends
+public: size_t finishedCount() const;
+
+private: struct Vehicle {
+	std::string name;
+	VehicleType type;
+	/// \brief the control message is a setpoint of the positionHold of the plugin
+	bool onboardHold;
+	std::vector<MissionStep> steps;
+	size_t current;
+	ros::Time stepStart;
+	ros::Subscriber poseSub;
+	ros::Publisher controlPub;
+	geometry_msgs::Twist control;
+	/// \brief control is sent stamped in sim time, see setCommandLead
+	bool lockstep;
+	geometry_msgs::TwistStamped stampedControl;
+
+	/// \brief written by the pose callback, guarded by poseMutex
+	boost::mutex poseMutex;
+	geometry_msgs::Pose pose;
+	/// \brief change of position between the last two poses
+	double speedX, speedY;
+	bool hasPose;
+
+	/// \brief where the first pose put the vehicle
+	double originX, originY;
+	bool hasOrigin;
+
+	/// \brief throttle limit from the motors of this vehicle, null without
+	/// telemetry. The link goes first, it updates the limiter.
+	boost::shared_ptr<ThermalLimiter> thermal;
+	boost::shared_ptr<TelemetryLink> telemetry;
+};
+
+private: void poseCallback(const geometry_msgs::Pose::ConstPtr& _pose, Vehicle* _vehicle);
+/// \brief control of the current step, true once the step is done
+private: bool irisControl(Vehicle& _vehicle, const MissionStep& _step, const geometry_msgs::Pose& _pose,
+		double _speedX, double _speedY);
+private: bool zephyrControl(Vehicle& _vehicle, const MissionStep& _step, const geometry_msgs::Pose& _pose);
+
+private:
+	ros::NodeHandle node;
+	std::vector<boost::shared_ptr<Vehicle> > vehicles;
+	double softLimit, hardLimit, minScale;
+	ros::Duration commandLead;
+};
+
+#endif
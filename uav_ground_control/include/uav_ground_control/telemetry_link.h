@@ -0,0 +1,43 @@
+#ifndef TELEMETRY_LINK_H
+#define TELEMETRY_LINK_H
+
+#include <ros/ros.h>
+#include <std_msgs/UInt8MultiArray.h>
+#include <uav_ground_control/telemetry_protocol.h>
+#include <uav_ground_control/thermal_limiter.h>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <string>
+
+/// \brief Telemetry frames of telemetry_protocol.h, from the MCU over a
+/// serial port or from the motor_temperature_sensor model of the simulation
+/// on a std_msgs/UInt8MultiArray topic. Both streams go through the same
+/// decoder, which works in place and allocates nothing, and their motor
+/// temperatures go to a ThermalLimiter.
+class TelemetryLink {
+
+public: TelemetryLink(ThermalLimiter& _limiter);
+public: virtual ~TelemetryLink();
+/// \brief frames published on _topic, e.g. <model>_telemetry
+public: void subscribe(ros::NodeHandle& _node, const std::string& _topic);
+/// \brief raw 8N1 serial port read by a thread of its own
+public: bool openSerial(const std::string& _port, int _baud);
+public: void close();
+/// \brief decode the next _size bytes of the stream of _decoder
+public: void feed(telemetry_decoder& _decoder, const uint8_t* _data, size_t _size);
+
+private: void telemetryCallback(const std_msgs::UInt8MultiArray::ConstPtr& _frames);
+private: void serialThread();
+
+private:
+	ThermalLimiter& limiter;
+	ros::Subscriber telemetrySub;
+	/// \brief one decoder per stream, the topic callback and the serial thread run at once
+	telemetry_decoder topicDecoder;
+	telemetry_decoder serialDecoder;
+	int serialFd;
+	std::atomic<bool> running;
+	boost::thread serialReader;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * telemetry_protocol.h
+ *
+ *  Serial telemetry of the flight controller MCU. The firmware, the
+ *  motor_temperature sensor model of suruiha_gazebo_plugins and the ground
+ *  control all use this header, it is plain C for the firmware.
+ *
+ *  frame    sync 0xA5 0x5A, payload length, type, sequence number, payload,
+ *           CRC-16/CCITT (0x1021 from 0xFFFF) of length to payload.
+ *           Multi byte fields are little endian.
+ *  TELEMETRY_TEMPERATURE payload, rows of samples of every sensor
+ *           time of the first row in ms, u32
+ *           time between rows in ms, u16
+ *           sensors per row, u8
+ *           rows, u8
+ *           rows * sensors temperatures row after row, s16 in 1/16 degC as
+ *           the DS18B20 reads them, TELEMETRY_TEMPERATURE_INVALID for a
+ *           sensor that could not be read
+ */
+
+#ifndef TELEMETRY_PROTOCOL_H
+#define TELEMETRY_PROTOCOL_H
+
+#include <stdint.h>
+
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0x5A
+#define TELEMETRY_HEADER_SIZE   5
+#define TELEMETRY_CRC_SIZE      2
+#define TELEMETRY_MAX_PAYLOAD   255
+#define TELEMETRY_MAX_FRAME     (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE)
+
+#define TELEMETRY_TEMPERATURE           1
+#define TELEMETRY_TEMPERATURE_HEADER    8
+// rows * sensors of one frame
+#define TELEMETRY_TEMPERATURE_MAX_VALUES ((TELEMETRY_MAX_PAYLOAD - TELEMETRY_TEMPERATURE_HEADER) / 2)
+#define TELEMETRY_TEMPERATURE_INVALID   ((int16_t)-32768)
+
+static inline uint16_t telemetry_crc16(uint16_t _crc, const uint8_t *_data, uint16_t _len)
+{
+    uint8_t i;
+    while (_len--)
+    {
+        _crc ^= (uint16_t)(*_data++) << 8;
+        for (i = 0; i < 8; i++)
+            _crc = (_crc & 0x8000) ? (uint16_t)((_crc << 1) ^ 0x1021) : (uint16_t)(_crc << 1);
+    }
+    return _crc;
+}
+
+static inline void telemetry_put16(uint8_t *_p, uint16_t _value)
+{
+    _p[0] = (uint8_t)_value;
+    _p[1] = (uint8_t)(_value >> 8);
+}
+
+static inline void telemetry_put32(uint8_t *_p, uint32_t _value)
+{
+    telemetry_put16(_p, (uint16_t)_value);
+    telemetry_put16(_p + 2, (uint16_t)(_value >> 16));
+}
+
+static inline uint16_t telemetry_get16(const uint8_t *_p)
+{
+    return (uint16_t)(_p[0] | (_p[1] << 8));
+}
+
+static inline uint32_t telemetry_get32(const uint8_t *_p)
+{
+    return telemetry_get16(_p) | ((uint32_t)telemetry_get16(_p + 2) << 16);
+}
+
+// Header and CRC around the _length payload bytes already at
+// _frame + TELEMETRY_HEADER_SIZE, returns the size of the frame
+static inline uint16_t telemetry_finish_frame(uint8_t *_frame, uint8_t _type, uint8_t _sequence,
+        uint8_t _length)
+{
+    uint16_t crc;
+    _frame[0] = TELEMETRY_SYNC0;
+    _frame[1] = TELEMETRY_SYNC1;
+    _frame[2] = _length;
+    _frame[3] = _type;
+    _frame[4] = _sequence;
+    crc = telemetry_crc16(0xFFFF, _frame + 2, TELEMETRY_HEADER_SIZE - 2 + _length);
+    telemetry_put16(_frame + TELEMETRY_HEADER_SIZE + _length, crc);
+    return TELEMETRY_HEADER_SIZE + _length + TELEMETRY_CRC_SIZE;
+}
+
+// Frame of _rows rows of _sensors temperatures in _frame, which holds
+// TELEMETRY_MAX_FRAME bytes. Returns the size of the frame, 0 if the
+// values do not fit in one.
+static inline uint16_t telemetry_encode_temperatures(uint8_t *_frame, uint8_t _sequence,
+        uint32_t _time_ms, uint16_t _period_ms, uint8_t _sensors, uint8_t _rows,
+        const int16_t *_values)
+{
+    uint8_t *payload = _frame + TELEMETRY_HEADER_SIZE;
+    uint16_t count = (uint16_t)_sensors * _rows, i;
+    if (count > TELEMETRY_TEMPERATURE_MAX_VALUES)
+        return 0;
+    telemetry_put32(payload, _time_ms);
+    telemetry_put16(payload + 4, _period_ms);
+    payload[6] = _sensors;
+    payload[7] = _rows;
+    for (i = 0; i < count; i++)
+        telemetry_put16(payload + TELEMETRY_TEMPERATURE_HEADER + 2 * i, (uint16_t)_values[i]);
+    return telemetry_finish_frame(_frame, TELEMETRY_TEMPERATURE, _sequence,
+            (uint8_t)(TELEMETRY_TEMPERATURE_HEADER + 2 * count));
+}
+
+// Finds the frames in a byte stream, without allocating. A frame with a
+// bad CRC is dropped and the search for the next sync starts after it.
+struct telemetry_decoder
+{
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    uint16_t size;          // bytes of the frame received so far
+    uint8_t sequence;       // of the last frame
+    uint32_t frames;        // frames with a good CRC
+    uint32_t crc_errors;
+    uint32_t lost;          // frames missing between two sequence numbers
+};
+
+static inline void telemetry_decoder_init(struct telemetry_decoder *_decoder)
+{
+    _decoder->size = 0;
+    _decoder->sequence = 0;
+    _decoder->frames = 0;
+    _decoder->crc_errors = 0;
+    _decoder->lost = 0;
+}
+
+// Returns 1 when _byte completes a frame, which stays in
+// _decoder->frame until the next byte is pushed
+static inline int telemetry_decoder_push(struct telemetry_decoder *_decoder, uint8_t _byte)
+{
+    uint16_t length;
+    if (_decoder->size == 0)
+    {
+        if (_byte == TELEMETRY_SYNC0)
+            _decoder->frame[_decoder->size++] = _byte;
+        return 0;
+    }
+    if (_decoder->size == 1)
+    {
+        if (_byte == TELEMETRY_SYNC1)
+            _decoder->frame[_decoder->size++] = _byte;
+        else if (_byte != TELEMETRY_SYNC0)
+            _decoder->size = 0;
+        return 0;
+    }
+    _decoder->frame[_decoder->size++] = _byte;
+    if (_decoder->size < TELEMETRY_HEADER_SIZE)
+        return 0;
+    length = TELEMETRY_HEADER_SIZE + _decoder->frame[2] + TELEMETRY_CRC_SIZE;
+    if (_decoder->size < length)
+        return 0;
+
+    _decoder->size = 0;
+    if (telemetry_crc16(0xFFFF, _decoder->frame + 2, length - TELEMETRY_CRC_SIZE - 2)
+            != telemetry_get16(_decoder->frame + length - TELEMETRY_CRC_SIZE))
+    {
+        _decoder->crc_errors++;
+        return 0;
+    }
+    if (_decoder->frames > 0)
+        _decoder->lost += (uint8_t)(_decoder->frame[4] - _decoder->sequence - 1);
+    _decoder->sequence = _decoder->frame[4];
+    _decoder->frames++;
+    return 1;
+}
+
+static inline uint8_t telemetry_frame_type(const uint8_t *_frame)
+{
+    return _frame[3];
+}
+
+// A TELEMETRY_TEMPERATURE frame, the values stay in the frame
+struct telemetry_temperatures
+{
+    uint32_t time_ms;
+    uint16_t period_ms;
+    uint8_t sensors;
+    uint8_t rows;
+    const uint8_t *values;
+};
+
+// Returns 0 if _frame is not a consistent temperature frame
+static inline int telemetry_decode_temperatures(const uint8_t *_frame,
+        struct telemetry_temperatures *_temperatures)
+{
+    const uint8_t *payload = _frame + TELEMETRY_HEADER_SIZE;
+    if (_frame[3] != TELEMETRY_TEMPERATURE || _frame[2] < TELEMETRY_TEMPERATURE_HEADER)
+        return 0;
+    _temperatures->time_ms = telemetry_get32(payload);
+    _temperatures->period_ms = telemetry_get16(payload + 4);
+    _temperatures->sensors = payload[6];
+    _temperatures->rows = payload[7];
+    _temperatures->values = payload + TELEMETRY_TEMPERATURE_HEADER;
+    return _frame[2] == TELEMETRY_TEMPERATURE_HEADER + 2 * _temperatures->sensors * _temperatures->rows;
+}
+
+// Temperature of _sensor in _row in 1/16 degC
+static inline int16_t telemetry_temperature(const struct telemetry_temperatures *_temperatures,
+        uint8_t _row, uint8_t _sensor)
+{
+    return (int16_t)telemetry_get16(_temperatures->values +
+            2 * ((uint16_t)_row * _temperatures->sensors + _sensor));
+}
+
+#endif
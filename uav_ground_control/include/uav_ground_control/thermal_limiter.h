@@ -0,0 +1,35 @@
+#ifndef THERMAL_LIMITER_H
+#define THERMAL_LIMITER_H
+
+#include <uav_ground_control/telemetry_protocol.h>
+#include <uav_ground_control/vehicle_type.h>
+#include <geometry_msgs/Twist.h>
+#include <atomic>
+
+/// \brief Throttle scale from the motor temperatures of the telemetry.
+/// Full throttle up to the soft limit, then down in a straight line to the
+/// minimum scale at the hard limit and beyond. Sensors that failed are left
+/// out. update and scale may be called from different threads.
+class ThermalLimiter {
+
+public: ThermalLimiter();
+public: void configure(double softLimit, double hardLimit, double minScale);
+/// \brief limit from the hottest motor in the last row of _temperatures
+public: void update(const telemetry_temperatures& _temperatures);
+/// \brief factor for the throttle, 1 until a temperature arrives
+public: double scale() const;
+/// \brief Scale the throttle field of _control for a vehicle of _type,
+/// an iris then sinks and a zephyr slows down
+public: void limit(geometry_msgs::Twist& _control, VehicleType _type) const;
+/// \brief hottest motor of the last update in degC
+public: double hottest() const;
+
+private:
+	double softLimit;
+	double hardLimit;
+	double minScale;
+	std::atomic<float> throttleScale;
+	std::atomic<float> hottestMotor;
+};
+
+#endif
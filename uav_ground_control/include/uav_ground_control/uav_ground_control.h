@@ -1,17 +1,66 @@
+#ifndef UAV_GROUND_CONTROL_H
+#define UAV_GROUND_CONTROL_H
+
 #include <ros/ros.h>
+#include <ros/callback_queue.h>
 #include <geometry_msgs/Pose.h>
+#include <uav_ground_control/telemetry_link.h>
+#include <uav_ground_control/thermal_limiter.h>
+#include <uav_ground_control/vehicle_type.h>
+#include <boost/shared_ptr.hpp>
 #include <string>
+#include <vector>
 
+/// \brief Ground control of a fleet. Every vehicle has its own pose
+/// subscriber, control publisher and throttle limit, and a control of its
+/// type is sent as soon as a pose of the vehicle arrives. Poses are answered by an AsyncSpinner per
+/// callback queue, see start.
 class UavGroundControl {
 
 public: UavGroundControl(ros::NodeHandle& _node);
 public: virtual ~UavGroundControl();
 public: void spinOnce();
-public: void init(std::string controlTopicName, std::string poseTopicName);
-private: void poseCallback(const geometry_msgs::Pose::ConstPtr& pose);
+/// \brief a vehicle of type on the given topics, named after its pose topic
+public: void init(std::string controlTopicName, std::string poseTopicName, VehicleType type);
+/// \brief a vehicle of type on <name>_control and <name>_pose, as the controller plugins name them
+public: void addVehicle(const std::string& name, VehicleType type);
+/// \brief Subscribe to the poses of every vehicle added so far and answer them
+/// on _threads spinner threads, each with a callback queue of its own. A
+/// vehicle stays on one queue, so its callbacks never run at the same time.
+/// 0 threads is one per vehicle, at most one per core.
+public: void start(unsigned threads = 0);
+public: void stop();
+public: size_t vehicleCount() const;
+/// \brief The throttle of every vehicle is scaled down between the soft and
+/// the hard limit in degC of its motors, to minScale at the hard limit.
+public: void setThermalLimits(double softLimit, double hardLimit, double minScale);
+/// \brief motor temperatures of the vehicle vehicleName from a telemetry
+/// topic, a serial port or both, an empty name leaves a source out.
+/// \return false if there is no such vehicle
+public: bool initTelemetry(const std::string& vehicleName, std::string telemetryTopicName,
+		std::string serialPort, int baud);
+
+private: struct Vehicle {
+	std::string name;
+	VehicleType type;
+	std::string poseTopicName;
+	ros::Subscriber poseSub;
+	ros::Publisher controlPub;
+	/// \brief limit from the motors of this vehicle alone, the link goes
+	/// first, it updates the limiter
+	boost::shared_ptr<ThermalLimiter> thermal;
+	boost::shared_ptr<TelemetryLink> telemetry;
+};
+private: void insertVehicle(const std::string& name, const std::string& controlTopicName,
+		const std::string& poseTopicName, VehicleType type);
+private: void poseCallback(const geometry_msgs::Pose::ConstPtr& pose, Vehicle* vehicle);
 
 private:
 	ros::NodeHandle node;
-	std::vector<ros::Subscriber> poseSubs;
-	std::vector<ros::Publisher> controlPubs;
+	std::vector<boost::shared_ptr<Vehicle> > vehicles;
+	std::vector<boost::shared_ptr<ros::CallbackQueue> > queues;
+	std::vector<boost::shared_ptr<ros::AsyncSpinner> > spinners;
+	double softLimit, hardLimit, minScale;
 };
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef VEHICLE_TYPE_H
+#define VEHICLE_TYPE_H
+
+#include <string>
+
+/// \brief Vehicles the controller plugins fly. Their control messages put the
+/// throttle in different fields, linear.z for an iris and linear.x for a zephyr.
+enum VehicleType {
+	IRIS,
+	ZEPHYR
+};
+
+/// \brief iris or zephyr
+/// \return false for any other name, _type is left as is then
+inline bool vehicleTypeFromString(const std::string& _name, VehicleType& _type) {
+	if (_name == "iris") {
+		_type = IRIS;
+		return true;
+	}
+	if (_name == "zephyr") {
+		_type = ZEPHYR;
+		return true;
+	}
+	return false;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ *  \desc   Gazebo World Plugin running the ground control in the gzserver process
+ */
+
+#include <uav_ground_control/ground_control_plugin.h>
+#include <sdf/sdf.hh>
+
+namespace gazebo {
+
+    // Register this plugin with the simulator
+    GZ_REGISTER_WORLD_PLUGIN(GroundControlPlugin);
+
+    GroundControlPlugin::GroundControlPlugin() {
+        rosnode_ = nullptr;
+        groundControl_ = nullptr;
+    }
+
+    GroundControlPlugin::~GroundControlPlugin() {
+        if (this->rosnode_ != nullptr) {
+            this->rosnode_->shutdown();
+            this->queue_.clear();
+            this->queue_.disable();
+            this->callback_queue_thread_.join();
+        }
+        delete groundControl_;
+        delete rosnode_;
+    }
+
+    void GroundControlPlugin::Load(physics::WorldPtr _world, sdf::ElementPtr _sdf) {
+        // Make sure the ROS node for Gazebo has already been initalized
+        if (!ros::isInitialized()) {
+            ROS_FATAL_STREAM_NAMED("template", "A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                    << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+            return;
+        }
+
+        std::string controlTopicName("zephyr_control");
+        std::string poseTopicName("zephyr_pose");
+        if (_sdf->HasElement("robotNamespace")) {
+            this->robot_namespace_ = _sdf->Get<std::string>("robotNamespace");
+        }
+        if (_sdf->HasElement("controlTopic")) {
+            controlTopicName = _sdf->Get<std::string>("controlTopic");
+        }
+        if (_sdf->HasElement("poseTopic")) {
+            poseTopicName = _sdf->Get<std::string>("poseTopic");
+        }
+
+        // every topic of the ground control goes through our own queue
+        this->rosnode_ = new ros::NodeHandle(this->robot_namespace_);
+        this->rosnode_->setCallbackQueue(&this->queue_);
+
+        // motor temperatures, see uav_ground_control_node for the defaults
+        std::string telemetryTopicName, telemetryPort;
+        int telemetryBaud = 115200;
+        double motorTempSoft = 80, motorTempHard = 100, motorMinThrottle = 0.5;
+        if (_sdf->HasElement("telemetryTopic")) {
+            telemetryTopicName = _sdf->Get<std::string>("telemetryTopic");
+        }
+        if (_sdf->HasElement("telemetryPort")) {
+            telemetryPort = _sdf->Get<std::string>("telemetryPort");
+        }
+        if (_sdf->HasElement("telemetryBaud")) {
+            telemetryBaud = _sdf->Get<int>("telemetryBaud");
+        }
+        if (_sdf->HasElement("motorTempSoft")) {
+            motorTempSoft = _sdf->Get<double>("motorTempSoft");
+        }
+        if (_sdf->HasElement("motorTempHard")) {
+            motorTempHard = _sdf->Get<double>("motorTempHard");
+        }
+        if (_sdf->HasElement("motorMinThrottle")) {
+            motorMinThrottle = _sdf->Get<double>("motorMinThrottle");
+        }
+
+        groundControl_ = new UavGroundControl(*this->rosnode_);
+        groundControl_->setThermalLimits(motorTempSoft, motorTempHard, motorMinThrottle);
+        if (_sdf->HasElement("vehicle")) {
+            // <vehicle type="iris" telemetryTopic="iris0_telemetry">iris0</vehicle>, the
+            // telemetry attributes are those of the single vehicle below
+            for (sdf::ElementPtr vehicle = _sdf->GetElement("vehicle"); vehicle;
+                    vehicle = vehicle->GetNextElement("vehicle")) {
+                const std::string name = vehicle->Get<std::string>();
+                VehicleType type;
+                if (!vehicle->HasAttribute("type") ||
+                        !vehicleTypeFromString(vehicle->GetAttribute("type")->GetAsString(), type)) {
+                    ROS_ERROR("ground control: vehicle %s needs a type iris or zephyr, it is not controlled",
+                            name.c_str());
+                    continue;
+                }
+                std::string vehicleTelemetryTopic, vehicleTelemetryPort;
+                int vehicleTelemetryBaud = telemetryBaud;
+                if (vehicle->HasAttribute("telemetryTopic")) {
+                    vehicleTelemetryTopic = vehicle->GetAttribute("telemetryTopic")->GetAsString();
+                }
+                if (vehicle->HasAttribute("telemetryPort")) {
+                    vehicleTelemetryPort = vehicle->GetAttribute("telemetryPort")->GetAsString();
+                }
+                if (vehicle->HasAttribute("telemetryBaud")) {
+                    vehicle->GetAttribute("telemetryBaud")->Get(vehicleTelemetryBaud);
+                }
+                groundControl_->addVehicle(name, type);
+                groundControl_->initTelemetry(name, vehicleTelemetryTopic, vehicleTelemetryPort,
+                        vehicleTelemetryBaud);
+            }
+        } else {
+            VehicleType type = ZEPHYR;
+            if (_sdf->HasElement("vehicleType") &&
+                    !vehicleTypeFromString(_sdf->Get<std::string>("vehicleType"), type)) {
+                ROS_ERROR("ground control: vehicleType is neither iris nor zephyr, a zephyr is controlled");
+                type = ZEPHYR;
+            }
+            groundControl_->init(controlTopicName, poseTopicName, type);
+            groundControl_->initTelemetry(poseTopicName, telemetryTopicName, telemetryPort, telemetryBaud);
+        }
+
+        unsigned spinnerThreads = 0;
+        if (_sdf->HasElement("spinnerThreads")) {
+            spinnerThreads = _sdf->Get<unsigned>("spinnerThreads");
+        }
+        groundControl_->start(spinnerThreads);
+
+        this->callback_queue_thread_ =
+                boost::thread(boost::bind(&GroundControlPlugin::QueueThread, this));
+    }
+
+    void GroundControlPlugin::QueueThread() {
+        static const double timeout = 0.1;
+        while (this->rosnode_->ok()) {
+            groundControl_->spinOnce();
+            this->queue_.callAvailable(ros::WallDuration(timeout));
+        }
+    }
+}
@@ -0,0 +1,320 @@
+#include <uav_ground_control/mission_executor.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// the laws of scripts/takeoff.py
+const double IRIS_BASE_THROTTLE = 430;
+const double IRIS_MAX_THROTTLE = 450;
+const double IRIS_ALTITUDE_GAIN = 10;
+/// \brief horizontal hold starts within this altitude error, meters
+const double IRIS_HOLD_ALTITUDE = 10;
+/// \brief within this distance the iris brakes on its speed instead
+const double IRIS_BRAKE_DISTANCE = 20;
+const double IRIS_TILT_GAIN = 1.0 / 1000;
+const double IRIS_MAX_TILT = 0.01;
+/// \brief altitude error counted as reached, meters
+const double IRIS_SETTLED = 1;
+
+const double ZEPHYR_THROTTLE = 450;
+const double ZEPHYR_CLIMB_PITCH = -0.1;
+const double ZEPHYR_LOITER_BANK = 0.2;
+
+double clamp(double value, double maxValue) {
+	return std::max(-maxValue, std::min(maxValue, value));
+}
+
+bool number(XmlRpc::XmlRpcValue& _value, const char* _name, double& _number) {
+	if (!_value.hasMember(_name)) {
+		return false;
+	}
+	XmlRpc::XmlRpcValue& value = _value[_name];
+	if (value.getType() == XmlRpc::XmlRpcValue::TypeInt) {
+		_number = static_cast<int>(value);
+		return true;
+	}
+	if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+		_number = static_cast<double>(value);
+		return true;
+	}
+	return false;
+}
+
+bool flag(XmlRpc::XmlRpcValue& _value, const char* _name) {
+	return _value.hasMember(_name) && _value[_name].getType() == XmlRpc::XmlRpcValue::TypeBoolean &&
+			static_cast<bool>(_value[_name]);
+}
+
+bool text(XmlRpc::XmlRpcValue& _value, const char* _name, std::string& _text) {
+	if (!_value.hasMember(_name) || _value[_name].getType() != XmlRpc::XmlRpcValue::TypeString) {
+		return false;
+	}
+	_text = static_cast<std::string>(_value[_name]);
+	return true;
+}
+
+}
+
+MissionExecutor::MissionExecutor(ros::NodeHandle& _node) : node(_node), softLimit(80), hardLimit(100),
+		minScale(0.5), commandLead(0.01) {
+
+}
+
+MissionExecutor::~MissionExecutor() {
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		vehicles[i]->poseSub.shutdown();
+	}
+}
+
+bool MissionExecutor::load(XmlRpc::XmlRpcValue& _vehicles) {
+	if (_vehicles.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+		ROS_ERROR("mission: vehicles is not a list");
+		return false;
+	}
+	std::vector<std::string> names;
+	std::vector<VehicleType> types;
+	std::vector<bool> holds;
+	std::vector<std::string> telemetryTopics;
+	std::vector<bool> locksteps;
+	std::vector<std::vector<MissionStep> > missions;
+	for (int i = 0; i < _vehicles.size(); i++) {
+		XmlRpc::XmlRpcValue& entry = _vehicles[i];
+		std::string name, type;
+		VehicleType vehicleType;
+		if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !text(entry, "name", name) ||
+				!text(entry, "type", type) || !vehicleTypeFromString(type, vehicleType) ||
+				!entry.hasMember("steps") || entry["steps"].getType() != XmlRpc::XmlRpcValue::TypeArray) {
+			ROS_ERROR("mission: vehicle %d needs a name, a type iris or zephyr and a list of steps", i);
+			return false;
+		}
+
+		std::vector<MissionStep> steps;
+		XmlRpc::XmlRpcValue& stepList = entry["steps"];
+		for (int s = 0; s < stepList.size(); s++) {
+			XmlRpc::XmlRpcValue& item = stepList[s];
+			std::string action;
+			MissionStep step;
+			step.x = step.y = step.z = 0;
+			step.radius = 2;
+			step.duration = 0;
+			if (item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !text(item, "action", action)) {
+				ROS_ERROR("mission: step %d of %s has no action", s, name.c_str());
+				return false;
+			}
+			const bool hasX = number(item, "x", step.x);
+			const bool hasY = number(item, "y", step.y);
+			const bool hasZ = number(item, "z", step.z);
+			number(item, "radius", step.radius);
+			number(item, "duration", step.duration);
+			step.hasXY = hasX && hasY;
+			if (action == "takeoff" && hasZ) {
+				step.action = MissionStep::TAKEOFF;
+			} else if (action == "waypoint" && step.hasXY && type == "iris") {
+				step.action = MissionStep::WAYPOINT;
+			} else if (action == "loiter") {
+				step.action = MissionStep::LOITER;
+			} else {
+				ROS_ERROR("mission: step %d of %s is not valid, takeoff needs z and waypoint x y on an iris",
+						s, name.c_str());
+				return false;
+			}
+			// a missing altitude is the one of the step before
+			if (!hasZ && !steps.empty()) {
+				step.z = steps.back().z;
+			}
+			steps.push_back(step);
+		}
+		std::string telemetryTopic;
+		text(entry, "telemetry", telemetryTopic);
+		names.push_back(name);
+		types.push_back(vehicleType);
+		holds.push_back(vehicleType == IRIS && flag(entry, "onboard_hold"));
+		telemetryTopics.push_back(telemetryTopic);
+		locksteps.push_back(flag(entry, "lockstep"));
+		missions.push_back(steps);
+	}
+
+	for (size_t i = 0; i < names.size(); i++) {
+		addVehicle(names[i], types[i], missions[i], holds[i], telemetryTopics[i], locksteps[i]);
+	}
+	return true;
+}
+
+void MissionExecutor::setThermalLimits(double _softLimit, double _hardLimit, double _minScale) {
+	softLimit = _softLimit;
+	hardLimit = _hardLimit;
+	minScale = _minScale;
+}
+
+void MissionExecutor::setCommandLead(double _lead) {
+	commandLead = ros::Duration(std::max(_lead, 0.0));
+}
+
+void MissionExecutor::addVehicle(const std::string& _name, VehicleType _type,
+		const std::vector<MissionStep>& _steps, bool _onboardHold, const std::string& _telemetryTopic,
+		bool _lockstep) {
+	boost::shared_ptr<Vehicle> vehicle(new Vehicle());
+	vehicle->name = _name;
+	vehicle->type = _type;
+	vehicle->onboardHold = _onboardHold;
+	vehicle->lockstep = _lockstep;
+	vehicle->steps = _steps;
+	// a step without x y stays over the one before, the first over where the vehicle took off
+	for (size_t i = 1; i < vehicle->steps.size(); i++) {
+		MissionStep& step = vehicle->steps[i];
+		if (!step.hasXY && vehicle->steps[i - 1].hasXY) {
+			step.x = vehicle->steps[i - 1].x;
+			step.y = vehicle->steps[i - 1].y;
+			step.hasXY = true;
+		}
+	}
+	vehicle->current = 0;
+	vehicle->speedX = vehicle->speedY = 0;
+	vehicle->hasPose = false;
+	vehicle->originX = vehicle->originY = 0;
+	vehicle->hasOrigin = false;
+	if (!_telemetryTopic.empty()) {
+		if (_onboardHold) {
+			// a setpoint carries no throttle, the plugin picks it
+			ROS_WARN("mission: %s runs the onboard hold, its throttle is not limited", _name.c_str());
+		} else {
+			vehicle->thermal.reset(new ThermalLimiter());
+			vehicle->thermal->configure(softLimit, hardLimit, minScale);
+			vehicle->telemetry.reset(new TelemetryLink(*vehicle->thermal));
+			vehicle->telemetry->subscribe(node, _telemetryTopic);
+		}
+	}
+
+	if (_lockstep) {
+		// every stamped control is queued by the plugin until its step, none may be dropped
+		vehicle->controlPub = node.advertise<geometry_msgs::TwistStamped>(_name + "_control_stamped", 100);
+	} else {
+		vehicle->controlPub = node.advertise<geometry_msgs::Twist>(_name + "_control", 1);
+	}
+	vehicle->poseSub = node.subscribe<geometry_msgs::Pose>(_name + "_pose", 1,
+			boost::bind(&MissionExecutor::poseCallback, this, _1, vehicle.get()),
+			ros::VoidConstPtr(), ros::TransportHints().tcpNoDelay());
+	vehicles.push_back(vehicle);
+}
+
+void MissionExecutor::poseCallback(const geometry_msgs::Pose::ConstPtr& _pose, Vehicle* _vehicle) {
+	boost::mutex::scoped_lock lock(_vehicle->poseMutex);
+	if (_vehicle->hasPose) {
+		_vehicle->speedX = _vehicle->pose.position.x - _pose->position.x;
+		_vehicle->speedY = _vehicle->pose.position.y - _pose->position.y;
+	}
+	_vehicle->pose = *_pose;
+	_vehicle->hasPose = true;
+}
+
+void MissionExecutor::step(const ros::Time& _now) {
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		Vehicle& vehicle = *vehicles[i];
+		if (vehicle.current >= vehicle.steps.size()) {
+			continue;
+		}
+
+		geometry_msgs::Pose pose;
+		double speedX, speedY;
+		{
+			boost::mutex::scoped_lock lock(vehicle.poseMutex);
+			if (!vehicle.hasPose) {
+				continue;
+			}
+			pose = vehicle.pose;
+			speedX = vehicle.speedX;
+			speedY = vehicle.speedY;
+		}
+		if (!vehicle.hasOrigin) {
+			vehicle.originX = pose.position.x;
+			vehicle.originY = pose.position.y;
+			vehicle.hasOrigin = true;
+			vehicle.stepStart = _now;
+		}
+
+		const MissionStep& step = vehicle.steps[vehicle.current];
+		bool done = vehicle.type == IRIS ? irisControl(vehicle, step, pose, speedX, speedY)
+				: zephyrControl(vehicle, step, pose);
+		if (step.action == MissionStep::LOITER) {
+			done = step.duration > 0 && (_now - vehicle.stepStart).toSec() >= step.duration;
+		}
+		if (vehicle.thermal) {
+			vehicle.thermal->limit(vehicle.control, vehicle.type);
+		}
+		if (done) {
+			vehicle.current++;
+			vehicle.stepStart = _now;
+			ROS_INFO("mission: %s %s", vehicle.name.c_str(),
+					vehicle.current < vehicle.steps.size() ? "next step" : "done");
+		}
+		// by reference, the message is serialized here and can be refilled next step
+		if (vehicle.lockstep) {
+			vehicle.stampedControl.header.stamp = _now + commandLead;
+			vehicle.stampedControl.twist = vehicle.control;
+			vehicle.controlPub.publish(vehicle.stampedControl);
+		} else {
+			vehicle.controlPub.publish(vehicle.control);
+		}
+	}
+}
+
+bool MissionExecutor::irisControl(Vehicle& _vehicle, const MissionStep& _step, const geometry_msgs::Pose& _pose,
+		double _speedX, double _speedY) {
+	geometry_msgs::Twist& control = _vehicle.control;
+	const double targetX = _step.hasXY ? _step.x : _vehicle.originX;
+	const double targetY = _step.hasXY ? _step.y : _vehicle.originY;
+	const double err = _step.z - _pose.position.z;
+	double xoffset = targetX - _pose.position.x;
+	double yoffset = targetY - _pose.position.y;
+
+	const double distance = std::sqrt(xoffset * xoffset + yoffset * yoffset + err * err);
+	const bool done = _step.action == MissionStep::TAKEOFF ? std::abs(err) < IRIS_SETTLED : distance < _step.radius;
+	if (_vehicle.onboardHold) {
+		// the plugin closes the loops, it only needs the position
+		control.linear.x = targetX;
+		control.linear.y = targetY;
+		control.linear.z = _step.z;
+		control.angular.x = control.angular.y = control.angular.z = 0;
+		return done;
+	}
+
+	control.linear.x = 0;
+	control.linear.z = clamp(IRIS_BASE_THROTTLE + err * IRIS_ALTITUDE_GAIN, IRIS_MAX_THROTTLE);
+	control.angular.x = 0;
+	control.angular.y = 0;
+	if (std::abs(err) < IRIS_HOLD_ALTITUDE) {
+		// close in, the speed damps the approach
+		if (std::abs(xoffset) < IRIS_BRAKE_DISTANCE && std::abs(_speedX) > 0.001) {
+			xoffset = _speedX * 1000;
+		}
+		if (std::abs(yoffset) < IRIS_BRAKE_DISTANCE && std::abs(_speedY) > 0.001) {
+			yoffset = _speedY * 1000;
+		}
+		control.angular.x = clamp(-yoffset * IRIS_TILT_GAIN, IRIS_MAX_TILT);
+		control.angular.y = clamp(xoffset * IRIS_TILT_GAIN, IRIS_MAX_TILT);
+	}
+	return done;
+}
+
+bool MissionExecutor::zephyrControl(Vehicle& _vehicle, const MissionStep& _step, const geometry_msgs::Pose& _pose) {
+	geometry_msgs::Twist& control = _vehicle.control;
+	control.linear.x = ZEPHYR_THROTTLE;
+	control.linear.z = 0;
+	control.angular.y = _pose.position.z < _step.z ? ZEPHYR_CLIMB_PITCH : 0.0;
+	control.angular.x = _step.action == MissionStep::LOITER ? ZEPHYR_LOITER_BANK : 0.0;
+	return _pose.position.z > _step.z;
+}
+
+size_t MissionExecutor::vehicleCount() const {
+	return vehicles.size();
+}
+
+size_t MissionExecutor::finishedCount() const {
+	size_t finished = 0;
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		finished += vehicles[i]->current >= vehicles[i]->steps.size() ? 1 : 0;
+	}
+	return finished;
+}
@@ -0,0 +1,52 @@
+#include <uav_ground_control/mission_executor.h>
+#include <algorithm>
+
+// Flies the missions of ~vehicles, see MissionExecutor::load and
+// config/takeoff_mission.yaml, in place of scripts/takeoff.py
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "mission_executor");
+  ros::NodeHandle n;
+  ros::NodeHandle private_node_handle_("~");
+
+  int rate;
+  int spinnerThreads;
+  XmlRpc::XmlRpcValue vehicles;
+  private_node_handle_.param("rate", rate, int(100));
+  private_node_handle_.param("spinner_threads", spinnerThreads, int(2));
+  if (!private_node_handle_.getParam("vehicles", vehicles)) {
+	  ROS_ERROR("mission: no ~vehicles");
+	  return 1;
+  }
+
+  // motor temperatures of the vehicles with a telemetry topic, see uav_ground_control_node
+  double motorTempSoft, motorTempHard, motorMinThrottle;
+  private_node_handle_.param("motor_temp_soft", motorTempSoft, 80.0);
+  private_node_handle_.param("motor_temp_hard", motorTempHard, 100.0);
+  private_node_handle_.param("motor_min_throttle", motorMinThrottle, 0.5);
+
+  // sim seconds between a step and the physics step its lockstep controls are stamped for
+  double commandLead;
+  private_node_handle_.param("command_lead", commandLead, 0.01);
+
+  MissionExecutor executor(n);
+  executor.setThermalLimits(motorTempSoft, motorTempHard, motorMinThrottle);
+  executor.setCommandLead(commandLead);
+  if (!executor.load(vehicles)) {
+	  return 1;
+  }
+  ROS_INFO("mission: %zu vehicles at %d Hz", executor.vehicleCount(), rate);
+
+  // poses are stored as they arrive, the controls go out at the rate below
+  ros::AsyncSpinner spinner(std::max(spinnerThreads, 1));
+  spinner.start();
+
+  ros::Rate r(rate);
+  while (n.ok())
+  {
+	  executor.step(ros::Time::now());
+	  r.sleep();
+  }
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include <uav_ground_control/telemetry_link.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+bool baudRate(int _baud, speed_t& _speed) {
+	switch (_baud) {
+	case 9600: _speed = B9600; return true;
+	case 19200: _speed = B19200; return true;
+	case 38400: _speed = B38400; return true;
+	case 57600: _speed = B57600; return true;
+	case 115200: _speed = B115200; return true;
+	case 230400: _speed = B230400; return true;
+	case 460800: _speed = B460800; return true;
+	case 921600: _speed = B921600; return true;
+	default: return false;
+	}
+}
+
+}
+
+TelemetryLink::TelemetryLink(ThermalLimiter& _limiter) : limiter(_limiter), serialFd(-1), running(false) {
+	telemetry_decoder_init(&topicDecoder);
+	telemetry_decoder_init(&serialDecoder);
+}
+
+TelemetryLink::~TelemetryLink() {
+	close();
+}
+
+void TelemetryLink::subscribe(ros::NodeHandle& _node, const std::string& _topic) {
+	telemetrySub = _node.subscribe(_topic, 100, &TelemetryLink::telemetryCallback, this);
+}
+
+bool TelemetryLink::openSerial(const std::string& _port, int _baud) {
+	speed_t speed;
+	if (!baudRate(_baud, speed)) {
+		ROS_ERROR("telemetry: unsupported baud rate %d", _baud);
+		return false;
+	}
+	serialFd = ::open(_port.c_str(), O_RDONLY | O_NOCTTY);
+	if (serialFd < 0) {
+		ROS_ERROR("telemetry: cannot open %s", _port.c_str());
+		return false;
+	}
+	termios tty;
+	if (tcgetattr(serialFd, &tty) != 0) {
+		ROS_ERROR("telemetry: %s is not a serial port", _port.c_str());
+		::close(serialFd);
+		serialFd = -1;
+		return false;
+	}
+	cfmakeraw(&tty);
+	cfsetispeed(&tty, speed);
+	cfsetospeed(&tty, speed);
+	tty.c_cflag |= CLOCAL | CREAD;
+	// reads return after 100 ms without data, so the thread sees close()
+	tty.c_cc[VMIN] = 0;
+	tty.c_cc[VTIME] = 1;
+	tcsetattr(serialFd, TCSANOW, &tty);
+	tcflush(serialFd, TCIFLUSH);
+
+	running = true;
+	serialReader = boost::thread(boost::bind(&TelemetryLink::serialThread, this));
+	return true;
+}
+
+void TelemetryLink::close() {
+	telemetrySub.shutdown();
+	running = false;
+	if (serialReader.joinable()) {
+		serialReader.join();
+	}
+	if (serialFd >= 0) {
+		::close(serialFd);
+		serialFd = -1;
+	}
+}
+
+void TelemetryLink::feed(telemetry_decoder& _decoder, const uint8_t* _data, size_t _size) {
+	const uint32_t errors = _decoder.crc_errors;
+	for (size_t i = 0; i < _size; i++) {
+		if (!telemetry_decoder_push(&_decoder, _data[i])) {
+			continue;
+		}
+		telemetry_temperatures temperatures;
+		if (telemetry_frame_type(_decoder.frame) == TELEMETRY_TEMPERATURE &&
+				telemetry_decode_temperatures(_decoder.frame, &temperatures)) {
+			limiter.update(temperatures);
+		}
+	}
+	if (_decoder.crc_errors != errors) {
+		ROS_WARN_THROTTLE(5, "telemetry: %u frames, %u with a bad crc, %u lost",
+				_decoder.frames, _decoder.crc_errors, _decoder.lost);
+	}
+}
+
+void TelemetryLink::telemetryCallback(const std_msgs::UInt8MultiArray::ConstPtr& _frames) {
+	feed(topicDecoder, _frames->data.data(), _frames->data.size());
+}
+
+void TelemetryLink::serialThread() {
+	uint8_t buffer[256];
+	while (running) {
+		const ssize_t count = ::read(serialFd, buffer, sizeof(buffer));
+		if (count < 0) {
+			ROS_ERROR("telemetry: serial port read failed");
+			break;
+		}
+		feed(serialDecoder, buffer, count);
+	}
+}
@@ -0,0 +1,53 @@
+#include <uav_ground_control/thermal_limiter.h>
+#include <algorithm>
+
+ThermalLimiter::ThermalLimiter() : softLimit(80), hardLimit(100), minScale(0.5), throttleScale(1),
+		hottestMotor(0) {
+
+}
+
+void ThermalLimiter::configure(double _softLimit, double _hardLimit, double _minScale) {
+	softLimit = _softLimit;
+	hardLimit = std::max(_hardLimit, _softLimit);
+	minScale = std::min(std::max(_minScale, 0.0), 1.0);
+}
+
+void ThermalLimiter::update(const telemetry_temperatures& _temperatures) {
+	if (_temperatures.rows == 0) {
+		return;
+	}
+	const uint8_t row = _temperatures.rows - 1;
+	int16_t hottest = TELEMETRY_TEMPERATURE_INVALID;
+	for (uint8_t i = 0; i < _temperatures.sensors; i++) {
+		hottest = std::max(hottest, telemetry_temperature(&_temperatures, row, i));
+	}
+	if (hottest == TELEMETRY_TEMPERATURE_INVALID) {
+		return;
+	}
+
+	const double celsius = hottest / 16.0;
+	double scale = 1;
+	if (celsius >= hardLimit) {
+		scale = minScale;
+	} else if (celsius > softLimit) {
+		scale = 1 - (1 - minScale) * (celsius - softLimit) / (hardLimit - softLimit);
+	}
+	hottestMotor.store(celsius);
+	throttleScale.store(scale);
+}
+
+double ThermalLimiter::scale() const {
+	return throttleScale.load();
+}
+
+void ThermalLimiter::limit(geometry_msgs::Twist& _control, VehicleType _type) const {
+	if (_type == IRIS) {
+		_control.linear.z *= scale();
+	} else {
+		_control.linear.x *= scale();
+	}
+}
+
+double ThermalLimiter::hottest() const {
+	return hottestMotor.load();
+}
@@ -3,25 +3,128 @@
 #include <geometry_msgs/Pose.h>
 #include <tf/LinearMath/Matrix3x3.h>
 #include <tf/LinearMath/Quaternion.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
 
-UavGroundControl::UavGroundControl(ros::NodeHandle& _node):node(_node) {
+UavGroundControl::UavGroundControl(ros::NodeHandle& _node):node(_node), softLimit(80), hardLimit(100),
+		minScale(0.5) {
 
 }
 
 UavGroundControl::~UavGroundControl() {
-
+	stop();
 }
 
 void UavGroundControl::spinOnce() {
 
 }
 
-void UavGroundControl::init(std::string controlTopicName, std::string poseTopicName) {
-	controlPubs.push_back(node.advertise<geometry_msgs::Twist>(controlTopicName.c_str(), 10));
-	poseSubs.push_back(node.subscribe(poseTopicName.c_str(), 10, &UavGroundControl::poseCallback, this));
+void UavGroundControl::init(std::string controlTopicName, std::string poseTopicName, VehicleType type) {
+	insertVehicle(poseTopicName, controlTopicName, poseTopicName, type);
+}
+
+void UavGroundControl::addVehicle(const std::string& name, VehicleType type) {
+	insertVehicle(name, name + "_control", name + "_pose", type);
+}
+
+void UavGroundControl::insertVehicle(const std::string& name, const std::string& controlTopicName,
+		const std::string& poseTopicName, VehicleType type) {
+	if (!spinners.empty()) {
+		ROS_WARN("ground control: vehicle on %s added after start, it is not controlled", poseTopicName.c_str());
+		return;
+	}
+	boost::shared_ptr<Vehicle> vehicle(new Vehicle());
+	vehicle->name = name;
+	vehicle->type = type;
+	vehicle->poseTopicName = poseTopicName;
+	vehicle->thermal.reset(new ThermalLimiter());
+	vehicle->thermal->configure(softLimit, hardLimit, minScale);
+	vehicle->controlPub = node.advertise<geometry_msgs::Twist>(controlTopicName, 10);
+	vehicles.push_back(vehicle);
+}
+
+void UavGroundControl::start(unsigned threads) {
+	if (!spinners.empty() || vehicles.empty()) {
+		return;
+	}
+	if (threads == 0) {
+		threads = std::min<size_t>(vehicles.size(), std::max(1u, boost::thread::hardware_concurrency()));
+	}
+	threads = std::min<size_t>(threads, vehicles.size());
+
+	for (unsigned i = 0; i < threads; i++) {
+		queues.push_back(boost::shared_ptr<ros::CallbackQueue>(new ros::CallbackQueue()));
+	}
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		Vehicle* vehicle = vehicles[i].get();
+		ros::SubscribeOptions so = ros::SubscribeOptions::create<geometry_msgs::Pose>(
+				vehicle->poseTopicName, 10,
+				boost::bind(&UavGroundControl::poseCallback, this, _1, vehicle),
+				ros::VoidPtr(), queues[i % threads].get());
+		// poses are handled right away, waiting for more only adds latency
+		so.transport_hints = ros::TransportHints().tcpNoDelay();
+		vehicle->poseSub = node.subscribe(so);
+	}
+	for (unsigned i = 0; i < threads; i++) {
+		spinners.push_back(boost::shared_ptr<ros::AsyncSpinner>(new ros::AsyncSpinner(1, queues[i].get())));
+		spinners.back()->start();
+	}
+	ROS_INFO("ground control: %zu vehicles on %u threads", vehicles.size(), threads);
+}
+
+void UavGroundControl::stop() {
+	for (size_t i = 0; i < spinners.size(); i++) {
+		spinners[i]->stop();
+	}
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		vehicles[i]->poseSub.shutdown();
+	}
+	spinners.clear();
+	queues.clear();
 }
 
-void UavGroundControl::poseCallback(const geometry_msgs::Pose::ConstPtr& pose) {
+size_t UavGroundControl::vehicleCount() const {
+	return vehicles.size();
+}
+
+void UavGroundControl::setThermalLimits(double _softLimit, double _hardLimit, double _minScale) {
+	softLimit = _softLimit;
+	hardLimit = _hardLimit;
+	minScale = _minScale;
+	for (size_t i = 0; i < vehicles.size(); i++) {
+		vehicles[i]->thermal->configure(softLimit, hardLimit, minScale);
+	}
+}
+
+bool UavGroundControl::initTelemetry(const std::string& vehicleName, std::string telemetryTopicName,
+		std::string serialPort, int baud) {
+	Vehicle* vehicle = nullptr;
+	for (size_t i = 0; i < vehicles.size() && !vehicle; i++) {
+		if (vehicles[i]->name == vehicleName) {
+			vehicle = vehicles[i].get();
+		}
+	}
+	if (!vehicle) {
+		ROS_ERROR("ground control: telemetry of an unknown vehicle %s", vehicleName.c_str());
+		return false;
+	}
+	if (telemetryTopicName.empty() && serialPort.empty()) {
+		return true;
+	}
+	if (!vehicle->telemetry) {
+		vehicle->telemetry.reset(new TelemetryLink(*vehicle->thermal));
+	}
+	if (!telemetryTopicName.empty()) {
+		vehicle->telemetry->subscribe(node, telemetryTopicName);
+	}
+	if (!serialPort.empty()) {
+		vehicle->telemetry->openSerial(serialPort, baud);
+	}
+	return true;
+}
+
+void UavGroundControl::poseCallback(const geometry_msgs::Pose::ConstPtr& pose, Vehicle* vehicle) {
 	//tf::Quaternion orientation(pose->pose.pose.orientation.x, pose->pose.pose.orientation.y,
 	//		pose->pose.pose.orientation.z, pose->pose.pose.orientation.w);
 	//tf::Matrix3x3 quatMat(orientation);
@@ -43,50 +146,19 @@ void UavGroundControl::poseCallback(const geometry_msgs::Pose::ConstPtr& pose) {
 
 //	const double propeller_speed = 400.0f;
 
-	geometry_msgs::Twist control;
-	control.linear.x = 400;
-	
-	control.angular.y = -0.05;
-	control.angular.x = 0.0;
-
-	controlPubs[0].publish(control);
+	// published as a shared pointer, a subscriber in the same process
+	// (the controller plugins when this runs inside gzserver) gets this
+	// very message without serialization, so it must not be changed after publish
+	geometry_msgs::TwistPtr control(new geometry_msgs::Twist());
+	if (vehicle->type == IRIS) {
+		// level hover, the iris reads its throttle from linear.z
+		control->linear.z = 430;
+	} else {
+		control->linear.x = 400;
+		control->angular.y = -0.05;
+		control->angular.x = 0.0;
+	}
+	vehicle->thermal->limit(*control, vehicle->type);
+
+	vehicle->controlPub.publish(control);
 }
-
-int main(int argc, char **argv)
-{
-  // Set up ROS.
-  ros::init(argc, argv, "uav_ground_control");
-  ros::NodeHandle n;
-
-  int rate;
-  std::string controlTopicName;
-  std::string poseTopicName;
-
-  // Initialize node parameters from launch file or command line.
-  // Use a private node handle so that multiple instances of the node can
-  // be run simultaneously while using different parameters.
-  // Parameters defined in the .cfg file do not need to be initialized here
-  // as the dynamic_reconfigure::Server does this for you.
-  ros::NodeHandle private_node_handle_("~");
-  private_node_handle_.param("rate", rate, int(10));
-  private_node_handle_.param("control_topic", controlTopicName, std::string("zephyr_control"));
-  private_node_handle_.param("pose_topic", poseTopicName, std::string("zephyr_pose"));
-
-  UavGroundControl uavControl(n);
-
-  // create publishers and subscribers
-  uavControl.init(controlTopicName, poseTopicName);
-
-  // Tell ROS how fast to run this node.
-  ros::Rate r(rate);
-
-  // Main loop.
-  while (n.ok())
-  {
-	  uavControl.spinOnce();
-	  ros::spinOnce();
-	  r.sleep();
-  }
-
-  return 0;
-} // end main()
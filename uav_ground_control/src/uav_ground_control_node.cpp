@@ -0,0 +1,104 @@
+#include <uav_ground_control/uav_ground_control.h>
+#include <XmlRpcValue.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+  // Set up ROS.
+  ros::init(argc, argv, "uav_ground_control");
+  ros::NodeHandle n;
+
+  int rate;
+  int spinnerThreads;
+  XmlRpc::XmlRpcValue vehicles;
+  std::string controlTopicName;
+  std::string poseTopicName;
+  std::string vehicleTypeName;
+  std::string telemetryTopicName;
+  std::string telemetryPort;
+  int telemetryBaud;
+  double motorTempSoft, motorTempHard, motorMinThrottle;
+
+  // Initialize node parameters from launch file or command line.
+  // Use a private node handle so that multiple instances of the node can
+  // be run simultaneously while using different parameters.
+  // Parameters defined in the .cfg file do not need to be initialized here
+  // as the dynamic_reconfigure::Server does this for you.
+  ros::NodeHandle private_node_handle_("~");
+  private_node_handle_.param("rate", rate, int(10));
+  private_node_handle_.param("control_topic", controlTopicName, std::string("zephyr_control"));
+  private_node_handle_.param("pose_topic", poseTopicName, std::string("zephyr_pose"));
+  private_node_handle_.param("vehicle_type", vehicleTypeName, std::string("zephyr"));
+  // e.g. [{name: zephyr0, type: zephyr}, {name: iris0, type: iris, telemetry: iris0_telemetry}],
+  // each on <name>_control and <name>_pose instead of the two topics above,
+  // telemetry_port and telemetry_baud read its motors from a serial port.
+  // Poses are answered on spinner_threads threads, 0 for one per vehicle up
+  // to one per core.
+  private_node_handle_.getParam("vehicles", vehicles);
+  private_node_handle_.param("spinner_threads", spinnerThreads, int(0));
+  // motor temperatures of the vehicle on the two topics above, the frames
+  // of the motor_temperature_sensor model on a topic and/or of the MCU on a
+  // serial port
+  private_node_handle_.param("telemetry_topic", telemetryTopicName, std::string(""));
+  private_node_handle_.param("telemetry_port", telemetryPort, std::string(""));
+  private_node_handle_.param("telemetry_baud", telemetryBaud, int(115200));
+  private_node_handle_.param("motor_temp_soft", motorTempSoft, 80.0);
+  private_node_handle_.param("motor_temp_hard", motorTempHard, 100.0);
+  private_node_handle_.param("motor_min_throttle", motorMinThrottle, 0.5);
+
+  UavGroundControl uavControl(n);
+
+  // create publishers and subscribers
+  uavControl.setThermalLimits(motorTempSoft, motorTempHard, motorMinThrottle);
+  if (vehicles.getType() != XmlRpc::XmlRpcValue::TypeArray || vehicles.size() == 0) {
+	  VehicleType type;
+	  if (!vehicleTypeFromString(vehicleTypeName, type)) {
+		  ROS_ERROR("ground control: vehicle_type %s is neither iris nor zephyr", vehicleTypeName.c_str());
+		  return 1;
+	  }
+	  uavControl.init(controlTopicName, poseTopicName, type);
+	  uavControl.initTelemetry(poseTopicName, telemetryTopicName, telemetryPort, telemetryBaud);
+  }
+  for (int i = 0; vehicles.getType() == XmlRpc::XmlRpcValue::TypeArray && i < vehicles.size(); i++) {
+	  XmlRpc::XmlRpcValue& entry = vehicles[i];
+	  VehicleType type;
+	  if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("name") ||
+			  entry["name"].getType() != XmlRpc::XmlRpcValue::TypeString || !entry.hasMember("type") ||
+			  entry["type"].getType() != XmlRpc::XmlRpcValue::TypeString ||
+			  !vehicleTypeFromString(static_cast<std::string>(entry["type"]), type)) {
+		  ROS_ERROR("ground control: vehicle %d needs a name and a type iris or zephyr", i);
+		  return 1;
+	  }
+	  const std::string name = static_cast<std::string>(entry["name"]);
+	  std::string vehicleTelemetryTopic, vehicleTelemetryPort;
+	  int vehicleTelemetryBaud = telemetryBaud;
+	  if (entry.hasMember("telemetry") && entry["telemetry"].getType() == XmlRpc::XmlRpcValue::TypeString) {
+		  vehicleTelemetryTopic = static_cast<std::string>(entry["telemetry"]);
+	  }
+	  if (entry.hasMember("telemetry_port") && entry["telemetry_port"].getType() == XmlRpc::XmlRpcValue::TypeString) {
+		  vehicleTelemetryPort = static_cast<std::string>(entry["telemetry_port"]);
+	  }
+	  if (entry.hasMember("telemetry_baud") && entry["telemetry_baud"].getType() == XmlRpc::XmlRpcValue::TypeInt) {
+		  vehicleTelemetryBaud = static_cast<int>(entry["telemetry_baud"]);
+	  }
+	  uavControl.addVehicle(name, type);
+	  uavControl.initTelemetry(name, vehicleTelemetryTopic, vehicleTelemetryPort, vehicleTelemetryBaud);
+  }
+  uavControl.start(std::max(spinnerThreads, 0));
+
+  // Tell ROS how fast to run this node, poses are answered by the spinner
+  // threads as they arrive, the rest of the callbacks here
+  ros::Rate r(rate);
+
+  // Main loop.
+  while (n.ok())
+  {
+	  uavControl.spinOnce();
+	  ros::spinOnce();
+	  r.sleep();
+  }
+
+  return 0;
+} // end main()
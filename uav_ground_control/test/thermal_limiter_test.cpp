@@ -0,0 +1,66 @@
+#include <uav_ground_control/thermal_limiter.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+/// \brief a frame with _celsius on the hottest of four motors, one of them failed
+void feed(ThermalLimiter& _limiter, double _celsius) {
+	const int16_t values[4] = {40 * 16, static_cast<int16_t>(_celsius * 16), 40 * 16,
+			TELEMETRY_TEMPERATURE_INVALID};
+	uint8_t frame[TELEMETRY_MAX_FRAME];
+	ASSERT_GT(telemetry_encode_temperatures(frame, 0, 1000, 250, 4, 1, values), 0);
+	telemetry_temperatures temperatures;
+	ASSERT_TRUE(telemetry_decode_temperatures(frame, &temperatures));
+	_limiter.update(temperatures);
+}
+
+geometry_msgs::Twist irisHover() {
+	geometry_msgs::Twist control;
+	control.linear.z = 430;
+	control.angular.x = 0.02;
+	control.angular.y = -0.03;
+	return control;
+}
+
+}
+
+TEST(ThermalLimiter, HotIrisMotorsReduceTheThrottle) {
+	ThermalLimiter limiter;
+	limiter.configure(80, 100, 0.5);
+	feed(limiter, 90);
+	EXPECT_DOUBLE_EQ(0.75, limiter.scale());
+
+	geometry_msgs::Twist control = irisHover();
+	limiter.limit(control, IRIS);
+	EXPECT_DOUBLE_EQ(322.5, control.linear.z);
+	// the attitude stays, the iris only climbs slower
+	EXPECT_DOUBLE_EQ(0, control.linear.x);
+	EXPECT_DOUBLE_EQ(0.02, control.angular.x);
+	EXPECT_DOUBLE_EQ(-0.03, control.angular.y);
+}
+
+TEST(ThermalLimiter, ZephyrThrottleIsLinearX) {
+	ThermalLimiter limiter;
+	limiter.configure(80, 100, 0.5);
+	feed(limiter, 120);
+
+	geometry_msgs::Twist control;
+	control.linear.x = 400;
+	control.angular.y = -0.05;
+	limiter.limit(control, ZEPHYR);
+	EXPECT_DOUBLE_EQ(200, control.linear.x);
+	EXPECT_DOUBLE_EQ(0, control.linear.z);
+	EXPECT_DOUBLE_EQ(-0.05, control.angular.y);
+}
+
+TEST(ThermalLimiter, ColdMotorsKeepTheThrottle) {
+	ThermalLimiter limiter;
+	limiter.configure(80, 100, 0.5);
+	geometry_msgs::Twist control = irisHover();
+	limiter.limit(control, IRIS);
+	EXPECT_DOUBLE_EQ(430, control.linear.z);
+
+	feed(limiter, 60);
+	limiter.limit(control, IRIS);
+	EXPECT_DOUBLE_EQ(430, control.linear.z);
+}